@@ -17,6 +17,7 @@
  */
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 
 #include "alphabetparameters.h"
@@ -36,23 +37,29 @@ Bag::Bag()
 
 Bag::Bag(const LetterString &contents)
 {
+	clear();
 	toss(contents);
 }
 
 void Bag::clear()
 {
 	m_tiles.clear();
+	memset(m_counts, 0, sizeof(m_counts));
 }
 
 void Bag::prepareFullBag()
 {
 	// put stuff in here to fill the bag
-	m_tiles.clear();
+	clear();
 
 	// we start at 0 because we want to include blanks etcetera
 	for (Letter letter = 0; letter <= QUACKLE_ALPHABET_PARAMETERS->lastLetter(); ++letter)
+	{
 		for (int i = 0; i < QUACKLE_ALPHABET_PARAMETERS->count(letter); ++i)
 			m_tiles.push_back(letter);
+
+		m_counts[(int)letter] = QUACKLE_ALPHABET_PARAMETERS->count(letter);
+	}
 }
 
 int Bag::fullBagTileCount()
@@ -68,24 +75,29 @@ void Bag::toss(const LetterString &letters)
 {
 	const LetterString::const_iterator end(letters.end());
 	for (LetterString::const_iterator it = letters.begin(); it != end; ++it)
+	{
 		m_tiles.push_back(*it);
+		++m_counts[(int)*it];
+	}
 }
 
 void Bag::toss(const LongLetterString &letters)
 {
 	const LongLetterString::const_iterator end(letters.end());
 	for (LongLetterString::const_iterator it = letters.begin(); it != end; ++it)
+	{
 		m_tiles.push_back(*it);
+		++m_counts[(int)*it];
+	}
 }
 
 Letter Bag::erase(int pos)
 {
-	LongLetterString::iterator it = m_tiles.begin();
-
-	for (int i = 0; i < pos; ++it, ++i) ;
+	Letter ret = m_tiles[pos];
 
-	Letter ret = *it;
-	m_tiles.erase(it);
+	m_tiles[pos] = m_tiles[m_tiles.size() - 1];
+	m_tiles.pop_back();
+	--m_counts[(int)ret];
 
 	return ret;
 }
@@ -130,63 +142,74 @@ bool Bag::removeLetters(const LongLetterString &letters)
 
 void Bag::letterCounts(char *countsArray) const
 {
-	String::counts(m_tiles, countsArray);
+	for (int j = 0; j < QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE; j++)
+		countsArray[j] = m_counts[j];
 }
 
 bool Bag::removeLetter(Letter letter)
 {
-	LongLetterString::iterator it;
-	const LongLetterString::iterator end(m_tiles.end());
-	for (it = m_tiles.begin(); it != end; ++it)
-		if (*it == letter)
-			break;
-
-	if (it == m_tiles.end())
+	if (m_counts[(int)letter] <= 0)
 		return false;
 
-	m_tiles.erase(it);
+	erase(m_tiles.rfind(letter));
 	return true;
 }
 
 void Bag::refill(Rack &rack)
 {
+	LetterString drawn;
+
 	for (int number = QUACKLE_PARAMETERS->rackSize() - rack.tiles().length(); number > 0 && !m_tiles.empty(); --number)
-		rack.setTiles(String::alphabetize(rack.tiles() + pluck()));
+		drawn += pluck();
+
+	if (!drawn.empty())
+		rack.setTiles(String::alphabetize(rack.tiles() + drawn));
 }
 
 LetterString Bag::refill(Rack &rack, const LetterString &drawingOrder)
 {
 	LetterString ret(drawingOrder);
+	LetterString drawn;
 
 	for (int number = QUACKLE_PARAMETERS->rackSize() - rack.tiles().length(); number > 0 && !m_tiles.empty(); --number)
 	{
 		if (drawingOrder.empty())
-			rack.setTiles(String::alphabetize(rack.tiles() + pluck()));
+			drawn += pluck();
 		else
 		{
 			removeLetter(String::back(ret));
-			rack.setTiles(String::alphabetize(rack.tiles() + String::back(ret)));
+			drawn += String::back(ret);
 			String::pop_back(ret);
 		}
 	}
 
+	if (!drawn.empty())
+		rack.setTiles(String::alphabetize(rack.tiles() + drawn));
+
 	return ret;
 }
 
 LongLetterString Bag::shuffledTiles() const
 {
 	LongLetterString ret(m_tiles);
-	random_shuffle(ret.begin(), ret.end());
+	for (int i = ret.size() - 1; i > 0; --i)
+		swap(ret[i], ret[DataManager::self()->randomNumber() % (i + 1)]);
 	return ret;
 }
 
 LetterString Bag::someShuffledTiles() const
 {
-	LongLetterString shuffled(shuffledTiles());
+	// only as much of a Fisher-Yates shuffle as there are tiles wanted
+	LongLetterString shuffled(m_tiles);
+	const int size = shuffled.size();
+	const int wanted = min(size, LETTER_STRING_MAXIMUM_LENGTH - 1);
+
 	LetterString ret;
-	int i = 0;
-	for (LongLetterString::const_iterator it = shuffled.begin(); it != shuffled.end() && i < LETTER_STRING_MAXIMUM_LENGTH - 1; ++it, ++i)
-		ret.push_back(*it);
+	for (int i = 0; i < wanted; ++i)
+	{
+		swap(shuffled[i], shuffled[i + DataManager::self()->randomNumber() % (size - i)]);
+		ret.push_back(shuffled[i]);
+	}
 
 	return ret;
 }
@@ -254,9 +277,6 @@ double Bag::probabilityOfDrawingFromFullBag(const LetterString &letters)
 
 double Bag::probabilityOfDrawingFromBag(const LetterString &letters, const Bag &bag)
 {
-	char bagCounts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
-	String::counts(bag.tiles(), bagCounts);
-
 	char counts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
 	String::counts(String::clearBlankness(letters), counts);
 
@@ -264,7 +284,7 @@ double Bag::probabilityOfDrawingFromBag(const LetterString &letters, const Bag &
 
 	for (Letter letter = 0; letter < QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE; ++letter)
 		if (counts[(int)letter] > 0)
-			ret *= nCr(bagCounts[(int)letter], counts[(int)letter]);
+			ret *= nCr(bag.m_counts[(int)letter], counts[(int)letter]);
 
 	return ret;
 }
@@ -279,12 +299,9 @@ UVString Bag::toString() const
 {
 	UVString ret;
 
-	LongLetterString sortedLetters = m_tiles;
-	sort(sortedLetters.begin(), sortedLetters.end());
-
-	const LongLetterString::const_iterator end(sortedLetters.end());
-	for (LongLetterString::const_iterator it = sortedLetters.begin(); it != end; ++it)
-		ret += QUACKLE_ALPHABET_PARAMETERS->userVisible(*it);
+	for (int letter = 0; letter < QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE; ++letter)
+		for (int i = 0; i < m_counts[letter]; ++i)
+			ret += QUACKLE_ALPHABET_PARAMETERS->userVisible(letter);
 
 	return ret;
 }
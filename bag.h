@@ -29,6 +29,9 @@ namespace Quackle
 
 class Move;
 
+// The tiles of a bag, in no particular order, along with how many of
+// each letter there are. A tile is taken out by moving the last tile
+// into its place, so drawing is a step of a Fisher-Yates shuffle.
 class Bag
 {
 public:
@@ -53,6 +56,7 @@ public:
 
 	// how many of each letter are in the bag
 	void letterCounts(char *countsArray) const;
+	int count(Letter letter) const;
 
 	// put letters back in the bag
 	void toss(const LetterString &letters);
@@ -101,6 +105,7 @@ private:
 	Letter erase(int pos);
 
 	LongLetterString m_tiles;
+	int m_counts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
 };
 
 inline void Bag::toss(const Rack &rack)
@@ -123,6 +128,11 @@ inline const LongLetterString &Bag::tiles() const
 	return m_tiles;
 }
 
+inline int Bag::count(Letter letter) const
+{
+	return m_counts[(int)letter];
+}
+
 }
 
 UVOStream &operator<<(UVOStream &o, const Quackle::Bag &bag);
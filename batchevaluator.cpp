@@ -0,0 +1,207 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <iostream>
+
+#include "batchevaluator.h"
+#include "datamanager.h"
+#include "gameparameters.h"
+#include "generator.h"
+#include "lexiconparameters.h"
+
+// #define DEBUG_BATCHEVALUATOR
+
+using namespace std;
+using namespace Quackle;
+
+BatchEvaluator::BatchEvaluator(int numberOfThreads)
+	: m_batchNumber(0), m_busyWorkers(0), m_shuttingDown(false), m_defaultDataManager(0), m_positions(0), m_results(0), m_nmoves(0), m_nextPosition(0)
+{
+	PlayerList players;
+	players.push_back(Player(MARK_UV("Batch"), Player::ComputerPlayerType, 0));
+	players.push_back(Player(MARK_UV("Opponent"), Player::ComputerPlayerType, 1));
+
+	// turn the position so it has a current player that survives copying
+	m_prototype = GamePosition(players);
+	m_prototype.incrementTurn();
+
+	if (numberOfThreads <= 0)
+		numberOfThreads = max(1u, thread::hardware_concurrency());
+
+	for (int i = 0; i < numberOfThreads; ++i)
+		m_threads.push_back(thread(&BatchEvaluator::workerLoop, this));
+}
+
+BatchEvaluator::~BatchEvaluator()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_shuttingDown = true;
+	}
+	m_batchReady.notify_all();
+
+	for (auto &it : m_threads)
+		it.join();
+}
+
+void BatchEvaluator::addDataManager(DataManager *dataManager)
+{
+	m_dataManagers.push_back(dataManager);
+}
+
+MoveListList BatchEvaluator::evaluate(const BatchPositionList &positions, int nmoves)
+{
+	MoveListList ret(positions.size());
+	if (positions.empty())
+		return ret;
+
+	unique_lock<mutex> lock(m_mutex);
+	m_defaultDataManager = QUACKLE_DATAMANAGER;
+	m_positions = &positions;
+	m_results = &ret;
+	m_nmoves = nmoves;
+	m_nextPosition = 0;
+	m_busyWorkers = m_threads.size();
+	++m_batchNumber;
+	m_batchReady.notify_all();
+
+	m_batchDone.wait(lock, [this] { return m_busyWorkers == 0; });
+	m_defaultDataManager = 0;
+	m_positions = 0;
+	m_results = 0;
+
+	return ret;
+}
+
+MoveList BatchEvaluator::evaluate(const BatchPosition &position, int nmoves)
+{
+	MoveList ret;
+
+	DataManager *dataManager = dataManagerFor(position, QUACKLE_DATAMANAGER);
+	if (!dataManager)
+		return ret;
+
+	DataManagerScope scope(dataManager);
+	Generator generator;
+	GamePosition scratch(m_prototype);
+	evaluatePosition(position, nmoves, generator, scratch, &ret);
+	return ret;
+}
+
+void BatchEvaluator::workerLoop()
+{
+	// scratch state that lives as long as the worker
+	Generator generator;
+	GamePosition scratch(m_prototype);
+
+	unsigned int lastBatch = 0;
+	unique_lock<mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_batchReady.wait(lock, [this, lastBatch] { return m_shuttingDown || m_batchNumber != lastBatch; });
+		if (m_shuttingDown)
+			return;
+
+		lastBatch = m_batchNumber;
+
+		lock.unlock();
+		evaluateBatch(generator, scratch);
+		lock.lock();
+
+		if (--m_busyWorkers == 0)
+			m_batchDone.notify_all();
+	}
+}
+
+void BatchEvaluator::evaluateBatch(Generator &generator, GamePosition &scratch)
+{
+	const size_t size = m_positions->size();
+	for (size_t index = m_nextPosition++; index < size; index = m_nextPosition++)
+	{
+		const BatchPosition &input = (*m_positions)[index];
+
+		DataManager *dataManager = dataManagerFor(input, m_defaultDataManager);
+		bool evaluated = false;
+		if (dataManager)
+		{
+			DataManagerScope scope(dataManager);
+			evaluated = evaluatePosition(input, m_nmoves, generator, scratch, &(*m_results)[index]);
+		}
+
+		if (!evaluated)
+		{
+#ifdef DEBUG_BATCHEVALUATOR
+			UVcerr << "BatchEvaluator: could not evaluate position " << index << endl;
+#endif
+		}
+	}
+}
+
+DataManager *BatchEvaluator::dataManagerFor(const BatchPosition &input, DataManager *defaultDataManager) const
+{
+	if (input.lexicon.empty() || input.lexicon == defaultDataManager->lexiconParameters()->lexiconName())
+		return defaultDataManager;
+
+	for (const auto &it : m_dataManagers)
+		if (it->lexiconParameters()->lexiconName() == input.lexicon)
+			return it;
+
+	return 0;
+}
+
+bool BatchEvaluator::evaluatePosition(const BatchPosition &input, int nmoves, Generator &generator, GamePosition &scratch, MoveList *moves) const
+{
+	moves->clear();
+
+	Bag unseen(input.board.tilesNotOnBoard());
+	if (!unseen.removeLetters(input.rack.tiles()))
+		return false;
+
+	// Unseen tiles go to the opponent's rack first so that endgame
+	// evaluation sees the right deadwood when the bag is empty;
+	// the rest go in the bag.
+	const LongLetterString &unseenTiles = unseen.tiles();
+	const int unseenCount = unseenTiles.size();
+	const int bagSize = max(0, min(input.bagSize, unseenCount));
+	const int oppRackSize = min(QUACKLE_PARAMETERS->rackSize(), unseenCount - bagSize);
+
+	LetterString oppTiles;
+	for (int i = 0; i < oppRackSize; ++i)
+		oppTiles += unseenTiles[i];
+
+	Bag bag;
+	bag.clear();
+	bag.toss(unseenTiles.substr(oppRackSize, bagSize));
+
+	scratch.setBoard(input.board);
+	scratch.setBag(bag);
+	scratch.setCurrentPlayerRack(input.rack, false);
+	scratch.setPlayerRack(scratch.nextPlayer()->id(), Rack(oppTiles), false);
+
+	generator.setPosition(scratch);
+	generator.allCrosses();
+	generator.kibitz(nmoves, scratch.exchangeAllowed()? Generator::RegularKibitz : Generator::CannotExchange);
+
+	*moves = generator.kibitzList();
+	for (auto &it : *moves)
+		scratch.ensureMovePrettiness(it);
+
+	return true;
+}
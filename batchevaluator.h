@@ -0,0 +1,132 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_BATCHEVALUATOR_H
+#define QUACKLE_BATCHEVALUATOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "board.h"
+#include "game.h"
+#include "move.h"
+#include "rack.h"
+
+using namespace std;
+
+namespace Quackle
+{
+
+class DataManager;
+class Generator;
+
+// One position to be statically evaluated. The board need not be
+// prepared for analysis; crosses are computed by the evaluator.
+struct BatchPosition
+{
+	BatchPosition() : bagSize(0) {}
+	BatchPosition(const Board &_board, const Rack &_rack, int _bagSize, const string &_lexicon = string())
+		: board(_board), rack(_rack), bagSize(_bagSize), lexicon(_lexicon) {}
+
+	Board board;
+	Rack rack;
+
+	// number of unseen tiles still in the bag; decides whether
+	// exchanges are allowed and which equity heuristics apply
+	int bagSize;
+
+	// name of lexicon this position is to be evaluated in;
+	// an empty string means the lexicon of the data manager
+	// of the thread calling evaluate()
+	string lexicon;
+};
+
+typedef vector<BatchPosition> BatchPositionList;
+typedef vector<MoveList> MoveListList;
+
+// Kibitzes many unrelated positions at once on a pool of worker
+// threads. Each worker keeps its own Generator and scratch position
+// around between positions and batches.
+// Parameters in the data managers must not be changed while
+// evaluate() is running.
+class BatchEvaluator
+{
+public:
+	// numberOfThreads <= 0 means one thread per hardware thread
+	BatchEvaluator(int numberOfThreads = 0);
+	~BatchEvaluator();
+
+	int numberOfThreads() const;
+
+	// Positions naming the lexicon of this data manager are
+	// evaluated with it installed. The data manager is not owned.
+	void addDataManager(DataManager *dataManager);
+
+	// Returns, for each position in order, the nmoves best moves by
+	// static equity. A position that can't be evaluated (unknown lexicon,
+	// rack not among the unseen tiles) gets an empty move list.
+	MoveListList evaluate(const BatchPositionList &positions, int nmoves = 10);
+
+	// evaluate just one position on the calling thread
+	MoveList evaluate(const BatchPosition &position, int nmoves = 10);
+
+private:
+	void workerLoop();
+	void evaluateBatch(Generator &generator, GamePosition &scratch);
+
+	// returns the data manager to evaluate input in, or 0 if none fits
+	DataManager *dataManagerFor(const BatchPosition &input, DataManager *defaultDataManager) const;
+
+	bool evaluatePosition(const BatchPosition &input, int nmoves, Generator &generator, GamePosition &scratch, MoveList *moves) const;
+
+	// a position with a current player to be reused as scratch space
+	GamePosition m_prototype;
+
+	vector<DataManager *> m_dataManagers;
+
+	vector<thread> m_threads;
+
+	mutex m_mutex;
+	condition_variable m_batchReady;
+	condition_variable m_batchDone;
+
+	// increments every time a batch is handed out to workers
+	unsigned int m_batchNumber;
+	unsigned int m_busyWorkers;
+	bool m_shuttingDown;
+
+	// the batch being worked on
+	DataManager *m_defaultDataManager;
+	const BatchPositionList *m_positions;
+	MoveListList *m_results;
+	int m_nmoves;
+	atomic<size_t> m_nextPosition;
+};
+
+inline int BatchEvaluator::numberOfThreads() const
+{
+	return m_threads.size();
+}
+
+}
+
+#endif
@@ -0,0 +1,151 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "batchplayer.h"
+#include "computerplayer.h"
+#include "datamanager.h"
+
+using namespace Quackle;
+
+BatchPlayer::BatchPlayer(ComputerPlayer *firstPlayer, ComputerPlayer *secondPlayer, int numberOfThreads)
+	: m_numberOfThreads(numberOfThreads), m_keepHistories(false)
+{
+	m_players[0] = firstPlayer;
+	m_players[1] = secondPlayer? secondPlayer : firstPlayer;
+
+	if (m_numberOfThreads <= 0)
+		m_numberOfThreads = max(1, (int)thread::hardware_concurrency());
+}
+
+SelfPlayResultList BatchPlayer::playGames(int games)
+{
+	SelfPlayResultList ret(max(games, 0));
+
+	run(ret.size(), [this, &ret](int index, ComputerPlayer **players)
+	{
+		playGame(index, players, &ret[index]);
+	});
+
+	return ret;
+}
+
+MoveListList BatchPlayer::analyze(const PositionList &positions, int nmoves)
+{
+	MoveListList ret(positions.size());
+
+	run(positions.size(), [&positions, &ret, nmoves](int index, ComputerPlayer **players)
+	{
+		if (positions[index].gameOver())
+			return;
+
+		players[0]->setPosition(positions[index]);
+		ret[index] = players[0]->moves(nmoves);
+	});
+
+	return ret;
+}
+
+void BatchPlayer::run(int count, const function<void (int index, ComputerPlayer **players)> &work)
+{
+	if (count <= 0)
+		return;
+
+	DataManager *dataManager = DataManager::self();
+	atomic<int> nextIndex(0);
+
+	auto worker = [this, dataManager, count, &nextIndex, &work]()
+	{
+		DataManagerScope scope(dataManager);
+
+		// computer players keep state between positions, so each
+		// thread needs its own
+		ComputerPlayer *players[2];
+
+		{
+			lock_guard<mutex> lock(m_mutex);
+			for (int i = 0; i < 2; ++i)
+			{
+				players[i] = m_players[i]->clone();
+				players[i]->setParameters(m_players[i]->parameters());
+			}
+		}
+
+		for (int index = nextIndex++; index < count; index = nextIndex++)
+			work(index, players);
+
+		delete players[0];
+		delete players[1];
+	};
+
+	const int threads = min(m_numberOfThreads, count);
+	vector<thread> workers;
+	for (int i = 1; i < threads; ++i)
+		workers.push_back(thread(worker));
+
+	// the calling thread works too
+	worker();
+
+	for (vector<thread>::iterator it = workers.begin(); it != workers.end(); ++it)
+		(*it).join();
+}
+
+void BatchPlayer::playGame(int index, ComputerPlayer **players, SelfPlayResult *result) const
+{
+	result->firstPlayerStarted = index % 2 == 0;
+	result->scores.assign(2, 0);
+	result->bingos.assign(2, 0);
+
+	// Game::setPlayers numbers players by the order they take turns,
+	// so the id of a player is which of the two started
+	PlayerList gamePlayers;
+	for (int i = 0; i < 2; ++i)
+	{
+		const int slot = result->firstPlayerStarted? i : 1 - i;
+		gamePlayers.push_back(Player(players[slot]->name(), Player::ComputerPlayerType, i));
+	}
+
+	Game game;
+	game.setPlayers(gamePlayers);
+	game.addPosition();
+
+	while (!game.currentPosition().gameOver() && result->turns < maximumTurns)
+	{
+		const int id = game.currentPosition().currentPlayer().id();
+		const int slot = result->firstPlayerStarted? id : 1 - id;
+
+		const Move move = game.haveComputerPlay(players[slot]);
+		if (move.isBingo)
+			++result->bingos[slot];
+
+		++result->turns;
+	}
+
+	const PlayerList scores = game.currentPosition().endgameAdjustedScores();
+	for (PlayerList::const_iterator it = scores.begin(); it != scores.end(); ++it)
+	{
+		const int slot = result->firstPlayerStarted? (*it).id() : 1 - (*it).id();
+		result->scores[slot] = (*it).score();
+	}
+
+	if (m_keepHistories)
+		result->history = game.history();
+}
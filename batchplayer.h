@@ -0,0 +1,120 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_BATCHPLAYER_H
+#define QUACKLE_BATCHPLAYER_H
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "batchevaluator.h"
+#include "game.h"
+#include "move.h"
+
+using namespace std;
+
+namespace Quackle
+{
+
+class ComputerPlayer;
+class DataManager;
+
+// Outcome of one self-play game. Scores, bingos and the like are in
+// the order the computer players were given to the BatchPlayer, not
+// in the order the players took turns.
+struct SelfPlayResult
+{
+	SelfPlayResult() : turns(0), firstPlayerStarted(true) {}
+
+	// endgame-adjusted final scores
+	vector<int> scores;
+	vector<int> bingos;
+
+	// moves made in the game
+	int turns;
+	bool firstPlayerStarted;
+
+	// the positions of the game, if BatchPlayer keeps histories
+	History history;
+};
+
+typedef vector<SelfPlayResult> SelfPlayResultList;
+
+// Plays many games, or analyzes many positions, with computer players
+// on a pool of threads, so a caller gets a whole batch of work done in
+// one call. Each thread plays with its own clones of the computer
+// players; the players given are only cloned.
+//
+// Tiles are drawn with DataManager::randomNumber(), so with more than
+// one thread games don't replay exactly from a random seed.
+class BatchPlayer
+{
+public:
+	// numberOfThreads <= 0 means one thread per hardware thread
+	BatchPlayer(ComputerPlayer *firstPlayer, ComputerPlayer *secondPlayer = 0, int numberOfThreads = 0);
+
+	int numberOfThreads() const;
+
+	// Whether results of playGames() keep the positions of their games.
+	// Off by default; they take a lot of memory.
+	void setKeepHistories(bool keepHistories);
+	bool keepHistories() const;
+
+	// Plays games of the first player against the second, or against
+	// itself if there is no second. The players take turns starting.
+	SelfPlayResultList playGames(int games);
+
+	// the nmoves best moves of the first player in each position
+	MoveListList analyze(const PositionList &positions, int nmoves = 10);
+
+	// moves after which a game is stopped even if it isn't over
+	static const int maximumTurns = 500;
+
+private:
+	// runs work(index, players) for every index below count on the
+	// thread pool; players are the thread's clones
+	void run(int count, const function<void (int index, ComputerPlayer **players)> &work);
+
+	void playGame(int index, ComputerPlayer **players, SelfPlayResult *result) const;
+
+	ComputerPlayer *m_players[2];
+	int m_numberOfThreads;
+	bool m_keepHistories;
+
+	mutex m_mutex;
+};
+
+inline int BatchPlayer::numberOfThreads() const
+{
+	return m_numberOfThreads;
+}
+
+inline void BatchPlayer::setKeepHistories(bool keepHistories)
+{
+	m_keepHistories = keepHistories;
+}
+
+inline bool BatchPlayer::keepHistories() const
+{
+	return m_keepHistories;
+}
+
+}
+
+#endif
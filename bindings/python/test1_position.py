@@ -45,7 +45,7 @@ dm = startUp()
 
 # Create a computer player
 player1 = getComputerPlayer(dm)
-print player1.name()
+print(player1.name())
 
 # Create the Game file (.gcg) reader
 gamereader = quackle.GCGIO()
@@ -63,16 +63,16 @@ if unseenbag.size() <= dm.parameters().rackSize() + 3:
     enum = quackle.Enumerator(unseenbag)
     enum.enumerate(racks)
     for rack in racks:
-        print rack
+        print(rack)
 
 movesToShow = 10
 
-print "Board state: \n%s" % position.board().toString()
-print "Move made: %s" % position.moveMade().toString()
-print "Current player: %s" % position.currentPlayer().storeInformationToString()
-print "Turn number: %i" % position.turnNumber()
+print("Board state: \n%s" % position.board().toString())
+print("Move made: %s" % position.moveMade().toString())
+print("Current player: %s" % position.currentPlayer().storeInformationToString())
+print("Turn number: %i" % position.turnNumber())
 
 movelist = player1.moves(10)
 
 # Show 10 moves suggested by computer player
-for move in movelist: print move.toString()
+for move in movelist: print(move.toString())
@@ -0,0 +1,93 @@
+# coding: utf-8
+
+import threading
+import time
+
+import quackle
+
+def startUp(lexicon='twl06',
+            alphabet='english',
+            datadir='../../data'):
+
+    # Set up the data manager
+    dm = quackle.DataManager()
+    dm.setComputerPlayers(quackle.ComputerPlayerCollection.fullCollection())
+    dm.setBackupLexicon(lexicon)
+    dm.setAppDataDirectory(datadir)
+
+    # Set up the alphabet
+    abc = quackle.AlphabetParameters.findAlphabetFile(alphabet)
+    abc2 = quackle.Util.stdStringToQString(abc) #convert to qstring
+    fa = quackle.FlexibleAlphabetParameters()
+
+    assert fa.load(abc2)
+    dm.setAlphabetParameters(fa)
+
+    # Set up the board
+    board = quackle.BoardParameters()
+    dm.setBoardParameters(board)
+
+    # Find the lexicon
+    dawg = quackle.LexiconParameters.findDictionaryFile(lexicon + '.dawg')
+    gaddag = quackle.LexiconParameters.findDictionaryFile(lexicon + '.gaddag')
+    dm.lexiconParameters().loadDawg(dawg)
+    dm.lexiconParameters().loadGaddag(gaddag)
+
+    dm.strategyParameters().initialize(lexicon)
+    return dm
+
+
+def getComputerPlayer(dm, name='Speedy Player'):
+    player, found = dm.computerPlayers().playerForName(name)
+    assert found
+    player = player.computerPlayer()
+    return player
+
+
+dm = startUp()
+
+# Play a batch of games in one call, on all cores
+# Speedy Player plays itself when no second player is given
+batch = quackle.BatchPlayer(getComputerPlayer(dm))
+batch.setKeepHistories(True)
+
+start = time.time()
+results = batch.playGames(20)
+print('Played %i games on %i threads in %.1f s' % (len(results), batch.numberOfThreads(), time.time() - start))
+
+try:
+    scores = quackle.gameScores(results)
+    print('Average scores: %s' % scores.mean(axis=0))
+except ImportError:
+    for result in results:
+        print('%i - %i' % (result.scores[0], result.scores[1]))
+
+# Analyze the positions of the first game in one call
+positions = quackle.PositionList()
+for position in results[0].history:
+    positions.append(position)
+
+analyses = batch.analyze(positions, 5)
+for moves in analyses:
+    if len(moves) > 0:
+        print('%s (equity %.1f)' % (moves[0].toString(), moves[0].equity))
+
+try:
+    scoreArray, equityArray, winArray = quackle.moveArrays(analyses[0])
+    print('Equities of the first position: %s' % equityArray)
+except ImportError:
+    pass
+
+# Long calls release the GIL, so positions can be simulated
+# on Python threads side by side
+def simulate(position):
+    position.kibitz(10)
+    simulator = quackle.Simulator()
+    simulator.setPosition(position)
+    simulator.simulate(2, 50)
+
+threads = [threading.Thread(target=simulate, args=(positions[i],)) for i in range(2)]
+for thread in threads:
+    thread.start()
+for thread in threads:
+    thread.join()
@@ -14,6 +14,8 @@
 #include "game.h"
 #include "gameparameters.h"
 #include "sim.h"
+#include "simulationcache.h"
+#include "trainingexporter.h"
 #include "computerplayer.h"
 #include "computerplayercollection.h"
 #include "datamanager.h"
@@ -22,19 +24,26 @@
 #include "enumerator.h"
 #include "bogowinplayer.h"
 #include "clock.h"
+#include "wordpattern.h"
 #include "generator.h"
 #include "gaddag.h"
 #include "lexiconparameters.h"
+#include "montecarloplayer.h"
 #include "preendgame.h"
 #include "reporter.h"
+#include "rolloutpolicy.h"
 #include "resolvent.h"
 #include "strategyparameters.h"
+#include "batchevaluator.h"
+#include "batchplayer.h"
+#include "leavetrainer.h"
 
 #include <QString>
 #include "quackleio/flexiblealphabet.h"
 #include "quackleio/util.h"
 #include "quackleio/logania.h"
 #include "quackleio/gcgio.h"
+#include "quackleio/gamearchive.h"
 %}
 
 
@@ -42,6 +51,79 @@
 %include "std_vector.i"
 %include "typemaps.i"
 
+#ifdef SWIGPYTHON
+/* Long computations run without the GIL, so other Python threads
+   (or several of these on their own threads) can run meanwhile. */
+%define QUACKLE_RELEASE_GIL(function)
+%exception function {
+    Py_BEGIN_ALLOW_THREADS
+    $action
+    Py_END_ALLOW_THREADS
+}
+%enddef
+
+QUACKLE_RELEASE_GIL(Quackle::Simulator::simulate);
+QUACKLE_RELEASE_GIL(Quackle::GamePosition::kibitz);
+QUACKLE_RELEASE_GIL(Quackle::GamePosition::kibitzAs);
+QUACKLE_RELEASE_GIL(Quackle::Game::haveComputerPlay);
+QUACKLE_RELEASE_GIL(Quackle::Game::advanceToNoncomputerPlayer);
+QUACKLE_RELEASE_GIL(Quackle::ComputerPlayer::move);
+QUACKLE_RELEASE_GIL(Quackle::ComputerPlayer::moves);
+QUACKLE_RELEASE_GIL(Quackle::Endgame::solve);
+QUACKLE_RELEASE_GIL(Quackle::Generator::kibitz);
+QUACKLE_RELEASE_GIL(Quackle::BatchEvaluator::evaluate);
+QUACKLE_RELEASE_GIL(Quackle::BatchPlayer::playGames);
+QUACKLE_RELEASE_GIL(Quackle::BatchPlayer::analyze);
+QUACKLE_RELEASE_GIL(Quackle::LeaveTrainer::train);
+
+%{
+/* a bytearray of count values of type T, filled by fill(T *) */
+template <typename T, typename Fill>
+static PyObject *quackleBuffer(size_t count, Fill fill)
+{
+    PyObject *ret = PyByteArray_FromStringAndSize(NULL, count * sizeof(T));
+    if (ret)
+        fill((T *)PyByteArray_AsString(ret));
+    return ret;
+}
+%}
+
+/* Contiguous arrays of move and game values, as bytearrays that
+   numpy.frombuffer() views without copying; see moveArrays(). */
+%extend std::vector<Quackle::Move> {
+    PyObject *scoreBuffer() const {
+        return quackleBuffer<int32_t>($self->size(), [$self](int32_t *values) { for (size_t i = 0; i < $self->size(); ++i) values[i] = (*$self)[i].score; });
+    }
+    PyObject *equityBuffer() const {
+        return quackleBuffer<float>($self->size(), [$self](float *values) { for (size_t i = 0; i < $self->size(); ++i) values[i] = (*$self)[i].equity; });
+    }
+    PyObject *winBuffer() const {
+        return quackleBuffer<float>($self->size(), [$self](float *values) { for (size_t i = 0; i < $self->size(); ++i) values[i] = (*$self)[i].win; });
+    }
+}
+
+/* scores of the first and second player of each game, row by row */
+%extend std::vector<Quackle::SelfPlayResult> {
+    PyObject *scoreBuffer() const {
+        return quackleBuffer<int32_t>(2 * $self->size(), [$self](int32_t *values) { for (size_t i = 0; i < $self->size(); ++i) { values[2 * i] = (*$self)[i].scores[0]; values[2 * i + 1] = (*$self)[i].scores[1]; } });
+    }
+}
+
+%pythoncode %{
+def moveArrays(moves):
+    """Scores, equities and win percentages of a move list as numpy arrays."""
+    import numpy
+    return (numpy.frombuffer(moves.scoreBuffer(), dtype=numpy.int32),
+            numpy.frombuffer(moves.equityBuffer(), dtype=numpy.float32),
+            numpy.frombuffer(moves.winBuffer(), dtype=numpy.float32))
+
+def gameScores(results):
+    """Final scores of self-play results as a games by 2 numpy array."""
+    import numpy
+    return numpy.frombuffer(results.scoreBuffer(), dtype=numpy.int32).reshape(-1, 2)
+%}
+#endif
+
 %include "fixedstring.h"
 %include "uv.h"
 %include "alphabetparameters.h"
@@ -78,7 +160,10 @@ namespace Quackle
 
 %include "game.h"
 %include "gameparameters.h"
+%include "rolloutpolicy.h"
 %include "sim.h"
+%include "simulationcache.h"
+%include "trainingexporter.h"
 %include "computerplayer.h"
 %include "computerplayercollection.h"
 
@@ -96,16 +181,32 @@ namespace Quackle
 %include "enumerator.h"
 %include "bogowinplayer.h"
 %include "clock.h"
+%include "wordpattern.h"
 %include "generator.h"
 %include "gaddag.h"
 %include "lexiconparameters.h"
+%include "montecarloplayer.h"
 %include "preendgame.h"
 %include "reporter.h"
 %include "resolvent.h"
 %include "strategyparameters.h"
+%include "batchevaluator.h"
+%include "batchplayer.h"
+
+/* progress callbacks are for C++ callers; see rounds() */
+%ignore Quackle::LeaveTrainer::setProgressCallback;
+%include "leavetrainer.h"
+
+%template(BatchPositionVector) std::vector<Quackle::BatchPosition>;
+%template(MoveListVector) std::vector<Quackle::MoveList>;
+%template(WordWithInfoVector) std::vector<Quackle::WordWithInfo>;
+%template(SelfPlayResultVector) std::vector<Quackle::SelfPlayResult>;
+%template(IntVector) std::vector<int>;
+%template(LeaveTrainingRoundVector) std::vector<Quackle::LeaveTrainingRound>;
 
 %include <QString>
 %include "quackleio/flexiblealphabet.h"
 %include "quackleio/util.h"
 %include "quackleio/logania.h"
 %include "quackleio/gcgio.h"
+%include "quackleio/gamearchive.h"
@@ -42,12 +42,13 @@ inline int wordMultiplier(int row, int column)
 Board::Board()
     : m_width(QUACKLE_BOARD_PARAMETERS->width()), 
       m_height(QUACKLE_BOARD_PARAMETERS->height()), 
-      m_empty(true)
+      m_empty(true),
+      m_squares(m_width * m_height)
 {
 }
 
 Board::Board(int width, int height)
-    : m_width(width), m_height(height), m_empty(true)
+    : m_width(width), m_height(height), m_empty(true), m_squares(m_width * m_height)
 {
 }
 
@@ -60,10 +61,10 @@ Bag Board::tilesOnBoard() const
 	{
 		for (int col = 0; col < m_width; col++)
 		{
-			if (m_letters[row][col] != QUACKLE_NULL_MARK)
+			if (square(row, col).letter != QUACKLE_NULL_MARK)
 			{
 				LetterString letters;
-				letters += m_isBlank[row][col]? QUACKLE_BLANK_MARK : m_letters[row][col];
+				letters += square(row, col).isBlank? QUACKLE_BLANK_MARK : square(row, col).letter;
 				ret.toss(letters);
 			}
 		}
@@ -78,12 +79,24 @@ Bag Board::tilesNotOnBoard() const
 
 	for (int row = 0; row < m_height; row++)
 		for (int col = 0; col < m_width; col++)
-			if (m_letters[row][col] != QUACKLE_NULL_MARK)
-				ret.removeLetter(m_isBlank[row][col]? QUACKLE_BLANK_MARK : m_letters[row][col]);
+			if (square(row, col).letter != QUACKLE_NULL_MARK)
+				ret.removeLetter(square(row, col).isBlank? QUACKLE_BLANK_MARK : square(row, col).letter);
 
 	return ret;
 }
 
+bool Board::isOnBoard(const Move &move) const
+{
+	if (move.action != Move::Place)
+		return true;
+
+	const int length = move.tiles().length();
+	if (move.startrow < 0 || move.startcol < 0 || length == 0)
+		return false;
+
+	return move.horizontal? (move.startrow < m_height && move.startcol + length <= m_width) : (move.startcol < m_width && move.startrow + length <= m_height);
+}
+
 bool Board::isConnected(const Move &move) const
 {
 	bool ret = false;
@@ -141,25 +154,25 @@ void Board::updateBritishness()
 		{
 			bool isBritish = false;
 
-			if (m_letters[row][col] != QUACKLE_NULL_MARK)
+			if (square(row, col).letter != QUACKLE_NULL_MARK)
 			{
 				word.clear();
-				word += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(m_letters[row][col]);
+				word += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(square(row, col).letter);
 
 				for (int j = row - 1; j >= 0; --j)
 				{
-					if (m_letters[j][col] == QUACKLE_NULL_MARK)
+					if (square(j, col).letter == QUACKLE_NULL_MARK)
 						break;
 					else
-						word = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(m_letters[j][col]) + word;
+						word = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(square(j, col).letter) + word;
 				}
 
 				for (int j = row + 1; j < m_height; ++j)
 				{
-					if (m_letters[j][col] == QUACKLE_NULL_MARK)
+					if (square(j, col).letter == QUACKLE_NULL_MARK)
 						break;
 					else
-						word += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(m_letters[j][col]);
+						word += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(square(j, col).letter);
 				}
 
 				if (word.length() > 1)
@@ -173,22 +186,22 @@ void Board::updateBritishness()
 				}
 
 				word.clear();
-				word += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(m_letters[row][col]);
+				word += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(square(row, col).letter);
 
 				for (int j = col - 1; j >= 0; --j)
 				{
-					if (m_letters[row][j] == QUACKLE_NULL_MARK)
+					if (square(row, j).letter == QUACKLE_NULL_MARK)
 						break;
 					else
-						word = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(m_letters[row][j]) + word;
+						word = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(square(row, j).letter) + word;
 				}
 
 				for (int j = col + 1; j < m_width; ++j)
 				{
-					if (m_letters[row][j] == QUACKLE_NULL_MARK)
+					if (square(row, j).letter == QUACKLE_NULL_MARK)
 						break;
 					else
-						word += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(m_letters[row][j]);
+						word += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(square(row, j).letter);
 				}
 
 				if (word.length() > 1)
@@ -202,7 +215,7 @@ void Board::updateBritishness()
 				}
 			}
 
-			m_isBritish[row][col] = isBritish;
+			square(row, col).isBritish = isBritish;
 		}
 	}
 }
@@ -230,7 +243,7 @@ MoveList Board::allWordsFormedBy(const Move &move) const
 				const LetterString::const_iterator end(move.tiles().end());
 				for (LetterString::const_iterator it = move.tiles().begin(); it != end; ++it, ++i)
 				{
-					if (m_letters[move.startrow][i + move.startcol] == QUACKLE_NULL_MARK)
+					if (square(move.startrow, i + move.startcol).letter == QUACKLE_NULL_MARK)
 					{
 						word.clear();
 						word += *it;
@@ -238,23 +251,23 @@ MoveList Board::allWordsFormedBy(const Move &move) const
 						int startRow = 0;
 						for (int j = move.startrow - 1; j >= 0; --j)
 						{
-							if (m_letters[j][i + move.startcol] == QUACKLE_NULL_MARK)
+							if (square(j, i + move.startcol).letter == QUACKLE_NULL_MARK)
 							{
 								startRow = j + 1;
 								break;
 							}
 							else
 							{
-								word = m_letters[j][i + move.startcol] + word;
+								word = square(j, i + move.startcol).letter + word;
 							}
 						}
 
 						for (int j = move.startrow + 1; j < m_height; ++j)
 						{
-							if (m_letters[j][i + move.startcol] == QUACKLE_NULL_MARK)
+							if (square(j, i + move.startcol).letter == QUACKLE_NULL_MARK)
 								j = m_height;
 							else
-								word += m_letters[j][i + move.startcol];
+								word += square(j, i + move.startcol).letter;
 						}
 
 						if (word.length() > 1)
@@ -270,7 +283,7 @@ MoveList Board::allWordsFormedBy(const Move &move) const
 				const LetterString::const_iterator end(move.tiles().end());
 				for (LetterString::const_iterator it = move.tiles().begin(); it != end; ++it, ++i)
 				{
-					if (m_letters[i + move.startrow][move.startcol] == QUACKLE_NULL_MARK)
+					if (square(i + move.startrow, move.startcol).letter == QUACKLE_NULL_MARK)
 					{
 						word.clear();
 						word += *it;
@@ -278,23 +291,23 @@ MoveList Board::allWordsFormedBy(const Move &move) const
 						int startColumn = 0;
 						for (int j = move.startcol - 1; j >= 0; --j)
 						{
-							if (m_letters[i + move.startrow][j] == QUACKLE_NULL_MARK)
+							if (square(i + move.startrow, j).letter == QUACKLE_NULL_MARK)
 							{
 								startColumn = j + 1;
 								break;
 							}
 							else
 							{
-								word = m_letters[i + move.startrow][j] + word;
+								word = square(i + move.startrow, j).letter + word;
 							}
 						}
 
 						for (int j = move.startcol + 1; j < m_width; ++j)
 						{
-							if (m_letters[i + move.startrow][j] == QUACKLE_NULL_MARK)
+							if (square(i + move.startrow, j).letter == QUACKLE_NULL_MARK)
 								j = m_width;
 							else
-								word += m_letters[i + move.startrow][j];
+								word += square(i + move.startrow, j).letter;
 						}
 
 						if (word.length() > 1)
@@ -336,7 +349,7 @@ int Board::score(const Move &move, bool *isBingo) const
 			const LetterString::const_iterator end(move.tiles().end());
 			for (LetterString::const_iterator it = move.tiles().begin(); it != end; ++it, ++i)
 			{
-				if (m_letters[move.startrow][i + move.startcol] == QUACKLE_NULL_MARK)
+				if (square(move.startrow, i + move.startcol).letter == QUACKLE_NULL_MARK)
 				{
 					if (QUACKLE_ALPHABET_PARAMETERS->isPlainLetter(*it))
 						mainscore += QUACKLE_ALPHABET_PARAMETERS->score(*it) * letterMultiplier(move.startrow, i + move.startcol);
@@ -350,27 +363,27 @@ int Board::score(const Move &move, bool *isBingo) const
 
 					for (int j = move.startrow - 1; j >= 0; --j)
 					{
-						if (m_letters[j][i + move.startcol] == QUACKLE_NULL_MARK)
+						if (square(j, i + move.startcol).letter == QUACKLE_NULL_MARK)
 							j = -1;
 						else
 						{
 							++hooked;
 
-							if (!m_isBlank[j][i + move.startcol])
-								thishook += QUACKLE_ALPHABET_PARAMETERS->score(m_letters[j][i + move.startcol]);
+							if (!square(j, i + move.startcol).isBlank)
+								thishook += QUACKLE_ALPHABET_PARAMETERS->score(square(j, i + move.startcol).letter);
 						}
 					}
 
 					for (int j = move.startrow + 1; j < m_height; ++j)
 					{
-						if (m_letters[j][i + move.startcol] == QUACKLE_NULL_MARK)
+						if (square(j, i + move.startcol).letter == QUACKLE_NULL_MARK)
 							j = m_height;
 						else
 						{
 							++hooked;
 
-							if (!m_isBlank[j][i + move.startcol])
-								thishook += QUACKLE_ALPHABET_PARAMETERS->score(m_letters[j][i + move.startcol]);
+							if (!square(j, i + move.startcol).isBlank)
+								thishook += QUACKLE_ALPHABET_PARAMETERS->score(square(j, i + move.startcol).letter);
 						}
 					}
 
@@ -383,8 +396,8 @@ int Board::score(const Move &move, bool *isBingo) const
 						hookscore += thishook;
 					} 
 				}
-				else if (!m_isBlank[move.startrow][i + move.startcol])
-					mainscore += QUACKLE_ALPHABET_PARAMETERS->score(m_letters[move.startrow][i + move.startcol]);
+				else if (!square(move.startrow, i + move.startcol).isBlank)
+					mainscore += QUACKLE_ALPHABET_PARAMETERS->score(square(move.startrow, i + move.startcol).letter);
 			}
 		}
 		else
@@ -393,7 +406,7 @@ int Board::score(const Move &move, bool *isBingo) const
 			const LetterString::const_iterator end(move.tiles().end());
 			for (LetterString::const_iterator it = move.tiles().begin(); it != end; ++it, ++i)
 			{
-				if (m_letters[i + move.startrow][move.startcol] == QUACKLE_NULL_MARK)
+				if (square(i + move.startrow, move.startcol).letter == QUACKLE_NULL_MARK)
 				{
 					if (QUACKLE_ALPHABET_PARAMETERS->isPlainLetter(*it))
 						mainscore += QUACKLE_ALPHABET_PARAMETERS->score(*it) * letterMultiplier(i + move.startrow, move.startcol);
@@ -407,27 +420,27 @@ int Board::score(const Move &move, bool *isBingo) const
 
 					for (int j = move.startcol - 1; j >= 0; --j)
 					{
-						if (m_letters[i + move.startrow][j] == QUACKLE_NULL_MARK)
+						if (square(i + move.startrow, j).letter == QUACKLE_NULL_MARK)
 							j = -1;
 						else
 						{
 							++hooked;
 
-							if (!m_isBlank[i + move.startrow][j])
-								thishook += QUACKLE_ALPHABET_PARAMETERS->score(m_letters[i + move.startrow][j]);
+							if (!square(i + move.startrow, j).isBlank)
+								thishook += QUACKLE_ALPHABET_PARAMETERS->score(square(i + move.startrow, j).letter);
 						}
 					}
 
 					for (int j = move.startcol + 1; j < m_width; ++j)
 					{
-						if (m_letters[i + move.startrow][j] == QUACKLE_NULL_MARK)
+						if (square(i + move.startrow, j).letter == QUACKLE_NULL_MARK)
 							j = m_width;
 						else
 						{
 							++hooked;
 
-							if (!m_isBlank[i + move.startrow][j])
-								thishook += QUACKLE_ALPHABET_PARAMETERS->score(m_letters[i + move.startrow][j]);
+							if (!square(i + move.startrow, j).isBlank)
+								thishook += QUACKLE_ALPHABET_PARAMETERS->score(square(i + move.startrow, j).letter);
 						}
 					}
 
@@ -440,8 +453,8 @@ int Board::score(const Move &move, bool *isBingo) const
 						hookscore += thishook;
 					}
 				}
-				else if (!m_isBlank[i + move.startrow][move.startcol])
-					mainscore += QUACKLE_ALPHABET_PARAMETERS->score(m_letters[i + move.startrow][move.startcol]);
+				else if (!square(i + move.startrow, move.startcol).isBlank)
+					mainscore += QUACKLE_ALPHABET_PARAMETERS->score(square(i + move.startrow, move.startcol).letter);
 			}
 		}
 
@@ -494,7 +507,7 @@ LetterString Board::prettyTilesOfMove(const Move &move, bool markPlayThruTiles)
 				insidePlayThru = true;
 			}
 
-			ret += m_letters[currentTileRow][currentTileCol];
+			ret += square(currentTileRow, currentTileCol).letter;
 		}
 		else 
 		{
@@ -536,7 +549,7 @@ LetterString Board::sanitizedTilesOfMove(const Move &move) const
 			else
 				currentTileRow += i;
 
-			if (m_letters[currentTileRow][currentTileCol] == QUACKLE_NULL_MARK)
+			if (square(currentTileRow, currentTileCol).letter == QUACKLE_NULL_MARK)
 				ret += *it;
 			else
 				ret += QUACKLE_PLAYED_THRU_MARK;
@@ -556,10 +569,10 @@ void Board::makeMove(const Move &move)
 		const LetterString::const_iterator end(move.tiles().end());
 		for (LetterString::const_iterator it = move.tiles().begin(); it != end; ++it)
 		{
-			if (m_letters[row][col] == QUACKLE_NULL_MARK)
+			if (square(row, col).letter == QUACKLE_NULL_MARK)
 			{
-				m_letters[row][col] = *it;
-				m_isBlank[row][col] = QUACKLE_ALPHABET_PARAMETERS->isBlankLetter(*it);
+				square(row, col).letter = *it;
+				square(row, col).isBlank = QUACKLE_ALPHABET_PARAMETERS->isBlankLetter(*it);
 			}
 
 			if (move.horizontal)
@@ -595,9 +608,9 @@ UVString Board::toString() const
 
 		for (int col = 0; col < m_width; col++)
 		{
-			if (m_letters[row][col] != QUACKLE_NULL_MARK)
+			if (square(row, col).letter != QUACKLE_NULL_MARK)
 			{
-				ss << QUACKLE_ALPHABET_PARAMETERS->userVisible(m_letters[row][col]);
+				ss << QUACKLE_ALPHABET_PARAMETERS->userVisible(square(row, col).letter);
 			}
 			else
 			{
@@ -674,15 +687,15 @@ UVString Board::htmlBoard(const int tileSize) const
 				bgcolor = "goldenrod";
 
 			ss << "<td height=" << tdHeight << " width=" << tdWidth << " bgcolor=\"" << bgcolor << "\" " << centerAlign << ">";
-			if (m_letters[row][col] != QUACKLE_NULL_MARK)
+			if (square(row, col).letter != QUACKLE_NULL_MARK)
 			{
 				const int fontSize = static_cast<int>(tileSize * 5/9);
-				if (QUACKLE_ALPHABET_PARAMETERS->isBlankLetter(m_letters[row][col]))
+				if (QUACKLE_ALPHABET_PARAMETERS->isBlankLetter(square(row, col).letter))
 				{
 					const int blankFontSize = static_cast<int>(fontSize * 0.8);
 					ss << "<table style=\"border: 1pt; border-style: dashed\"><tr><td width=" << tdWidth * 0.8 << " height=" << tdHeight * 0.8 << " bgcolor=\"" << bgcolor << "\" " << centerAlign << ">";
 					ss << "<span style=\"font-size: " << blankFontSize << "px\">";
-					ss << QUACKLE_ALPHABET_PARAMETERS->userVisible(QUACKLE_ALPHABET_PARAMETERS->clearBlankness(m_letters[row][col]));
+					ss << QUACKLE_ALPHABET_PARAMETERS->userVisible(QUACKLE_ALPHABET_PARAMETERS->clearBlankness(square(row, col).letter));
 					ss << "</span>";
 					ss << "</td></tr></table>";
 				}
@@ -692,10 +705,10 @@ UVString Board::htmlBoard(const int tileSize) const
 					const int minimumValueFontSize = 7;
 					const int valueFontSize = minimumValueFontSize > idealValueFontSize? minimumValueFontSize : idealValueFontSize;
 					ss << "<span style=\"font-size: " << fontSize << "px\">";
-					ss << QUACKLE_ALPHABET_PARAMETERS->userVisible(m_letters[row][col]);
+					ss << QUACKLE_ALPHABET_PARAMETERS->userVisible(square(row, col).letter);
 					ss << "</span>";
 					ss << "<span style=\"font-size: " << valueFontSize << "px\">";
-					ss << QUACKLE_ALPHABET_PARAMETERS->score(m_letters[row][col]);
+					ss << QUACKLE_ALPHABET_PARAMETERS->score(square(row, col).letter);
 					ss << "</span>";
 				}
 			}
@@ -738,15 +751,13 @@ void Board::prepareEmptyBoard()
 {
 	m_empty = true;
 
-	for (int i = 0; i < m_height; ++i)
+	for (vector<Square>::iterator it = m_squares.begin(); it != m_squares.end(); ++it)
 	{
-		for (int j = 0; j < m_width; ++j)
-		{
-			m_letters[i][j] = QUACKLE_NULL_MARK;
-			m_isBlank[i][j] = false;
-			m_vcross[i][j].set();
-			m_hcross[i][j].set();
-		}
+		(*it).letter = QUACKLE_NULL_MARK;
+		(*it).isBlank = false;
+		(*it).isBritish = false;
+		(*it).vcross.set();
+		(*it).hcross.set();
 	}
 }
 
@@ -754,12 +765,12 @@ Board::TileInformation Board::tileInformation(int row, int col) const
 {
 	TileInformation ret;
 
-	if (m_letters[row][col] != QUACKLE_NULL_MARK)
+	if (square(row, col).letter != QUACKLE_NULL_MARK)
 	{
 		ret.tileType = LetterTile;
-		ret.isBlank = m_isBlank[row][col];
-		ret.letter = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(m_letters[row][col]);
-		ret.isBritish = m_isBritish[row][col];
+		ret.isBlank = square(row, col).isBlank;
+		ret.letter = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(square(row, col).letter);
+		ret.isBritish = square(row, col).isBritish;
 	}
 	else
 	{
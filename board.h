@@ -60,6 +60,9 @@ public:
 
 	bool isEmpty() const;
 
+	// whether all tiles of a Place move are on squares of the board
+	bool isOnBoard(const Move &move) const;
+
 	void makeMove(const Move &move);
 
 	// Returns all words formed when play is made.
@@ -136,12 +139,22 @@ protected:
 	int m_height;
 	bool m_empty;
 
-	Letter m_letters[QUACKLE_MAXIMUM_BOARD_SIZE][QUACKLE_MAXIMUM_BOARD_SIZE];
-	bool m_isBlank[QUACKLE_MAXIMUM_BOARD_SIZE][QUACKLE_MAXIMUM_BOARD_SIZE];
-	bool m_isBritish[QUACKLE_MAXIMUM_BOARD_SIZE][QUACKLE_MAXIMUM_BOARD_SIZE];
+	struct Square
+	{
+		LetterBitset vcross;
+		LetterBitset hcross;
+		Letter letter;
+		bool isBlank;
+		bool isBritish;
+	};
+
+	// Only the squares the board has, row by row, so copying a board
+	// (and every GamePosition) costs width * height squares rather
+	// than the largest board possible.
+	vector<Square> m_squares;
 
-	LetterBitset m_vcross[QUACKLE_MAXIMUM_BOARD_SIZE][QUACKLE_MAXIMUM_BOARD_SIZE];
-	LetterBitset m_hcross[QUACKLE_MAXIMUM_BOARD_SIZE][QUACKLE_MAXIMUM_BOARD_SIZE];
+	Square &square(int row, int col);
+	const Square &square(int row, int col) const;
 
 	inline bool isNonempty(int row, int column) const;
 };
@@ -151,44 +164,54 @@ inline bool Board::isEmpty() const
 	return m_empty;
 }
 
+inline Board::Square &Board::square(int row, int col)
+{
+	return m_squares[row * m_width + col];
+}
+
+inline const Board::Square &Board::square(int row, int col) const
+{
+	return m_squares[row * m_width + col];
+}
+
 inline Letter Board::letter(int row, int col) const
 {
-	return m_letters[row][col];
+	return square(row, col).letter;
 }
 
 inline bool Board::isBlank(int row, int col) const
 {
-	return m_isBlank[row][col];
+	return square(row, col).isBlank;
 }
 
 inline bool Board::isBritish(int row, int col) const
 {
-	return m_isBritish[row][col];
+	return square(row, col).isBritish;
 }
 
 inline const LetterBitset &Board::vcross(int row, int col) const
 {
-	return m_vcross[row][col];
+	return square(row, col).vcross;
 }
 
 inline void Board::setVCross(int row, int col, const LetterBitset &vcross)
 {
-	m_vcross[row][col] = vcross;
+	square(row, col).vcross = vcross;
 }
 
 inline const LetterBitset &Board::hcross(int row, int col) const
 {
-	return m_hcross[row][col];
+	return square(row, col).hcross;
 }
 
 inline void Board::setHCross(int row, int col, const LetterBitset &hcross)
 {
-	m_hcross[row][col] = hcross;
+	square(row, col).hcross = hcross;
 }
 
 inline bool Board::isNonempty(int row, int column) const
 {
-	return m_letters[row][column] != QUACKLE_NULL_MARK;
+	return square(row, column).letter != QUACKLE_NULL_MARK;
 }
 
 }
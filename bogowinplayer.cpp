@@ -84,10 +84,37 @@ Move SmartBogowin::move()
 	return moves(1).back();
 }
 
+void SmartBogowin::simulate(int plies, int iterations, double stopAt, Deadline &deadline)
+{
+	deadline.startWork();
+
+	for (int i = 0; i < iterations; ++i)
+	{
+		if (deadline.elapsed() >= stopAt || deadline.passed() || shouldAbort())
+			break;
+
+		m_simulator.simulate(plies);
+		deadline.recordWork(1);
+	}
+}
+
+void SmartBogowin::allotIterations(const Deadline &deadline, int candidatesLeft, int *minimum, int *maximum) const
+{
+	const double secondsPerCandidate = deadline.remaining() / max(candidatesLeft, 1);
+
+	*maximum = max(deadline.unitsFitting(secondsPerCandidate, maxIterations()), 1);
+	*minimum = *maximum;
+	if (maxIterations() > 0)
+		*minimum = max(static_cast<int>(*maximum * static_cast<double>(minIterations()) / maxIterations()), 1);
+}
+
 MoveList SmartBogowin::moves(int nmoves)
 {
-	Stopwatch stopwatch;
-	
+	return moves(nmoves, Deadline(m_parameters.secondsPerTurn));
+}
+
+MoveList SmartBogowin::moves(int nmoves, Deadline deadline)
+{
 	if (currentPosition().bag().empty())
     {
         signalFractionDone(0);
@@ -158,8 +185,14 @@ MoveList SmartBogowin::moves(int nmoves)
 
 	signalFractionDone(0);
 
+	// Until some iterations have been timed, this uses the
+	// iterations-per-second guesses.
+	int minimum, maximum;
+	allotIterations(deadline, staticMoves.size(), &minimum, &maximum);
+	double stopAt = deadline.elapsed() + deadline.remaining() / staticMoves.size();
+
 	m_simulator.setIncludedMoves(firstMove);
-	m_simulator.simulate(plies, minIterations());
+	simulate(plies, minimum, stopAt, deadline);
 	
 	Move best = *m_simulator.moves(/* prune */ true, /* sort by win */ true).begin();
 	simmedMoves.push_back(best);
@@ -170,23 +203,28 @@ MoveList SmartBogowin::moves(int nmoves)
 
 	for (++it; it != staticMoves.end(); ++it)
 	{
-		signalFractionDone(max(static_cast<float>(simmedMoves.size()) / static_cast<float>(staticMoves.size()), static_cast<float>(stopwatch.elapsed()) / static_cast<float>(m_parameters.secondsPerTurn)));
+		signalFractionDone(max(static_cast<double>(simmedMoves.size()) / static_cast<double>(staticMoves.size()), deadline.fractionUsed()));
 
 		if (shouldAbort())
 			goto sort_and_return;
 
+		// share out what time is left between the candidates left
+		const int candidatesLeft = staticMoves.end() - it;
+		allotIterations(deadline, candidatesLeft, &minimum, &maximum);
+		stopAt = deadline.elapsed() + deadline.remaining() / candidatesLeft;
+
 		//UVcout << "best move: " << best << " with " << bestbp  << " bogopoints." << endl;
 		MoveList lookFurther;
 		lookFurther.push_back(*it);
 		m_simulator.setIncludedMoves(lookFurther);
-		m_simulator.simulate(plies, minIterations());
+		simulate(plies, minimum, stopAt, deadline);
 		Move move = *m_simulator.moves(/* prune */ true, /* sort by win */ true).begin();
 		double movebp = bogopoints(move);
 		//UVcout << "we just simmed " << move << "; bogopoints: " << movebp << endl;
 	
-		if (movebp + 1.96 * 35.0 / sqrt((double)minIterations()) > bestbp)
+		if (movebp + 1.96 * 35.0 / sqrt((double)minimum) > bestbp)
 		{
-			m_simulator.simulate(plies, maxIterations() - minIterations());
+			simulate(plies, maximum - minimum, stopAt, deadline);
 			Move move2 = *m_simulator.moves(true, true).begin();
 			movebp = bogopoints(move2);
 			//UVcout << "sim it some more: " << move2 << " bogopoints: " << movebp << endl;
@@ -203,9 +241,9 @@ MoveList SmartBogowin::moves(int nmoves)
 			simmedMoves.push_back(move);
 		}
 		
-		if (stopwatch.exceeded(m_parameters.secondsPerTurn))
+		if (deadline.passed())
 		{
-			//UVcout << "Bogowinplayer stopwatch exceeded its limit " << m_parameters.secondsPerTurn << ". Returning early." << endl;
+			//UVcout << "Bogowinplayer deadline of " << m_parameters.secondsPerTurn << " seconds passed. Returning early." << endl;
 			goto sort_and_return;
 		}
 	}	
@@ -19,6 +19,7 @@
 #ifndef QUACKLE_BOGOWINPLAYER_H
 #define QUACKLE_BOGOWINPLAYER_H
 
+#include "clock.h"
 #include "computerplayer.h"
 #include "endgame.h"
 
@@ -35,14 +36,30 @@ public:
 	virtual MoveList moves(int nmoves);
 	virtual ComputerPlayer *clone() { return new SmartBogowin; }
 
+	// like moves(), but within deadline instead of the seconds per
+	// turn of the parameters; for players that use this one for a
+	// phase of their own turn
+	MoveList moves(int nmoves, Deadline deadline);
+
 	virtual bool isSlow() const;
 	virtual bool isUserVisible() const;
 	virtual double bogopoints(Move &move);
 
 protected:
+	// initial guesses at how many iterations to simulate each
+	// candidate for, before any iterations have been timed
 	int minIterations() const;
 	int maxIterations() const;
 
+	// Simulate the included moves for up to the specified number of
+	// iterations, stopping early at stopAt seconds into the deadline.
+	// Iterations are recorded as work on the deadline.
+	void simulate(int plies, int iterations, double stopAt, Deadline &deadline);
+
+	// Iterations to simulate the next candidate for, sized at the measured
+	// rate so that the candidates left all fit in the time remaining.
+	void allotIterations(const Deadline &deadline, int candidatesLeft, int *minimum, int *maximum) const;
+
 	Endgame m_endgame;
 
 	int m_additionalInitialCandidates;
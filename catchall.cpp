@@ -27,6 +27,27 @@ using namespace Quackle;
 double CatchallEvaluator::equity(const GamePosition &position, const Move &move) const
 {
 	//UVcout << "catchall being used on " << move.tiles() << endl;
+	if (isEndgame(position))
+		return endgameResult(position, move) + move.score;
+
+	return ScorePlusLeaveEvaluator::equity(position, move) + adjustment(position, move);
+}
+
+double CatchallEvaluator::equityWithLeaveValue(const GamePosition &position, const Move &move, double leaveValue) const
+{
+	if (isEndgame(position))
+		return endgameResult(position, move) + move.score;
+
+	return ScorePlusLeaveEvaluator::equityWithLeaveValue(position, move, leaveValue) + adjustment(position, move);
+}
+
+bool CatchallEvaluator::isEndgame(const GamePosition &position) const
+{
+	return !position.board().isEmpty() && position.bag().size() == 0;
+}
+
+double CatchallEvaluator::adjustment(const GamePosition &position, const Move &move) const
+{
 	if (position.board().isEmpty())
 	{
 		double adjustment = 0;
@@ -55,25 +76,18 @@ double CatchallEvaluator::equity(const GamePosition &position, const Move &move)
 			adjustment = 3.5;
 
 		// UVcout << "placement adjustment for " << move << " is " << adjustment << endl;
-		return ScorePlusLeaveEvaluator::equity(position, move) + adjustment;
-	}
-	
-	else if (position.bag().size() > 0)
-	{
-		int leftInBagPlusSeven = position.bag().size() - move.usedTiles().length() + 7;
-		double heuristicArray[13] =
-		{
-			0.0, -8.0, 0.0, -0.5, -2.0, -3.5, -2.0,
-			2.0, 10.0, 7.0,  4.0, -1.0, -2.0
-		};
-		double timingHeuristic = 0.0;
-		if (leftInBagPlusSeven < 13) timingHeuristic = heuristicArray[leftInBagPlusSeven];
-		return ScorePlusLeaveEvaluator::equity(position, move) + timingHeuristic;
+		return adjustment;
 	}
-	else
+
+	int leftInBagPlusSeven = position.bag().size() - move.usedTiles().length() + 7;
+	double heuristicArray[13] =
 	{
-		return endgameResult(position, move) + move.score;
-	}
+		0.0, -8.0, 0.0, -0.5, -2.0, -3.5, -2.0,
+		2.0, 10.0, 7.0,  4.0, -1.0, -2.0
+	};
+	double timingHeuristic = 0.0;
+	if (leftInBagPlusSeven < 13) timingHeuristic = heuristicArray[leftInBagPlusSeven];
+	return timingHeuristic;
 }
 
 double CatchallEvaluator::endgameResult(const GamePosition &position, const Move &move) const
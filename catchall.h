@@ -30,8 +30,17 @@ public:
 	// Evaluator that returns score+leave equity for non-bag-empty positions,
 	// otherwise returns approximate endgame equity
 	virtual double equity(const GamePosition &position, const Move &move) const;
+	virtual double equityWithLeaveValue(const GamePosition &position, const Move &move, double leaveValue) const;
 	
 	double endgameResult(const GamePosition &position, const Move &move) const;
+
+private:
+	// no tiles in the bag, but not the opening either
+	bool isEndgame(const GamePosition &position) const;
+
+	// for the opening placement, or for timing, added to the
+	// score+leave equity
+	double adjustment(const GamePosition &position, const Move &move) const;
 };
 
 }
@@ -16,31 +16,90 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <time.h>
+#include <algorithm>
 
 #include "clock.h"
 
+using namespace std;
 using namespace Quackle;
 
 Stopwatch::Stopwatch()
-	: m_startTime(0)
 {
 	start();
 }
 
 void Stopwatch::start()
 {
-	m_startTime = time(NULL);
+	m_startTime = chrono::steady_clock::now();
 }
 
 int Stopwatch::elapsed() const
 {
-	time_t now = time(NULL);
-	return (int) (now - m_startTime);
+	return static_cast<int>(elapsedSeconds());
 }
 
-bool Stopwatch::exceeded(int seconds) const
+double Stopwatch::elapsedSeconds() const
 {
-	return elapsed() > seconds;
+	return chrono::duration<double>(chrono::steady_clock::now() - m_startTime).count();
 }
 
+bool Stopwatch::exceeded(double seconds) const
+{
+	return elapsedSeconds() > seconds;
+}
+
+Deadline::Deadline(double seconds)
+	: m_budget(seconds), m_lastMark(0), m_measuredUnits(0), m_measuredSeconds(0)
+{
+}
+
+double Deadline::remaining() const
+{
+	return max(0.0, m_budget - elapsed());
+}
+
+double Deadline::fractionUsed() const
+{
+	if (m_budget <= 0)
+		return 1;
+
+	return min(1.0, elapsed() / m_budget);
+}
+
+Deadline Deadline::phase(double fraction) const
+{
+	Deadline ret(remaining() * fraction);
+	ret.m_measuredUnits = m_measuredUnits;
+	ret.m_measuredSeconds = m_measuredSeconds;
+	return ret;
+}
+
+void Deadline::startWork()
+{
+	m_lastMark = elapsed();
+}
+
+void Deadline::recordWork(int units)
+{
+	const double now = elapsed();
+	m_measuredUnits += units;
+	m_measuredSeconds += now - m_lastMark;
+	m_lastMark = now;
+}
+
+double Deadline::unitsPerSecond() const
+{
+	if (m_measuredUnits == 0 || m_measuredSeconds <= 0)
+		return 0;
+
+	return m_measuredUnits / m_measuredSeconds;
+}
+
+int Deadline::unitsFitting(double seconds, int fallback) const
+{
+	const double rate = unitsPerSecond();
+	if (rate <= 0)
+		return fallback;
+
+	return static_cast<int>(rate * max(0.0, seconds));
+}
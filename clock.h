@@ -19,9 +19,13 @@
 #ifndef QUACKLE_CLOCK_H
 #define QUACKLE_CLOCK_H
 
+#include <chrono>
+
 namespace Quackle
 {
 
+// Measures time on a monotonic clock, so it isn't thrown
+// off by changes to the wall clock.
 class Stopwatch
 {
 public:
@@ -31,17 +35,85 @@ public:
 	// sets the start time to the time now
 	void start();
 
-	// returns how much time has passed since start was called
+	// returns how many whole seconds have passed since start was called
 	int elapsed() const;
 
+	// returns how much time has passed since start was called,
+	// in seconds with sub-second precision
+	double elapsedSeconds() const;
+
 	// returns true if the elapsed time exceeds the specified
 	// number of seconds
-	bool exceeded(int seconds) const;
+	bool exceeded(double seconds) const;
+
+private:
+	std::chrono::steady_clock::time_point m_startTime;
+};
+
+// A time budget that starts running when constructed.
+// Callers record units of work (simulation iterations, say) as they
+// complete them; the deadline measures the throughput and can tell
+// how many more units fit in some amount of time. A deadline can be
+// split into phases that each get a part of what remains.
+class Deadline
+{
+public:
+	// a deadline the specified number of seconds from now
+	Deadline(double seconds);
+
+	double budget() const;
+	double elapsed() const;
+
+	// seconds left; never negative
+	double remaining() const;
+
+	bool passed() const;
+
+	// elapsed time as a fraction of the budget, capped at one
+	double fractionUsed() const;
+
+	// A new deadline, starting now, that gets the specified fraction
+	// of the time remaining on this one. It starts with this
+	// deadline's throughput measurements.
+	Deadline phase(double fraction) const;
+
+	// Count units of work as done. The time since the last call to
+	// startWork or recordWork (or since construction) is taken as the
+	// time they took.
+	void startWork();
+	void recordWork(int units);
+
+	// Measured units per second, or zero if nothing has been measured.
+	double unitsPerSecond() const;
+
+	// How many units fit in the specified number of seconds at
+	// the measured rate; fallback if nothing has been measured yet.
+	int unitsFitting(double seconds, int fallback) const;
 
 private:
-	time_t m_startTime;
+	Stopwatch m_stopwatch;
+	double m_budget;
+
+	double m_lastMark;
+	long m_measuredUnits;
+	double m_measuredSeconds;
 };
 
+inline double Deadline::budget() const
+{
+	return m_budget;
+}
+
+inline double Deadline::elapsed() const
+{
+	return m_stopwatch.elapsedSeconds();
+}
+
+inline bool Deadline::passed() const
+{
+	return elapsed() >= m_budget;
+}
+
 }
 
 #endif
@@ -0,0 +1,117 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "compactmove.h"
+
+using namespace Quackle;
+
+CompactMoveList::CompactMoveList()
+{
+}
+
+void CompactMoveList::push_back(const Move &move)
+{
+	CompactMove compact;
+	compact.equity = move.equity;
+	compact.score = move.score;
+	compact.startrow = move.startrow;
+	compact.startcol = move.startcol;
+	compact.letters = m_letters.size();
+	m_moves.push_back(compact);
+
+	const LetterString &tiles = move.tiles();
+	m_letters.push_back(move.action | (move.horizontal? Horizontal : 0) | (move.isBingo? Bingo : 0));
+	m_letters.push_back(tiles.length());
+	m_letters.insert(m_letters.end(), tiles.begin(), tiles.end());
+}
+
+Move CompactMoveList::move(const CompactMove &compact) const
+{
+	const Letter flags = m_letters[compact.letters];
+
+	Move ret;
+	ret.action = (Move::Action)(flags & ActionMask);
+	ret.horizontal = (flags & Horizontal) != 0;
+	ret.isBingo = (flags & Bingo) != 0;
+	ret.startrow = compact.startrow;
+	ret.startcol = compact.startcol;
+	ret.score = compact.score;
+	ret.equity = compact.equity;
+	ret.setTiles(tiles(compact));
+	return ret;
+}
+
+const LetterString CompactMoveList::tiles(const CompactMove &compact) const
+{
+	return LetterString((const char *)&m_letters[compact.letters + 2], m_letters[compact.letters + 1]);
+}
+
+MoveList CompactMoveList::moves() const
+{
+	MoveList ret;
+	ret.reserve(m_moves.size());
+
+	for (vector<CompactMove>::const_iterator it = m_moves.begin(); it != m_moves.end(); ++it)
+		ret.push_back(move(*it));
+
+	return ret;
+}
+
+MoveList CompactMoveList::best(int count)
+{
+	const int number = max(0, min(count, (int)m_moves.size()));
+
+	// equityComparator orders all distinct moves, so this is the order
+	// a stable sort would give
+	partial_sort(m_moves.begin(), m_moves.begin() + number, m_moves.end(), [this](const CompactMove &compact1, const CompactMove &compact2)
+	{
+		return equityLess(compact2, compact1);
+	});
+
+	MoveList ret;
+	ret.reserve(number);
+	for (int i = 0; i < number; ++i)
+		ret.push_back(move(m_moves[i]));
+
+	return ret;
+}
+
+bool CompactMoveList::equityLess(const CompactMove &compact1, const CompactMove &compact2) const
+{
+	if (compact1.equity != compact2.equity)
+		return compact1.equity < compact2.equity;
+
+	// MoveList::wordPosComparator from here on
+	if (compact1.startrow != compact2.startrow)
+		return compact1.startrow < compact2.startrow;
+
+	if (compact1.startcol != compact2.startcol)
+		return compact1.startcol < compact2.startcol;
+
+	const bool horizontal1 = isHorizontal(compact1);
+	const bool horizontal2 = isHorizontal(compact2);
+	if (horizontal1 != horizontal2)
+		return horizontal1 < horizontal2;
+
+	if (compact1.score != compact2.score)
+		return compact1.score < compact2.score;
+
+	return tiles(compact1) < tiles(compact2);
+}
@@ -0,0 +1,123 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_COMPACTMOVE_H
+#define QUACKLE_COMPACTMOVE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "alphabetparameters.h"
+#include "move.h"
+
+using namespace std;
+
+namespace Quackle
+{
+
+// A move as the generator records it, in 16 bytes: its equity, score
+// and position, and where the rest of it is kept in the letters of the
+// CompactMoveList holding it. Thousands of these are sorted and
+// filtered in a position, moving a fraction of the memory Moves would.
+struct CompactMove
+{
+	double equity;
+	int16_t score;
+	uint8_t startrow;
+	uint8_t startcol;
+
+	// offset of the move's flags, tile count and tiles
+	uint32_t letters;
+};
+
+// Moves stored compactly, converted to and from Moves one at a time.
+// Only what generated moves have is kept -- action, position,
+// direction, tiles, score, bingoness and equity; pretty tiles, wins,
+// score additions and challenged phoniness are not.
+class CompactMoveList
+{
+public:
+	CompactMoveList();
+
+	void clear();
+	bool empty() const;
+	size_t size() const;
+
+	void push_back(const Move &move);
+
+	Move move(const CompactMove &compact) const;
+	const LetterString tiles(const CompactMove &compact) const;
+	bool isHorizontal(const CompactMove &compact) const;
+
+	// all moves, in the order they were added
+	MoveList moves() const;
+
+	// The best moves by MoveList::equityComparator, best first, as
+	// MoveList::sort(list, MoveList::Equity) would put them; only
+	// those are sorted and converted.
+	MoveList best(int count);
+
+	// removes the moves remove returns true for, keeping the order of
+	// the others
+	template <typename Predicate> void removeIf(Predicate remove);
+
+	// MoveList::equityComparator of compact moves
+	bool equityLess(const CompactMove &compact1, const CompactMove &compact2) const;
+
+private:
+	enum Flags { ActionMask = 0x0f, Horizontal = 0x10, Bingo = 0x20 };
+
+	vector<CompactMove> m_moves;
+	vector<Letter> m_letters;
+};
+
+inline void CompactMoveList::clear()
+{
+	m_moves.clear();
+	m_letters.clear();
+}
+
+inline bool CompactMoveList::empty() const
+{
+	return m_moves.empty();
+}
+
+inline size_t CompactMoveList::size() const
+{
+	return m_moves.size();
+}
+
+inline bool CompactMoveList::isHorizontal(const CompactMove &compact) const
+{
+	return (m_letters[compact.letters] & Horizontal) != 0;
+}
+
+template <typename Predicate> void CompactMoveList::removeIf(Predicate remove)
+{
+	vector<CompactMove>::iterator kept = m_moves.begin();
+	for (vector<CompactMove>::iterator it = m_moves.begin(); it != m_moves.end(); ++it)
+		if (!remove(*it))
+			*kept++ = *it;
+
+	// the letters of removed moves stay until the list is cleared
+	m_moves.erase(kept, m_moves.end());
+}
+
+}
+
+#endif
@@ -35,6 +35,9 @@ struct ComputerParameters
 
     // when simming, use likely rack leaves for opponent based on their previous play
     bool inferring;
+
+	// how simulations play the plies after their candidates
+	RolloutPolicy rolloutPolicy;
 };
 
 class ComputerDispatch
@@ -154,6 +157,7 @@ inline const GamePosition &ComputerPlayer::currentPosition() const
 inline void ComputerPlayer::setParameters(const ComputerParameters &parameters)
 {
 	m_parameters = parameters;
+	m_simulator.setRolloutPolicy(m_parameters.rolloutPolicy);
 }
 
 inline const ComputerParameters &ComputerPlayer::parameters() const
@@ -21,6 +21,7 @@
 #include "computerplayer.h"
 #include "bogowinplayer.h"
 #include "endgameplayer.h"
+#include "montecarloplayer.h"
 #include "resolvent.h"
 
 using namespace Quackle;
@@ -49,6 +50,7 @@ ComputerPlayerCollection ComputerPlayerCollection::fullCollection()
 	ret.addPlayer(new FiveMinutePlayer());
 	ret.addPlayer(new TwentySecondPlayer());
 	ret.addPlayer(new TorontoPlayer());
+	ret.addPlayer(new MonteCarloPlayer());
         //ret.addPlayer(new InferringPlayer());
 	return ret;
 }
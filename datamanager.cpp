@@ -18,6 +18,7 @@
 
 #include <time.h>
 #include <sys/stat.h>
+#include <atomic>
 #include <cstdlib>
 
 #include "catchall.h"
@@ -36,14 +37,20 @@
 using namespace Quackle;
 
 DataManager *DataManager::m_self = 0;
+thread_local DataManager *DataManager::m_threadSelf = 0;
 
 DataManager::DataManager()
 	: m_evaluator(0), m_parameters(0), m_alphabetParameters(0), m_boardParameters(0), m_lexiconParameters(0), m_strategyParameters(0)
 {
-	m_self = this;
 	setAppDataDirectory(".");
 	setUserDataDirectory(".");
-    seedRandomNumbers((int)time(NULL));
+
+	if (!m_self)
+		m_self = this;
+
+	// contexts set up in the same second still draw differently
+	static atomic<unsigned int> contexts(0);
+	seedRandomNumbers((unsigned int)time(NULL) + contexts++);
 
 	m_alphabetParameters = new EnglishAlphabetParameters;
 	m_evaluator = new CatchallEvaluator;
@@ -63,6 +70,11 @@ DataManager::~DataManager()
 	delete m_strategyParameters;
 
 	cleanupComputerPlayers();
+
+	if (m_threadSelf == this)
+		m_threadSelf = 0;
+	if (m_self == this)
+		m_self = 0;
 }
 
 bool DataManager::isGood() const
@@ -176,10 +188,14 @@ string DataManager::makeDataFilename(const string &subDirectory, const string &f
 
 void DataManager::seedRandomNumbers(unsigned int seed)
 {
-    srand(seed);
+	lock_guard<mutex> lock(m_randomMutex);
+	m_randomEngine.seed(seed);
 }
 
 int DataManager::randomNumber()
 {
-	return rand();
+	lock_guard<mutex> lock(m_randomMutex);
+
+	// RAND_MAX + 1 is a power of two, so this is unbiased
+	return m_randomEngine() % ((unsigned int)RAND_MAX + 1);
 }
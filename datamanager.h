@@ -19,6 +19,8 @@
 #ifndef QUACKLE_DATAMANAGER_H
 #define QUACKLE_DATAMANAGER_H
 
+#include <mutex>
+#include <random>
 #include <string>
 
 #include "playerlist.h"
@@ -41,7 +43,13 @@ namespace Quackle
 // General singleton type that will be around whenever
 // you use libquackle.
 // It provides access to lexica (todo), random numbers,
-// and all parameters for a game
+// and all parameters for a game. Each data manager draws random
+// numbers from its own generator.
+// The first data manager constructed is the process-wide default.
+// Further data managers are independent engine contexts (with their
+// own lexicon, strategy, evaluator etc) that a thread can install
+// for itself with DataManagerScope; self() and all QUACKLE_* macros
+// then resolve to that context on that thread only.
 
 class AlphabetParameters;
 class BoardParameters;
@@ -54,15 +62,23 @@ class StrategyParameters;
 class DataManager
 {
 public:
-	// sets up singleton, seeds random number generator,
+	// sets up singleton if there is none yet,
+	// seeds the random number generator from the time,
 	// and creates default parameter instances
 	DataManager();
 
 	~DataManager();
 
+	// the data manager installed on this thread, or else
+	// the process-wide default
 	static DataManager *self();
 	static bool exists();
 
+	// Install dataManager as the data manager of the calling thread.
+	// Pass 0 to fall back to the process-wide default again.
+	static void setThreadDataManager(DataManager *dataManager);
+	static DataManager *threadDataManager();
+
 	// Are we in shape to run a game?
 	// Makes sure there's a lexicon at least.
 	bool isGood() const;
@@ -121,11 +137,15 @@ public:
 	void setUserDataDirectory(string directory) { m_userDataDirectory = directory; }
 	string userDataDirectory() { return m_userDataDirectory; }
 
+	// Random numbers from 0 to RAND_MAX. A context seeded alike draws
+	// alike on whatever thread, as long as no other thread draws from
+	// it meanwhile; threads sharing a context take turns drawing.
 	void seedRandomNumbers(unsigned int seed);
 	int randomNumber();
 
 private:
 	static DataManager *m_self;
+	static thread_local DataManager *m_threadSelf;
 
 	bool fileExists(const string &filename);
 
@@ -144,16 +164,29 @@ private:
 	StrategyParameters *m_strategyParameters;
 
 	PlayerList m_computerPlayers;
+
+	mt19937 m_randomEngine;
+	mutex m_randomMutex;
 };
 
 inline DataManager *DataManager::self()
 {
-	return m_self;
+	return m_threadSelf? m_threadSelf : m_self;
 }
 
 inline bool DataManager::exists()
 {
-	return m_self != 0;
+	return self() != 0;
+}
+
+inline void DataManager::setThreadDataManager(DataManager *dataManager)
+{
+	m_threadSelf = dataManager;
+}
+
+inline DataManager *DataManager::threadDataManager()
+{
+	return m_threadSelf;
 }
 
 inline Evaluator *DataManager::evaluator()
@@ -191,6 +224,28 @@ inline const PlayerList &DataManager::computerPlayers() const
 	return m_computerPlayers;
 }
 
+// Installs a data manager on the calling thread for the lifetime
+// of the scope, restoring whatever was installed before afterwards.
+// Load a context's lexicon and strategy with it installed, as
+// they are read using the alphabet of the current data manager.
+class DataManagerScope
+{
+public:
+	DataManagerScope(DataManager *dataManager)
+		: m_previous(DataManager::threadDataManager())
+	{
+		DataManager::setThreadDataManager(dataManager);
+	}
+
+	~DataManagerScope()
+	{
+		DataManager::setThreadDataManager(m_previous);
+	}
+
+private:
+	DataManager *m_previous;
+};
+
 }
 
 #endif
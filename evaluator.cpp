@@ -31,6 +31,12 @@ double Evaluator::equity(const GamePosition &position, const Move &move) const
 	return move.effectiveScore();
 }
 
+double Evaluator::equityWithLeaveValue(const GamePosition &position, const Move &move, double leaveValue) const
+{
+	(void) leaveValue;
+	return equity(position, move);
+}
+
 double Evaluator::playerConsideration(const GamePosition &position, const Move &move) const
 {
 	(void) position;
@@ -58,6 +64,11 @@ double ScorePlusLeaveEvaluator::equity(const GamePosition &position, const Move
 	return playerConsideration(position, move) + sharedConsideration(position, move) + move.effectiveScore();
 }
 
+double ScorePlusLeaveEvaluator::equityWithLeaveValue(const GamePosition &position, const Move &move, double leaveValue) const
+{
+	return leaveValue + sharedConsideration(position, move) + move.effectiveScore();
+}
+
 double ScorePlusLeaveEvaluator::playerConsideration(const GamePosition &position, const Move &move) const
 {
 	return leaveValue((position.currentPlayer().rack() - move).tiles());
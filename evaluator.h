@@ -39,6 +39,13 @@ public:
 	// suitable for equity field of move. Rack must be alphabetized.
 	virtual double equity(const GamePosition &position, const Move &move) const;
 
+	// Equity of move when leaveValue(), of the tiles the move leaves on
+	// the rack, is known already, as the generator knows it for every
+	// move of a rack. Evaluators that count the leave value in equity
+	// use the one given rather than working it out again; by default
+	// this is just equity().
+	virtual double equityWithLeaveValue(const GamePosition &position, const Move &move, double leaveValue) const;
+
 	virtual double playerConsideration(const GamePosition &position, const Move &move) const;
 	virtual double sharedConsideration(const GamePosition &position, const Move &move) const;
 
@@ -53,6 +60,10 @@ public:
 	// Evaluator that always returns a score+leave equity
 	virtual double equity(const GamePosition &position, const Move &move) const;
 
+	// playerConsideration() is the leave value, so subclasses that
+	// change it must override this too
+	virtual double equityWithLeaveValue(const GamePosition &position, const Move &move, double leaveValue) const;
+
 	virtual double playerConsideration(const GamePosition &position, const Move &move) const;
 	virtual double sharedConsideration(const GamePosition &position, const Move &move) const;
 
@@ -34,6 +34,9 @@ public:
 	const GaddagNode *firstChild() const;
 	const GaddagNode *nextSibling() const;
 	const GaddagNode *child(Letter l) const;
+
+	// hints that the children of this node are about to be read
+	void prefetchChildren() const;
 private:
 	unsigned char data[4];
 };
@@ -61,6 +64,17 @@ GaddagNode::firstChild() const
 	}
 }
 
+inline void
+GaddagNode::prefetchChildren() const
+{
+#if defined(__GNUC__)
+	const GaddagNode *children = firstChild();
+	if (children) {
+		__builtin_prefetch(children);
+	}
+#endif
+}
+
 /*
 inline const GaddagNode *
 GaddagNode::firstChild() const
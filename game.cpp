@@ -248,9 +248,10 @@ GamePosition::GamePosition()
 	resetBag();
 }
 
-void GamePosition::kibitz(int nmoves)
+void GamePosition::kibitz(int nmoves, const GenerationContext *context)
 {
 	Generator generator(*this);
+	generator.setContext(context);
 	generator.kibitz(nmoves, exchangeAllowed()? Generator::RegularKibitz : Generator::CannotExchange);
 
 	m_moves = generator.kibitzList();
@@ -259,9 +260,21 @@ void GamePosition::kibitz(int nmoves)
 		ensureMovePrettiness(it);
 }
 
-const Move &GamePosition::staticBestMove()
+const Move &GamePosition::staticBestMove(const GenerationContext *context)
 {
-	kibitz(1);
+	kibitz(1, context);
+	return m_moves.back();
+}
+
+const Move &GamePosition::highestScoringMove(const GenerationContext *context)
+{
+	Generator generator(*this);
+	generator.setContext(context);
+	generator.kibitz(1, Generator::ScoreOnly);
+
+	m_moves = generator.kibitzList();
+	ensureMovePrettiness(m_moves.back());
+
 	return m_moves.back();
 }
 
@@ -339,6 +352,13 @@ int GamePosition::validateMove(const Move &move) const
 
 		if (move.action == Move::Place)
 		{
+			// the board only has its own squares to look at
+			if (!m_board.isOnBoard(move))
+			{
+				ret |= InvalidPlace;
+				break;
+			}
+
 			// Place action -- ensure the word connects to others
 			if (!isConnected(move))
 				ret |= InvalidPlace;
@@ -34,6 +34,7 @@ namespace Quackle
 {
 
 class ComputerPlayer;
+class GenerationContext;
 class History;
 
 class HistoryLocation
@@ -93,8 +94,9 @@ public:
 	// ALSO GET COPIED!!!!!!!!!!!!!!!!!!!!!!
 	const GamePosition &operator=(const GamePosition &position);
 
-	// kibitz up to nmoves best moves; stored in move list
-	void kibitz(int nmoves = 10);
+	// kibitz up to nmoves best moves; stored in move list.
+	// If context is given it must have been prepared from our board.
+	void kibitz(int nmoves = 10, const GenerationContext *context = 0);
 
 	// get what's in the move list
 	const MoveList &moves() const;
@@ -103,7 +105,11 @@ public:
 
 	// kibitz (destroying previous move list)
 	// and return the best move based on static evaluation
-	const Move &staticBestMove();
+	const Move &staticBestMove(const GenerationContext *context = 0);
+
+	// kibitz (destroying previous move list) by score alone,
+	// not valuing leaves, and return the highest scoring move
+	const Move &highestScoringMove(const GenerationContext *context = 0);
 
 	// erase a move from move list that equals move
 	void removeMove(const Move &move);
@@ -0,0 +1,259 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "datamanager.h"
+#include "generationcontext.h"
+#include "lexiconparameters.h"
+
+using namespace Quackle;
+
+GenerationContext::GenerationContext()
+	: m_board(0, 0), m_isForGaddag(false), m_isPrepared(false)
+{
+}
+
+void GenerationContext::prepare(const Board &board)
+{
+	m_board = board;
+	m_isForGaddag = QUACKLE_LEXICON_PARAMETERS->hasGaddag();
+
+	m_anchors.clear();
+	findAnchors(m_board, m_isForGaddag, &m_anchors);
+
+	m_isPrepared = true;
+}
+
+void GenerationContext::clear()
+{
+	m_board = Board(0, 0);
+	m_anchors.clear();
+	m_isPrepared = false;
+}
+
+void GenerationContext::findAnchors(const Board &board, bool forGaddag, AnchorList *anchors)
+{
+	if (forGaddag)
+		findGaddagAnchors(board, anchors);
+	else
+		findDawgAnchors(board, anchors);
+}
+
+void GenerationContext::findGaddagAnchors(const Board &board, AnchorList *anchors)
+{
+	for (int row = 0; row < board.height(); row++) {
+		for (int col = 0; col < board.width(); col++) {
+
+			// horizontal plays
+			bool anchor = false;
+			if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, col)) && !board.vcross(row, col).all()) {
+				if (col == 0) {
+					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, col + 1))) {
+						anchor = true;
+					}
+				}
+				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, col - 1))) {
+					if (col == board.width() - 1) {
+						anchor = true;
+					}
+					else {
+						if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, col + 1))) {
+							anchor = true;
+						}
+					}
+				}
+			}
+			else if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, col))) {
+				if (col == board.width() - 1) {
+					anchor = true;
+				}
+				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, col + 1))) {
+					anchor = true;
+				}
+			}
+
+			if (anchor) {
+				int k = 0;
+				for (int i = col; i >= 0; i--) { // skip over filled sqs
+					if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, i))) {
+						k++;
+					} else {
+						i = -1;
+					}
+				}
+				for (int i = col - k - 1; i >= 0; i--) {
+					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, i)) && board.vcross(row, i).all()) {
+						if (i == 0) {
+							k++;
+						}
+						else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, i - 1))) {
+							k++;
+						}
+					}
+					else {
+						i = -1;
+					}
+				}
+
+				Anchor found = { row, col, true, k };
+				anchors->push_back(found);
+			}
+
+			// vertical plays
+			anchor = false;
+			if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, col)) && !board.hcross(row, col).all()) {
+				if (row == 0) {
+					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row + 1, col))) {
+						anchor = true;
+					}
+				}
+				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row - 1, col))) {
+					if (row == board.height() - 1) {
+						anchor = true;
+					}
+					else {
+						if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row + 1, col))) {
+							anchor = true;
+						}
+					}
+				}
+			}
+			else if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, col))) {
+				if (row == board.height() - 1) {
+					anchor = true;
+				}
+				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row + 1, col))) {
+					anchor = true;
+				}
+			}
+
+			if (anchor) {
+				int k = 0;
+				for (int i = row; i >= 0; i--) {
+					if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(i, col))) {
+						k++;
+					} else {
+						i = -1;
+					}
+				}
+				for (int i = row - k - 1; i >= 0; i--) {
+					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(i, col)) && board.hcross(i, col).all()) {
+						if (i == 0) {
+							k++;
+						}
+						else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(i - 1, col))) {
+							k++;
+						}
+					}
+					else {
+						i = -1;
+					}
+				}
+
+				Anchor found = { row, col, false, k };
+				anchors->push_back(found);
+			}
+		}
+	}
+}
+
+void GenerationContext::findDawgAnchors(const Board &board, AnchorList *anchors)
+{
+	for (int row = 0; row < board.height(); row++) {
+		for (int col = 0; col < board.width(); col++) {
+
+			// horizontal plays
+			bool anchor = false;
+			if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, col)) && !board.vcross(row, col).all()) {
+				if (col == 0) {
+					anchor = true;
+				}
+				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, col - 1))) {
+					anchor = true;
+				}
+			}
+			else if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, col))) {
+				if (col == 0) {
+					anchor = true;
+				}
+				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, col - 1))) {
+					anchor = true;
+				}
+			}
+
+			if (anchor) {
+				int k = 0;
+				for (int i = col - 1; i >= 0; i--)
+				{
+					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, i)) && board.vcross(row, i).all()) {
+						if (i == 0) {
+							k++;
+						}
+						else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, i - 1))) {
+							k++;
+						}
+					}
+					else {
+						i = -1;
+					}
+				}
+
+				Anchor found = { row, col, true, k };
+				anchors->push_back(found);
+			}
+
+			// vertical plays
+			anchor = false;
+			if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, col)) && !board.hcross(row, col).all()) {
+				if (row == 0) {
+					anchor = true;
+				}
+				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row - 1, col))) {
+					anchor = true;
+				}
+			}
+			else if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row, col))) {
+				if (row == 0) {
+					anchor = true;
+				}
+				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(row - 1, col))) {
+					anchor = true;
+				}
+			}
+
+			if (anchor) {
+				int k = 0;
+				for (int i = row - 1; i >= 0; i--) {
+					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(i, col)) && board.hcross(i, col).all()) {
+						if (i == 0) {
+							k++;
+						}
+						else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board.letter(i - 1, col))) {
+							k++;
+						}
+					}
+					else {
+						i = -1;
+					}
+				}
+
+				Anchor found = { row, col, false, k };
+				anchors->push_back(found);
+			}
+		}
+	}
+}
@@ -0,0 +1,107 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_GENERATIONCONTEXT_H
+#define QUACKLE_GENERATIONCONTEXT_H
+
+#include <vector>
+
+#include "board.h"
+
+using namespace std;
+
+namespace Quackle
+{
+
+// a square from which the generator searches for plays
+struct Anchor
+{
+	int row;
+	int col;
+	bool horizontal;
+
+	// how many squares a play may extend before the anchor
+	int leftLimit;
+};
+
+typedef vector<Anchor> AnchorList;
+
+// The part of move generation that depends only on the board: its
+// cross-sets and its anchor squares. A simulation searches the same
+// board for many racks -- the reply to a candidate is searched once per
+// iteration -- so it prepares a context for that board once and hands
+// it to the generator every time.
+class GenerationContext
+{
+public:
+	GenerationContext();
+
+	// Computes the context of a board whose cross-sets are made, for
+	// the lexicon of the calling thread's data manager.
+	void prepare(const Board &board);
+
+	void clear();
+	bool isPrepared() const;
+
+	// the board the context was prepared from, cross-sets and all
+	const Board &board() const;
+
+	// in the order the generator would find them
+	const AnchorList &anchors() const;
+
+	// whether anchors() are those for searching the GADDAG rather
+	// than the DAWG
+	bool isForGaddag() const;
+
+	// Anchors of board, in row-major order with an anchor's
+	// horizontal search before its vertical one.
+	static void findAnchors(const Board &board, bool forGaddag, AnchorList *anchors);
+
+private:
+	static void findGaddagAnchors(const Board &board, AnchorList *anchors);
+	static void findDawgAnchors(const Board &board, AnchorList *anchors);
+
+	Board m_board;
+	AnchorList m_anchors;
+	bool m_isForGaddag;
+	bool m_isPrepared;
+};
+
+inline bool GenerationContext::isPrepared() const
+{
+	return m_isPrepared;
+}
+
+inline const Board &GenerationContext::board() const
+{
+	return m_board;
+}
+
+inline const AnchorList &GenerationContext::anchors() const
+{
+	return m_anchors;
+}
+
+inline bool GenerationContext::isForGaddag() const
+{
+	return m_isForGaddag;
+}
+
+}
+
+#endif
@@ -16,6 +16,7 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <math.h>
@@ -35,11 +36,12 @@ using namespace std;
 using namespace Quackle;
 
 Generator::Generator()
+	: m_context(0), m_scoreOnly(false)
 {
 }
 
 Generator::Generator(const GamePosition &position)
-	: m_position(position)
+	: m_position(position), m_context(0), m_scoreOnly(false)
 {
 }
 
@@ -51,6 +53,7 @@ void Generator::kibitz(int kibitzLength, int flags)
 {
 	// don't just record best move, unless kibitz length is one
     setrecordall(kibitzLength > 1);
+    m_scoreOnly = flags & ScoreOnly;
 
 	// perform actual kibitz
     findstaticbest(!(flags & CannotExchange));
@@ -65,52 +68,37 @@ void Generator::kibitz(int kibitzLength, int flags)
 
 	filterOutDuplicatePlays();
 
-	MoveList::sort(m_moveList, MoveList::Equity);
-
-	int i = 0;
-	MoveList::iterator end(m_moveList.end());
-    for (MoveList::iterator it = m_moveList.begin(); it != end; ++it, ++i)
-	{
-		if (i >= kibitzLength)
-			break;
-
-		m_kibitzList.push_back(*it);
-	}
+	m_kibitzList = m_moveList.best(kibitzLength);
 }
 
 void Generator::filterOutDuplicatePlays()
 {
 	map<int, bool> oneTilePlayMap;
-	for (MoveList::iterator it = m_moveList.begin(); it != m_moveList.end();)
+	m_moveList.removeIf([this, &oneTilePlayMap](const CompactMove &compact)
 	{
-		LetterString usedTiles = (*it).usedTiles();
-		if (usedTiles.size() == 1)
-		{
-			const LetterString &tiles = (*it).tiles();
-			int actualTileIndex = 0;
-			for (LetterString::const_iterator letterIt = tiles.begin(); letterIt != tiles.end(); ++letterIt, ++actualTileIndex)
-				if ((*letterIt) != QUACKLE_PLAYED_THRU_MARK)
-					break;
+		const LetterString tiles = m_moveList.tiles(compact);
+		LetterString usedTiles = String::usedTiles(tiles);
+		if (usedTiles.size() != 1)
+			return false;
 
-			const int row = (*it).startrow + ((*it).horizontal? 0 : actualTileIndex);
-			const int column = (*it).startcol + ((*it).horizontal? actualTileIndex : 0);
-			int key = row + QUACKLE_MAXIMUM_BOARD_SIZE * column + (QUACKLE_MAXIMUM_BOARD_SIZE * QUACKLE_MAXIMUM_BOARD_SIZE) * String::front(usedTiles);
+		int actualTileIndex = 0;
+		for (LetterString::const_iterator letterIt = tiles.begin(); letterIt != tiles.end(); ++letterIt, ++actualTileIndex)
+			if ((*letterIt) != QUACKLE_PLAYED_THRU_MARK)
+				break;
 
-			if (oneTilePlayMap.find(key) == oneTilePlayMap.end())
-			{
-				oneTilePlayMap[key] = true;
-				++it;
-			}
-			else
-			{
-				it = m_moveList.erase(it);
-			}
-		}
-		else
+		const bool horizontal = m_moveList.isHorizontal(compact);
+		const int row = compact.startrow + (horizontal? 0 : actualTileIndex);
+		const int column = compact.startcol + (horizontal? actualTileIndex : 0);
+		int key = row + QUACKLE_MAXIMUM_BOARD_SIZE * column + (QUACKLE_MAXIMUM_BOARD_SIZE * QUACKLE_MAXIMUM_BOARD_SIZE) * String::front(usedTiles);
+
+		if (oneTilePlayMap.find(key) == oneTilePlayMap.end())
 		{
-			++it;
+			oneTilePlayMap[key] = true;
+			return false;
 		}
-	}
+
+		return true;
+	});
 }
 
 void Generator::allCrosses()
@@ -603,275 +591,270 @@ UVString Generator::cross2string(const LetterBitset &cross)
    Gen(pos + 1, word, rack, NewArc)
  */
 
-void Generator::gordongoon(int pos, char L, LetterString word, const GaddagNode *node)
+// Gen and GoOn above, as one loop over the frames of m_gaddagStack
+// instead of by recursion. The word is spelled in place in m_gaddagWord,
+// square pos of it at pos + QUACKLE_MAXIMUM_BOARD_SIZE; frames further
+// down the stack only write squares further from the anchor, so a frame
+// finds its part of the word as it left it.
+void Generator::gordonsearch(const GaddagNode *root)
 {
-	//UVcout << "gordongoon(" << pos << ", " << L << ", " << word << ", " << newarc << ", " << oldarc << ")" << 
-	//        " horiz: " << m_gordonhoriz << endl;
+	int top = 0;
+	pushGaddagFrame(&top, GaddagFrame::Generate, 0, 0, QUACKLE_NULL_MARK, root);
 
-	if (pos <= 0) {
+	while (top > 0) {
+		GaddagFrame &frame = m_gaddagStack[top - 1];
 
 		int currow = m_anchorrow;
 		int curcol = m_anchorcol;
 
-		int leftrow = m_anchorrow;
-		int leftcol = m_anchorcol;
-
 		if (m_gordonhoriz) {
-			curcol += pos;
-			leftcol += pos - 1;
-		}          
+			curcol += frame.pos;
+		}
 		else {
-			currow += pos;
-			leftrow += pos - 1;
+			currow += frame.pos;
 		}
 
-		if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(currow, curcol))) {
-			L = QUACKLE_PLAYED_THRU_MARK;
-		}
+		switch (frame.stage) {
+		case GaddagFrame::Generate:
+			if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(currow, curcol))) {
+				frame.stage = GaddagFrame::Finished;
 
-		LetterString newWord;
-		newWord += L;
-		newWord += word;
+				Letter boardc = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(board().letter(currow, curcol));
 
-		bool emptyleft = true; 
-		bool roomtoleft = true;
-		bool atboardedge = false;
+				const GaddagNode *child = frame.node->child(boardc);
+				if (child) {
+					child->prefetchChildren();
+					pushGaddagFrame(&top, GaddagFrame::Placed, frame.pos, frame.leftEnd, board().letter(currow, curcol), child);
+				}
+				break;
+			}
 
-		if ((leftcol >= 0) && (leftrow >= 0)) {
-			if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(currow, curcol)) && QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(leftrow, leftcol))) {
-				roomtoleft = false;
+			if (m_gordonhoriz) {
+				frame.cross = board().vcross(currow, curcol);
+			}
+			else {
+				frame.cross = board().hcross(currow, curcol);
 			}
 
-			if (pos < -m_leftlimit) {
-				roomtoleft = false;
+			frame.child = frame.node->firstChild();
+			frame.used = QUACKLE_NULL_MARK;
+			frame.stage = GaddagFrame::TryTiles;
+			break;
+
+		case GaddagFrame::TryTiles: {
+			if (frame.used != QUACKLE_NULL_MARK) {
+				m_counts[frame.used]++;
+				m_laid--;
+				frame.used = QUACKLE_NULL_MARK;
 			}
 
-			if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(leftrow, leftcol))) {
-				emptyleft = false;
+			const GaddagNode *child = frame.child;
+			while (child && ((m_counts[child->letter()] <= 0) || !frame.cross.test(child->letter() - QUACKLE_FIRST_LETTER))) {
+				child = child->nextSibling();
 			}
-		}
-		else {
-			atboardedge = true;
-		}
 
-		if (node->isTerminal() && (roomtoleft) && (m_laid > 0)) {
-			// UVcout << "found a word or something " << word << " at " << pos << endl;
-			Move move;
-			move.action = Move::Place;
-			move.setTiles(newWord);
-			if (m_gordonhoriz) {
-				move.startrow = m_anchorrow;
-				move.startcol = m_anchorcol + pos;
+			if (!child || child->letter() == QUACKLE_GADDAG_SEPARATOR) {
+				frame.child = frame.node->firstChild();
+				frame.stage = GaddagFrame::TryBlanks;
+				break;
 			}
-			else {
-				move.startrow = m_anchorrow + pos;
-				move.startcol = m_anchorcol;
+
+			frame.child = child->nextSibling();
+			frame.used = child->letter();
+			m_counts[frame.used]--;
+			m_laid++;
+
+			child->prefetchChildren();
+			pushGaddagFrame(&top, GaddagFrame::Placed, frame.pos, frame.leftEnd, child->letter(), child);
+			break;
+		}
+
+		case GaddagFrame::TryBlanks: {
+			if (frame.used != QUACKLE_NULL_MARK) {
+				m_counts[QUACKLE_BLANK_MARK]++;
+				m_laid--;
+				frame.used = QUACKLE_NULL_MARK;
 			}
 
-			move.horizontal = m_gordonhoriz;
-			move.score = board().score(move, &move.isBingo);
-			move.equity = equity(move);
+			if (m_counts[QUACKLE_BLANK_MARK] < 1) {
+				--top;
+				break;
+			}
 
-			if (m_recordall) {
-				m_moveList.push_back(move);
+			const GaddagNode *child = frame.child;
+			while (child && child->letter() != QUACKLE_GADDAG_SEPARATOR && !frame.cross.test(child->letter() - QUACKLE_FIRST_LETTER)) {
+				child = child->nextSibling();
 			}
 
-			if (MoveList::equityComparator(best, move)) {
-				best = move;
+			if (!child || child->letter() == QUACKLE_GADDAG_SEPARATOR) {
+				--top;
+				break;
 			}
-			// UVcout << "found a move: " << move << " score: " << move.score << ", equity: " << move.equity << 
-			// " outputted by leftmoving loop" << endl;
-		}
 
-        if (roomtoleft && pos != -m_leftlimit && !atboardedge) {
-            gordongen(pos - 1, newWord, node);
-        }
+			frame.child = child->nextSibling();
+			frame.used = QUACKLE_BLANK_MARK;
+			m_counts[QUACKLE_BLANK_MARK]--;
+			m_laid++;
 
-        // UVcout << "looking for the delimiter" << endl;
+			child->prefetchChildren();
+			pushGaddagFrame(&top, GaddagFrame::Placed, frame.pos, frame.leftEnd, QUACKLE_ALPHABET_PARAMETERS->setBlankness(child->letter()), child);
+			break;
+		}
 
-        node = node->child(QUACKLE_GADDAG_SEPARATOR);
+		case GaddagFrame::Placed:
+			if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(currow, curcol))) {
+				m_gaddagWord[QUACKLE_MAXIMUM_BOARD_SIZE + frame.pos] = QUACKLE_PLAYED_THRU_MARK;
+			}
+			else {
+				m_gaddagWord[QUACKLE_MAXIMUM_BOARD_SIZE + frame.pos] = frame.letter;
+			}
 
-        // UVcout << "after all that, delimiter's newarc is " << newarc << endl;
-        int rightrow = m_anchorrow;
-        int rightcol = m_anchorcol;
+			if (frame.pos <= 0) {
+				// moving left
+				int leftrow = currow;
+				int leftcol = curcol;
 
-        if (m_gordonhoriz) {
-            rightcol++;
-        }          
-        else {
-            rightrow++;
-        }
+				if (m_gordonhoriz) {
+					leftcol--;
+				}
+				else {
+					leftrow--;
+				}
 
-        bool atrightedge = false;
+				bool emptyleft = true;
+				bool roomtoleft = true;
+				bool atboardedge = false;
 
-        if ((rightrow > board().height() - 1) || (rightcol > board().width() - 1)) {
-            atrightedge = true;
-        }
+				if ((leftcol >= 0) && (leftrow >= 0)) {
+					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(currow, curcol)) && QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(leftrow, leftcol))) {
+						roomtoleft = false;
+					}
 
-        if ((node != 0) && emptyleft && !atrightedge) {
-            gordongen(1, newWord, node);
-        }
-	} 
-	else {
-		// UVcout << "looking to the right" << endl;
+					if (frame.pos < -m_leftlimit) {
+						roomtoleft = false;
+					}
 
-		int currow = m_anchorrow;
-		int curcol = m_anchorcol;
-		int rightrow = m_anchorrow;
-		int rightcol = m_anchorcol;
+					if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(leftrow, leftcol))) {
+						emptyleft = false;
+					}
+				}
+				else {
+					atboardedge = true;
+				}
 
-		if (m_gordonhoriz) {
-			curcol += pos;
-			rightcol += pos + 1;
-		}          
-		else {
-			currow += pos;
-			rightrow += pos + 1;
-		}
+				if (frame.node->isTerminal() && (roomtoleft) && (m_laid > 0)) {
+					recordGaddagPlay(frame.pos, 0);
+				}
 
-		if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(currow, curcol))) {
-			word += QUACKLE_PLAYED_THRU_MARK;
-		}
-		else {
-			word += L;
-		}
+				// the separator, and the right, come after the left
+				int rightrow = m_anchorrow;
+				int rightcol = m_anchorcol;
 
-		bool roomtoright = true;
-		bool atboardedge = false;
+				if (m_gordonhoriz) {
+					rightcol++;
+				}
+				else {
+					rightrow++;
+				}
 
-		// UVcout << "rightsquare: " << (char)(rightcol + 'A') << rightrow + 1 << endl;
+				const bool atrightedge = (rightrow > board().height() - 1) || (rightcol > board().width() - 1);
 
-		if ((rightcol <= board().width() - 1) && (rightrow <= board().height() - 1)) {
-			if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(rightrow, rightcol))) {
-				roomtoright = false;
-				// UVcout << "can't record " << word << " here because of the " << board().letter(rightrow, rightcol) << endl;
+				frame.canGoRight = emptyleft && !atrightedge;
+				frame.stage = GaddagFrame::LeftSearched;
+
+				if (roomtoleft && frame.pos != -m_leftlimit && !atboardedge) {
+					pushGaddagFrame(&top, GaddagFrame::Generate, frame.pos - 1, frame.leftEnd, QUACKLE_NULL_MARK, frame.node);
+				}
 			}
 			else {
-				// UVcout << "yay! " << (char)(rightcol + 'A') << rightrow + 1 << " is empty!" << endl; 
-				// UVcout << board() << endl;
-			}
-		}
-		else {
-			// UVcout << "at board edge so i can maybe record " << word << endl;
-			atboardedge = true;
-		}
+				// moving right
+				int rightrow = currow;
+				int rightcol = curcol;
 
-		if (node->isTerminal() && (roomtoright) && (m_laid > 0)) {
-			// UVcout << "found a word or something " << word << " at " << pos << endl;
+				if (m_gordonhoriz) {
+					rightcol++;
+				}
+				else {
+					rightrow++;
+				}
 
-			Move move;
-			move.action = Move::Place;
-			move.setTiles(word);
+				bool roomtoright = true;
+				bool atboardedge = false;
 
-			if (m_gordonhoriz) {
-				move.startrow = m_anchorrow;
-				move.startcol = m_anchorcol - word.length() + pos + 1;
-			}
-			else {
-				move.startrow = m_anchorrow - word.length() + pos + 1;
-				move.startcol = m_anchorcol;
-			}
+				if ((rightcol <= board().width() - 1) && (rightrow <= board().height() - 1)) {
+					if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(rightrow, rightcol))) {
+						roomtoright = false;
+					}
+				}
+				else {
+					atboardedge = true;
+				}
 
-			move.horizontal = m_gordonhoriz;
-			move.score = board().score(move, &move.isBingo);
-			move.equity = equity(move);
+				if (frame.node->isTerminal() && (roomtoright) && (m_laid > 0)) {
+					recordGaddagPlay(frame.leftEnd, frame.pos);
+				}
 
-			if (m_recordall) {
-				m_moveList.push_back(move);
+				frame.stage = GaddagFrame::Finished;
+
+				if (!atboardedge) {
+					pushGaddagFrame(&top, GaddagFrame::Generate, frame.pos + 1, frame.leftEnd, QUACKLE_NULL_MARK, frame.node);
+				}
 			}
+			break;
 
-			if (MoveList::equityComparator(best, move)) {
-				best = move;
+		case GaddagFrame::LeftSearched: {
+			frame.stage = GaddagFrame::Finished;
+
+			const GaddagNode *separator = frame.node->child(QUACKLE_GADDAG_SEPARATOR);
+			if ((separator != 0) && frame.canGoRight) {
+				separator->prefetchChildren();
+				pushGaddagFrame(&top, GaddagFrame::Generate, 1, frame.pos, QUACKLE_NULL_MARK, separator);
 			}
-			// UVcout << "found a move: " << move << " score: " << move.score << ", equity: " << move.equity << 
-			//      " outputted by rightmoving loop" << endl;
+			break;
 		}
 
-		// UVcout << "newarc is " << newarc << endl;
-        if (!atboardedge) {
-            gordongen(pos + 1, word, node);
-        }
-        else {
-            // UVcout << "didn't go ahead because we were at board edge" << endl;
-        }
+		case GaddagFrame::Finished:
+			--top;
+			break;
+		}
 	}
 }
 
-void Generator::gordongen(int pos, const LetterString &word, const GaddagNode *node) 
+void Generator::pushGaddagFrame(int *top, GaddagFrame::Stage stage, int pos, int leftEnd, Letter letter, const GaddagNode *node)
 {
-	// UVcout << "gordongen(" << pos << ", " << word << ", " << i << ")" << " horiz: " << m_gordonhoriz << endl;
-
-	int currow = m_anchorrow;
-	int curcol = m_anchorcol;
+	GaddagFrame &frame = m_gaddagStack[(*top)++];
+	frame.stage = stage;
+	frame.pos = pos;
+	frame.leftEnd = leftEnd;
+	frame.letter = letter;
+	frame.node = node;
+}
 
-	if (m_gordonhoriz) {
-		curcol += pos;
-	}
-	else {
-		currow += pos;
-	}
+void Generator::recordGaddagPlay(int left, int right)
+{
+	Move move;
+	move.action = Move::Place;
+	move.setTiles(LetterString((const char *)&m_gaddagWord[QUACKLE_MAXIMUM_BOARD_SIZE + left], right - left + 1));
 
-	LetterBitset cross;
 	if (m_gordonhoriz) {
-		cross = board().vcross(currow, curcol);
+		move.startrow = m_anchorrow;
+		move.startcol = m_anchorcol + left;
 	}
 	else {
-		cross = board().hcross(currow, curcol);
+		move.startrow = m_anchorrow + left;
+		move.startcol = m_anchorcol;
 	}
 
-	if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(currow, curcol))) {
-		// UVcout << "gordongen sez a letter (" << board().letter(currow, curcol) << ") already on this square" << endl;
+	move.horizontal = m_gordonhoriz;
+	move.score = board().score(move, &move.isBingo);
+	move.equity = equity(move, leaveIndex());
 
-		Letter boardc = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(board().letter(currow, curcol));
-
-		const GaddagNode *child = node->child(boardc);
-		if (child) {
-			gordongoon(pos, board().letter(currow, curcol), word, child);
-		}
+	if (m_recordall) {
+		m_moveList.push_back(move);
 	}
 
-	else {
-		for (const GaddagNode* child = node->firstChild(); child; child = child->nextSibling()) {
-			Letter childLetter = child->letter();
-
-			if ((m_counts[childLetter] <= 0) 
-					|| !cross.test(childLetter - QUACKLE_FIRST_LETTER)) {
-				continue;
-			}
-
-			if (childLetter == QUACKLE_GADDAG_SEPARATOR) {
-				// UVcout << "ran into a delimiter" << endl;
-				break;
-			}
-
-			m_counts[childLetter]--;
-			m_laid++;
-			// UVcout << "    yeah that'll work" << endl;
-			gordongoon(pos, childLetter, word, child);
-			m_counts[childLetter]++;
-			m_laid--;
-
-		}
-		if (m_counts[QUACKLE_BLANK_MARK] >= 1) {
-			for (const GaddagNode* child = node->firstChild(); child; child = child->nextSibling()) {
-				Letter childLetter = child->letter();
-				// UVcout << "childLetter is " << (char)(arcc + 'A') << endl;
-
-				if (childLetter == QUACKLE_GADDAG_SEPARATOR) {
-					// UVcout << "ran into a delimiter" << endl;
-					break;
-				}
-
-				if (cross.test(childLetter - QUACKLE_FIRST_LETTER)) {
-					m_counts[QUACKLE_BLANK_MARK]--;
-					m_laid++;
-					// UVcout << "    yeah that'll work" << endl;
-					gordongoon(pos, QUACKLE_ALPHABET_PARAMETERS->setBlankness(childLetter), word, child);
-					m_counts[QUACKLE_BLANK_MARK]++;
-					m_laid--;
-				}
-			}
-		}
+	if (MoveList::equityComparator(best, move)) {
+		best = move;
 	}
 }
 
@@ -946,7 +929,7 @@ void Generator::extendright(const LetterString &partial, int i,
 						}
 						move.horizontal = horizontal;
 						move.score = board().score(move, &move.isBingo);
-						move.equity = equity(move);
+						move.equity = equity(move, leaveIndex() - m_leaveStrides[c]);
 
 						// i added this because m_laid is wrong and i don't want to break anything by fixing it :)
 						// will need to remember to add this bit to the DAGGAD code when we start using it again
@@ -1011,7 +994,7 @@ void Generator::extendright(const LetterString &partial, int i,
 						}
 						move.horizontal = horizontal;
 						move.score = board().score(move, &move.isBingo);
-						move.equity = equity(move);
+						move.equity = equity(move, leaveIndex() - m_leaveStrides[QUACKLE_BLANK_MARK]);
 
 						int laid = move.wordTilesWithNoPlayThru().length();
 						bool onetilevert = (!move.horizontal) && (laid == 1);
@@ -1102,7 +1085,7 @@ void Generator::extendright(const LetterString &partial, int i,
 					}
 					move.horizontal = horizontal;
 					move.score = board().score(move, &move.isBingo);
-					move.equity = equity(move);
+					move.equity = equity(move, leaveIndex());
 						
 					int laid = move.wordTilesWithNoPlayThru().length();
 					bool onetilevert = (!move.horizontal) && (laid == 1);
@@ -1192,259 +1175,136 @@ double Generator::equity(const Move &move) const
 	return QUACKLE_EVALUATOR->equity(m_position, move);
 }
 
-Move Generator::generate()
+double Generator::equity(const Move &move, int leaveIndex) const
 {
-#ifdef DEBUG_GENERATOR
-	UVcout << "generate called" << endl;
-#endif
+	if (m_scoreOnly)
+		return move.score;
 
-	for (int row = 0; row < board().height(); row++) {
-		for (int col = 0; col < board().width(); col++) {
+	return QUACKLE_EVALUATOR->equityWithLeaveValue(m_position, move, m_leaveValues[leaveIndex]);
+}
 
-			// generate horizontal plays
+void Generator::prepareLeaveValues()
+{
+	const LetterString &tiles = rack().tiles();
 
-			// what defines an anchor square?
+	char counts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
+	String::counts(tiles, counts);
 
-			bool anchor = false;
-			if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col)) && !board().vcross(row, col).all()) {
-				if (col == 0) {
-					anchor = true;
-				}
-				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col - 1))) {
-					anchor = true;
-				}
-			}
-			else if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col))) {
-				if (col == 0) {
-					anchor = true;
-				}
-				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col - 1))) {
-					anchor = true;
-				}
-			}
+	for (int i = 0; i < QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE; ++i)
+		m_leaveStrides[i] = 0;
 
-			if (anchor) {
-				int k = 0;
-				for (int i = col - 1; i >= 0; i--)
-				{
-					// UVcout << "board().vcross[" << row << "][" << i << "] = " << board().vcross(row, i) << endl;
-					
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, i)) && board().vcross(row, i).all()) {
-						if (i == 0) {
-							k++;
-						}
-						else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, i - 1))) {
-							k++;
-						}
-					}
-					else {
-						i = -1;
-					}
-				}
+	m_rackLetters.clear();
 
-#ifdef DEBUG_GENERATOR
-				UVcout << "looking horizontally with the " << QUACKLE_ALPHABET_PARAMETERS->userVisible(board().letter(row, col)) << " at " << row + 1 << (char)(col + 'A') << endl;
-				UVcout << "Apparently there are " << k << " empty spots to our left" << endl;
-#endif
+	// leaves aren't valued; every move is taken to leave the same
+	if (m_scoreOnly)
+	{
+		m_leaveValues.assign(1, 0);
+		return;
+	}
 
-				m_laid = 0;
-				leftpart(LetterString(), 1, k, row, col, 0, true);
-			}
+	int leaves = 1;
+	for (LetterString::const_iterator it = tiles.begin(); it != tiles.end(); ++it)
+	{
+		if (m_leaveStrides[(int)*it] != 0)
+			continue;
 
-			// generate vertical plays
+		m_rackLetters += *it;
+		m_leaveStrides[(int)*it] = leaves;
+		leaves *= counts[(int)*it] + 1;
+	}
 
-			// what defines an anchor square?
+	m_leaveValues.resize(leaves);
 
-			anchor = false;
-			if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col)) && !board().hcross(row, col).all()) {
-				if (row == 0) {
-					anchor = true;
-				}
-				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row - 1, col))) {
-					anchor = true;
-				}
-			}
-			else if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col))) {
-				if (row == 0) {
-					anchor = true;
-				}
-				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row - 1, col))) {
-					anchor = true;
-				}
+	for (int index = 0; index < leaves; ++index)
+	{
+		// Rack::unload takes away the first of the tiles of a letter, so
+		// a leave keeps the last ones, in the order they are on the rack;
+		// the evaluator sees just the leave that rack - move would be.
+		char kept[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
+		for (LetterString::const_iterator it = m_rackLetters.begin(); it != m_rackLetters.end(); ++it)
+			kept[(int)*it] = (index / m_leaveStrides[(int)*it]) % (counts[(int)*it] + 1);
+
+		LetterString leave;
+		for (int i = tiles.length() - 1; i >= 0; --i)
+		{
+			if (kept[(int)tiles[i]] > 0)
+			{
+				leave += tiles[i];
+				--kept[(int)tiles[i]];
 			}
+		}
+		reverse(leave.begin(), leave.end());
 
-			if (anchor) {
-				int k = 0;
-				for (int i = row - 1; i >= 0; i--) {
-					// UVcout << "board().vcross[" << row << "][" << i << "] = " << board().vcross(row, i) << endl;
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(i, col)) && board().hcross(i, col).all()) {
-						if (i == 0) {
-							k++;
-						}
-						else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(i - 1, col))) {
-							k++;
-						}
-					}
-					else {
-						i = -1;
-					}
-				}
+		m_leaveValues[index] = QUACKLE_EVALUATOR->leaveValue(leave);
+	}
+}
 
-#ifdef DEBUG_GENERATOR
-				UVcout << "looking vertically with the " << board().letter(row, col) << " at " << row + 1 << (char)(col + 'A') << endl;
-				UVcout << "Apparently there are " << k << " empty spots to our left" << endl;
-#endif
+int Generator::leaveIndex() const
+{
+	int ret = 0;
+	for (LetterString::const_iterator it = m_rackLetters.begin(); it != m_rackLetters.end(); ++it)
+		ret += m_counts[(int)*it] * m_leaveStrides[(int)*it];
+	return ret;
+}
 
-				m_laid = 0;
-				leftpart(LetterString(), 1, k, row, col, 0, false);
-			}
-		}
-	}
+int Generator::leaveIndex(const Move &move) const
+{
+	// the whole rack is the last leave
+	int ret = m_leaveValues.size() - 1;
 
-	return best;
+	const LetterString used = move.usedTiles();
+	for (LetterString::const_iterator it = used.begin(); it != used.end(); ++it)
+		ret -= m_leaveStrides[(int)*it];
+
+	return ret;
 }
 
-// TODO GET RID OF CODE DUPLICATION
-Move Generator::gordongenerate()
+const AnchorList &Generator::anchors(bool forGaddag, AnchorList *scratch) const
 {
-	for (int row = 0; row < board().height(); row++) {
-		for (int col = 0; col < board().width(); col++) {
-
-			// generate horizontal plays
-			// what defines an anchor square?
-			bool anchor = false;
-			if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col)) && !board().vcross(row, col).all()) {
-				if (col == 0) {
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col + 1))) {
-						anchor = true;
-					}
-				}
-				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col - 1))) {
-					if (col == board().width() - 1) {
-						anchor = true;
-					}
-					else {
-						if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col + 1))) {
-							anchor = true;
-						}
-					}
-				}
-			}
-			else if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col))) {
-				if (col == board().width() - 1) {
-					anchor = true;
-				}
-				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col + 1))) {
-					anchor = true;
-				}
-			}
+	if (m_context && m_context->isPrepared() && m_context->isForGaddag() == forGaddag)
+		return m_context->anchors();
 
-			if (anchor) {
-				int k = 0;
-				for (int i = col; i >= 0; i--) { // skip over filled sqs
-					if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, i))) {
-						k++;
-					} else {
-						i = -1;
-					}
-				}
-				for (int i = col - k - 1; i >= 0; i--) {
-					// UVcout << "board().vcross[" << row << "][" << i << "] = " << board().vcross(row, i) << endl;
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, i)) && board().vcross(row, i).all()) {
-						if (i == 0) {
-							k++;
-						}
-						else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, i - 1))) {
-							k++;
-						}
-					}
-					else {
-						i = -1;
-					}
-				}
-				// UVcout << "Apparently there are " << k << " empty spots to our left" << endl;
-				// leftpart("", 1, k, row, col, 0, true);
-
-				// UVcout << "looking horizontally with the " << board().letter(row, col) <<
-				//         " at " << row + 1 << (char)(col + 'A') << endl;
-
-				m_anchorrow = row;
-				m_anchorcol = col;
-				m_gordonhoriz = true;
-				m_laid = 0;
-				m_leftlimit = k;
-				gordongen(0, LetterString(), QUACKLE_LEXICON_PARAMETERS->gaddagRoot());
-			}
+	scratch->clear();
+	GenerationContext::findAnchors(m_position.board(), forGaddag, scratch);
+	return *scratch;
+}
 
-			// generate vertical plays
-			// what defines an anchor square?
+Move Generator::generate()
+{
+#ifdef DEBUG_GENERATOR
+	UVcout << "generate called" << endl;
+#endif
 
-			anchor = false;
-			if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col)) && !board().hcross(row, col).all()) {
-				if (row == 0) {
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row + 1, col))) {
-						anchor = true;
-					}
-				}
-				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row - 1, col))) {
-					if (row == board().height() - 1) {
-						anchor = true;
-					}
-					else {
-						if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row + 1, col))) {
-							anchor = true;
-						}
-					}
-				}
-			}
-			else if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col))) {
-				if (row == board().height() - 1) {
-					anchor = true;
-				}
-				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row + 1, col))) {
-					anchor = true;
-				}
-			}
+	AnchorList scratch;
+	const AnchorList &anchorList = anchors(/* for gaddag */ false, &scratch);
 
-			if (anchor) {
-				int k = 0;
-				for (int i = row; i >= 0; i--) {
-					if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(i, col))) {
-						k++;
-					} else {
-						i = -1;
-					}
-				}
-				for (int i = row - k - 1; i >= 0; i--) {
-					// UVcout << "board().vcross[" << row << "][" << i << "] = " << board().vcross(row, i) << endl;
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(i, col)) && board().hcross(i, col).all()) {
-						if (i == 0) {
-							k++;
-						}
-						else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(i - 1, col))) {
-							k++;
-						}
-					}
-					else {
-						i = -1;
-					}
-				}
+	for (AnchorList::const_iterator it = anchorList.begin(); it != anchorList.end(); ++it)
+	{
+#ifdef DEBUG_GENERATOR
+		UVcout << "looking " << ((*it).horizontal? "horizontally" : "vertically") << " with the " << QUACKLE_ALPHABET_PARAMETERS->userVisible(board().letter((*it).row, (*it).col)) << " at " << (*it).row + 1 << (char)((*it).col + 'A') << endl;
+		UVcout << "Apparently there are " << (*it).leftLimit << " empty spots to our left" << endl;
+#endif
 
-				// UVcout << "Apparently there are " << k << " empty spots to our left" << endl;
-				// leftpart("", 1, k, row, col, 0, false);
+		m_laid = 0;
+		leftpart(LetterString(), 1, (*it).leftLimit, (*it).row, (*it).col, 0, (*it).horizontal);
+	}
 
-				// UVcout << "looking vertically with the " << board().letter(row, col) <<
-				//         " at " << row + 1 << (char)(col + 'A') << endl;
+	return best;
+}
 
-				m_anchorrow = row;
-				m_anchorcol = col;
-				m_gordonhoriz = false;
-				m_laid = 0;
-				m_leftlimit = k;
-				gordongen(0, LetterString(), QUACKLE_LEXICON_PARAMETERS->gaddagRoot());
+Move Generator::gordongenerate()
+{
+	AnchorList scratch;
+	const AnchorList &anchorList = anchors(/* for gaddag */ true, &scratch);
 
-			}
-		}
+	for (AnchorList::const_iterator it = anchorList.begin(); it != anchorList.end(); ++it)
+	{
+		m_anchorrow = (*it).row;
+		m_anchorcol = (*it).col;
+		m_gordonhoriz = (*it).horizontal;
+		m_laid = 0;
+		m_leftlimit = (*it).leftLimit;
+		gordonsearch(QUACKLE_LEXICON_PARAMETERS->gaddagRoot());
 	}
 
 	return best;
@@ -1597,6 +1457,59 @@ void Generator::wordspit(int i, const LetterString &prefix, int flags)
 	}
 }
 
+void Generator::patternspit(int i, const LetterString &prefix, WordPattern::StateSet states, const WordPattern &pattern, int maximumLength)
+{
+	unsigned int p;
+	Letter c;
+	bool t;
+	bool lastchild;
+	bool british;
+	int playability;
+
+	const int length = prefix.length() + 1;
+
+	do
+	{
+		readFromDawg(i, p, c, t, lastchild, british, playability);
+		++i;
+
+		const WordPattern::StateSet nextStates = pattern.step(states, c);
+		if (nextStates == 0)
+			continue;
+
+		// use up a tile of the rack, a blank only if need be
+		Letter used = QUACKLE_NULL_MARK;
+		if (pattern.hasRack())
+		{
+			if (m_counts[c] > 0)
+				used = c;
+			else if (m_counts[QUACKLE_BLANK_MARK] > 0)
+				used = QUACKLE_BLANK_MARK;
+			else
+				continue;
+
+			m_counts[used]--;
+		}
+
+		if (t && pattern.accepts(nextStates) && length >= pattern.minimumLength())
+		{
+			WordWithInfo word;
+			word.wordLetterString = prefix + c;
+			word.british = british;
+			word.playability = playability;
+			m_wordspat.push_back(word);
+		}
+
+		const int shortestExtension = max(1, pattern.lettersToAccept(nextStates));
+		if (p != 0 && (maximumLength == 0 || length + shortestExtension <= maximumLength))
+			patternspit(p, prefix + c, nextStates, pattern, maximumLength);
+
+		if (used != QUACKLE_NULL_MARK)
+			m_counts[used]++;
+	}
+	while (!lastchild);
+}
+
 
 Move Generator::exchange()
 {
@@ -1616,7 +1529,7 @@ Move Generator::exchange()
 		move.action = Move::Exchange;
 		move.setTiles(String::alphabetize(thrown));
 		move.score = 0;
-		move.equity = equity(move);
+		move.equity = equity(move, leaveIndex(move));
 
 		if (throwmap.find(move.tiles()) == throwmap.end())
 		{
@@ -1639,6 +1552,7 @@ Move Generator::findstaticbest(bool canExchange)
 	m_moveList.clear();
 
 	setupCounts(rack().tiles());
+	prepareLeaveValues();
 
 	if (QUACKLE_LEXICON_PARAMETERS->hasSomething())
 	{
@@ -1662,7 +1576,7 @@ Move Generator::findstaticbest(bool canExchange)
 		}
 	}
 
-	if (canExchange)
+	if (canExchange && !m_scoreOnly)
 		exchange();
 
 	if (m_moveList.empty())
@@ -1800,7 +1714,7 @@ Move Generator::anagram()
 
 			move.score = board().score(move, &move.isBingo);
 
-			move.equity = equity(move);
+			move.equity = equity(move, leaveIndex(move));
 			// UVcout << move << " has equity " << move.equity << endl;
 
 			if (m_recordall)
@@ -1841,6 +1755,25 @@ WordList Generator::anagramLetters(const LetterString &letters, int flags)
 	return m_spat;
 }
 
+vector<WordWithInfo> Generator::matchingWords(const WordPattern &pattern)
+{
+	m_wordspat.clear();
+
+	if (!pattern.isValid() || !QUACKLE_LEXICON_PARAMETERS->hasDawg())
+		return m_wordspat;
+
+	if (pattern.hasRack())
+		setupCounts(pattern.rack());
+
+	// the DAWG lists children in letter order, so words come out sorted
+	patternspit(1, LetterString(), pattern.initialStates(), pattern, pattern.maximumLength());
+
+	for (vector<WordWithInfo>::iterator it = m_wordspat.begin(); it != m_wordspat.end(); ++it)
+		(*it).probability = Bag::probabilityOfDrawingFromFullBag((*it).wordLetterString);
+
+	return m_wordspat;
+}
+
 void Generator::storeWordInfo(WordWithInfo *wordWithInfo)
 {
 	if (!QUACKLE_LEXICON_PARAMETERS->hasSomething())
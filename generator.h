@@ -22,8 +22,11 @@
 #include <vector>
 
 #include "alphabetparameters.h"
+#include "compactmove.h"
 #include "game.h"
+#include "generationcontext.h"
 #include "move.h"
+#include "wordpattern.h"
 
 using namespace std;
 
@@ -66,7 +69,9 @@ public:
 	Generator(const Quackle::GamePosition &position);
 	~Generator();
 
-	enum KibitzFlags { RegularKibitz = 0x0000, CannotExchange = 0x0001 /*, OtherOption = 0x0002, OtherOption2 = 0x0004 */ };
+	// ScoreOnly ranks plays by score alone, without valuing leaves or
+	// looking at exchanges; the equity of each play is its score.
+	enum KibitzFlags { RegularKibitz = 0x0000, CannotExchange = 0x0001, ScoreOnly = 0x0002 /*, OtherOption2 = 0x0004 */ };
 
 	// kibitzLength = 1 means kibitz list is of length one, and contains
 	// only the best move, and allPossiblePlays() is invalid.
@@ -74,13 +79,18 @@ public:
 	void kibitz(int kibitzLength = 10, int flags = AnagramRearrange);
 
 	const MoveList &kibitzList();
-	const MoveList &allPossiblePlays();
+	MoveList allPossiblePlays() const;
 
 	// set generator to generate on this position
 	// (using current player's rack)
 	void setPosition(const GamePosition &position);
 	const GamePosition &position() const;
 
+	// Generate using what context knows about the board of the
+	// position rather than working it out again; context must have
+	// been prepared from that board, and must outlive the generator.
+	void setContext(const GenerationContext *context);
+
 	// place a move on the board; if regenerateCrosses is false,
 	// you'll need to call allCrosses if you want to make more plays
 	// on the board
@@ -94,6 +104,12 @@ public:
 	bool isAcceptableWord(const LetterString &word);
         WordList anagramLetters(const LetterString &letters, 
 				int flags = AnagramRearrange);
+
+	// Words of the lexicon matching pattern, in alphabetical order,
+	// with their playability and probability filled in. The DAWG is
+	// walked only down prefixes the pattern can still match.
+	vector<WordWithInfo> matchingWords(const WordPattern &pattern);
+
 	void storeWordInfo(WordWithInfo *wordWithInfo);
 	void storeExtensions(WordWithInfo *wordWithInfo);
 	void allCrosses();
@@ -108,6 +124,24 @@ private:
 	// passes on to the global evaluator
 	double equity(const Move &move) const;
 
+	// as above, for a move leaving the tiles of leaveIndex
+	double equity(const Move &move, int leaveIndex) const;
+
+	// The moves of a rack leave only so many different tiles between
+	// them -- 128 sets at most for seven tiles -- so the value of each
+	// is worked out once, before generating. A leave is indexed by how
+	// many it keeps of each letter of the rack, in mixed radix.
+	void prepareLeaveValues();
+
+	// index of the tiles m_counts has left
+	int leaveIndex() const;
+
+	// index of what move leaves of the whole rack
+	int leaveIndex(const Move &move) const;
+
+	// anchors from the context if it has them, else found in scratch
+	const AnchorList &anchors(bool forGaddag, AnchorList *scratch) const;
+
 	// i'll make these private very soon
 	// no you won't, olaugh :)
 	Move generate();
@@ -133,11 +167,42 @@ private:
 			int row, int col, int edge, bool horizontal);
 	void spit(int i, const LetterString &prefix, int flags);
 	void wordspit(int i, const LetterString &prefix, int flags);
+	void patternspit(int i, const LetterString &prefix, WordPattern::StateSet states, const WordPattern &pattern, int maximumLength);
 
 	LetterBitset gaddagFitbetween(const LetterString &pre, const LetterString &suf);
 	void gaddagAnagram(const GaddagNode *node, const LetterString &prefix, int flags);
-	void gordongen(int pos, const LetterString &word, const GaddagNode *node);
-	void gordongoon(int pos, char L, LetterString word, const GaddagNode *node);
+	// A square of the search from an anchor, standing in for a call
+	// of Gen (trying the children of node at pos) or of GoOn (having
+	// put letter, reaching node, at pos).
+	struct GaddagFrame
+	{
+		enum Stage { Generate, TryTiles, TryBlanks, Placed, LeftSearched, Finished };
+
+		Stage stage;
+		int pos;
+
+		// where the word starts when moving right
+		int leftEnd;
+
+		Letter letter;
+		const GaddagNode *node;
+
+		// Generate: the next child to try, what the cross allows, and
+		// the tile of the rack taken for the child being searched
+		const GaddagNode *child;
+		LetterBitset cross;
+		Letter used;
+
+		// Placed to the left: whether the word may go right afterwards
+		bool canGoRight;
+	};
+
+	// finds the plays through the anchor of m_anchorrow, m_anchorcol
+	void gordonsearch(const GaddagNode *root);
+	void pushGaddagFrame(int *top, GaddagFrame::Stage stage, int pos, int leftEnd, Letter letter, const GaddagNode *node);
+
+	// records the word of m_gaddagWord from left to right
+	void recordGaddagPlay(int left, int right);
 
 	void filterOutDuplicatePlays();
 
@@ -148,14 +213,19 @@ private:
 	Move best;
 
 	// keeps *all* moves
-	MoveList m_moveList;
+	CompactMoveList m_moveList;
 
 	// sorts and prunes into kibitzed list
 	MoveList m_kibitzList;
 
 	GamePosition m_position;
+	const GenerationContext *m_context;
 
 	char m_counts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
+
+	vector<double> m_leaveValues;
+	LetterString m_rackLetters;
+	int m_leaveStrides[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
 	int m_laid;
 	int m_leftlimit;
 
@@ -163,8 +233,13 @@ private:
 	vector<WordWithInfo> m_wordspat;
 
 	bool m_recordall;
+	bool m_scoreOnly;
 	bool m_gordonhoriz;
 	int m_anchorrow, m_anchorcol;
+
+	// a Generate and a Placed frame for each square a word can reach
+	GaddagFrame m_gaddagStack[4 * QUACKLE_MAXIMUM_BOARD_SIZE + 4];
+	Letter m_gaddagWord[2 * QUACKLE_MAXIMUM_BOARD_SIZE + 1];
 };
 
 
@@ -178,6 +253,11 @@ inline const GamePosition &Generator::position() const
 	return m_position;
 }
 
+inline void Generator::setContext(const GenerationContext *context)
+{
+	m_context = context;
+}
+
 inline Board &Generator::board()
 {
 	return m_position.underlyingBoardReference();
@@ -198,9 +278,9 @@ inline const MoveList &Generator::kibitzList()
 	return m_kibitzList;
 }
 
-inline const MoveList &Generator::allPossiblePlays()
+inline MoveList Generator::allPossiblePlays() const
 {
-	return m_moveList;
+	return m_moveList.moves();
 }
 
 }
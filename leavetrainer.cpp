@@ -0,0 +1,258 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "computerplayer.h"
+#include "datamanager.h"
+#include "evaluator.h"
+#include "game.h"
+#include "gameparameters.h"
+#include "leavetrainer.h"
+
+using namespace Quackle;
+
+namespace
+{
+
+// moves after which a game is abandoned
+const int maximumTurns = 500;
+
+}
+
+LeaveTrainer::LeaveTrainer(int numberOfThreads)
+	: m_numberOfThreads(numberOfThreads), m_gamesPerRound(10000), m_minimumObservations(50), m_tolerance(0.1)
+{
+	if (m_numberOfThreads <= 0)
+		m_numberOfThreads = max(1, (int)thread::hardware_concurrency());
+}
+
+bool LeaveTrainer::train(int maximumRounds)
+{
+	StrategyParameters *strategyParameters = QUACKLE_STRATEGY_PARAMETERS;
+
+	m_leaves = strategyParameters->superleaves();
+	m_rounds.clear();
+
+	for (int i = 1; i <= maximumRounds; ++i)
+	{
+		const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+		LeaveTrainingRound round;
+		round.round = i;
+		playRound(&round);
+		round.leaves = m_leaves.size();
+		round.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		// the next round plays with the values of this one
+		strategyParameters->setSuperleaves(m_leaves);
+
+		m_rounds.push_back(round);
+		if (m_progressCallback)
+			m_progressCallback(round);
+
+		if (round.change >= 0 && round.change < m_tolerance)
+			return true;
+	}
+
+	return false;
+}
+
+bool LeaveTrainer::save(const string &filename) const
+{
+	return StrategyParameters::saveSuperleaves(filename, m_leaves);
+}
+
+uint64_t LeaveTrainer::leaveKey(const LetterString &alphabetized)
+{
+	uint64_t ret = 0;
+	for (LetterString::const_iterator it = alphabetized.begin(); it != alphabetized.end(); ++it)
+		ret = (ret << 8) | (unsigned char)(*it);
+	return ret;
+}
+
+LetterString LeaveTrainer::leaveFromKey(uint64_t key)
+{
+	LetterString ret;
+	for (; key != 0; key >>= 8)
+		ret += (Letter)(key & 0xff);
+
+	// packed first letter most significant
+	reverse(ret.begin(), ret.end());
+	return ret;
+}
+
+void LeaveTrainer::playRound(LeaveTrainingRound *round)
+{
+	const int threads = max(1, min(m_numberOfThreads, m_gamesPerRound));
+
+	vector<LeaveTable> tables(threads);
+	vector<long> observations(threads, 0);
+
+	DataManager *dataManager = DataManager::self();
+	atomic<int> nextGame(0);
+
+	auto worker = [this, dataManager, &tables, &observations, &nextGame](int index)
+	{
+		DataManagerScope scope(dataManager);
+
+		long count = 0;
+		for (int game = nextGame++; game < m_gamesPerRound; game = nextGame++)
+			count += playGame(tables[index]);
+
+		observations[index] = count;
+	};
+
+	vector<thread> workers;
+	for (int i = 1; i < threads; ++i)
+		workers.push_back(thread(worker, i));
+
+	worker(0);
+
+	for (vector<thread>::iterator it = workers.begin(); it != workers.end(); ++it)
+		(*it).join();
+
+	LeaveTable &merged = tables[0];
+	for (int i = 1; i < threads; ++i)
+	{
+		for (LeaveTable::const_iterator it = tables[i].begin(); it != tables[i].end(); ++it)
+		{
+			LeaveStatistics &statistics = merged[it->first];
+			statistics.sum += it->second.sum;
+			statistics.count += it->second.count;
+		}
+
+		LeaveTable().swap(tables[i]);
+	}
+
+	round->games = m_gamesPerRound;
+	for (int i = 0; i < threads; ++i)
+		round->observations += observations[i];
+
+	round->change = updateLeaves(merged);
+}
+
+long LeaveTrainer::playGame(LeaveTable &table) const
+{
+	StaticPlayer player;
+
+	PlayerList players;
+	players.push_back(Player(MARK_UV("A"), Player::ComputerPlayerType, 0));
+	players.push_back(Player(MARK_UV("B"), Player::ComputerPlayerType, 1));
+
+	Game game;
+	game.setPlayers(players);
+	game.addPosition();
+
+	const int rackSize = QUACKLE_PARAMETERS->rackSize();
+	const unsigned int longestLeave = min(rackSize - 1, (int)sizeof(uint64_t));
+
+	// the leave each player kept last, while it's to be credited
+	uint64_t pendingLeave[2];
+	bool isPending[2] = { false, false };
+
+	long ret = 0;
+
+	for (int turn = 0; turn < maximumTurns && !game.currentPosition().gameOver(); ++turn)
+	{
+		const int id = game.currentPosition().currentPlayer().id();
+		const int bagSize = game.currentPosition().bag().size();
+		Rack leave(game.currentPosition().currentPlayer().rack());
+
+		const Move move = game.haveComputerPlay(&player);
+
+		const LetterString used = move.usedTiles();
+		leave.unload(used);
+		const LetterString alphabetized = String::alphabetize(leave.tiles());
+
+		// Only leaves topped up to a full rack with tiles to spare are
+		// counted; near the end of the game leaves are worth other things.
+		const bool isCounted = (move.action == Move::Place || move.action == Move::Exchange) && alphabetized.length() <= longestLeave && bagSize - (int)used.length() >= rackSize;
+
+		if (isPending[id])
+		{
+			double credit = move.score;
+			if (isCounted)
+				credit += QUACKLE_EVALUATOR->leaveValue(alphabetized);
+
+			LeaveStatistics &statistics = table[pendingLeave[id]];
+			statistics.sum += credit;
+			++statistics.count;
+			++ret;
+		}
+
+		isPending[id] = isCounted;
+		pendingLeave[id] = leaveKey(alphabetized);
+	}
+
+	return ret;
+}
+
+double LeaveTrainer::updateLeaves(const LeaveTable &merged)
+{
+	double baseline = 0;
+
+	LeaveTable::const_iterator empty = merged.find(0);
+	if (empty != merged.end() && empty->second.count > 0)
+	{
+		baseline = empty->second.sum / empty->second.count;
+	}
+	else
+	{
+		// no bingos with tiles to spare; judge by the average leave
+		double sum = 0;
+		long count = 0;
+		for (LeaveTable::const_iterator it = merged.begin(); it != merged.end(); ++it)
+		{
+			sum += it->second.sum;
+			count += it->second.count;
+		}
+
+		if (count > 0)
+			baseline = sum / count;
+	}
+
+	double squaredChange = 0;
+	long changed = 0;
+
+	for (LeaveTable::const_iterator it = merged.begin(); it != merged.end(); ++it)
+	{
+		if (it->first == 0 || it->second.count < m_minimumObservations)
+			continue;
+
+		const double value = it->second.sum / it->second.count - baseline;
+		const LetterString leave = leaveFromKey(it->first);
+
+		StrategyParameters::SuperLeavesMap::iterator previous = m_leaves.find(leave);
+		if (previous == m_leaves.end())
+		{
+			m_leaves.insert(StrategyParameters::SuperLeavesMap::value_type(leave, value));
+			continue;
+		}
+
+		squaredChange += (value - previous->second) * (value - previous->second);
+		++changed;
+		previous->second = value;
+	}
+
+	return changed > 0? sqrt(squaredChange / changed) : -1;
+}
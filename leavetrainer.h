@@ -0,0 +1,187 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_LEAVETRAINER_H
+#define QUACKLE_LEAVETRAINER_H
+
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "strategyparameters.h"
+
+using namespace std;
+
+namespace Quackle
+{
+
+// What one round of leave training did.
+struct LeaveTrainingRound
+{
+	LeaveTrainingRound() : round(0), games(0), observations(0), leaves(0), change(0), seconds(0) {}
+
+	int round;
+	long games;
+
+	// leaves kept by a player who then got to move again
+	long observations;
+
+	// leaves with trained values after the round
+	int leaves;
+
+	// root mean square of the change of values of leaves that had
+	// values before the round, in points; negative in the first round
+	// if there were none
+	double change;
+
+	double seconds;
+};
+
+// Computes superleaves by self-play. Each round, Static Players play
+// games using the leave values so far, and every leave a player keeps
+// is credited with what the player scores on its next turn plus the
+// value of the leave it keeps then. The value of a leave is its average
+// credit less that of keeping no tiles at all, which is what drawing a
+// full rack is worth. Rounds repeat until values stop changing.
+//
+// Games are spread over threads, each counting leaves in a table of its
+// own; the tables are only merged between rounds.
+class LeaveTrainer
+{
+public:
+	// numberOfThreads <= 0 means one thread per hardware thread
+	LeaveTrainer(int numberOfThreads = 0);
+
+	int numberOfThreads() const;
+
+	void setGamesPerRound(int games);
+	int gamesPerRound() const;
+
+	// Leaves seen fewer times than this in a round keep the value
+	// they had before it.
+	void setMinimumObservations(int observations);
+	int minimumObservations() const;
+
+	// root mean square change of values, in points, below which
+	// training has converged
+	void setTolerance(double tolerance);
+	double tolerance() const;
+
+	// called after each round
+	void setProgressCallback(const function<void (const LeaveTrainingRound &round)> &callback);
+
+	// Trains for up to maximumRounds rounds, starting from the
+	// superleaves of the strategy parameters of the calling thread's
+	// data manager. Trained values are installed there after every
+	// round. Returns true if training converged.
+	bool train(int maximumRounds);
+
+	const StrategyParameters::SuperLeavesMap &leaves() const;
+	const vector<LeaveTrainingRound> &rounds() const;
+
+	// writes the trained leaves as a superleaves file
+	bool save(const string &filename) const;
+
+private:
+	struct LeaveStatistics
+	{
+		LeaveStatistics() : sum(0), count(0) {}
+
+		double sum;
+		long count;
+	};
+
+	// alphabetized leaves packed a letter a byte; the empty leave is 0
+	typedef unordered_map<uint64_t, LeaveStatistics> LeaveTable;
+
+	static uint64_t leaveKey(const LetterString &alphabetized);
+	static LetterString leaveFromKey(uint64_t key);
+
+	void playRound(LeaveTrainingRound *round);
+
+	// returns the number of leaves credited
+	long playGame(LeaveTable &table) const;
+
+	// turns statistics of a round into values; returns the change
+	double updateLeaves(const LeaveTable &merged);
+
+	int m_numberOfThreads;
+	int m_gamesPerRound;
+	int m_minimumObservations;
+	double m_tolerance;
+	function<void (const LeaveTrainingRound &round)> m_progressCallback;
+
+	StrategyParameters::SuperLeavesMap m_leaves;
+	vector<LeaveTrainingRound> m_rounds;
+};
+
+inline int LeaveTrainer::numberOfThreads() const
+{
+	return m_numberOfThreads;
+}
+
+inline void LeaveTrainer::setGamesPerRound(int games)
+{
+	m_gamesPerRound = games;
+}
+
+inline int LeaveTrainer::gamesPerRound() const
+{
+	return m_gamesPerRound;
+}
+
+inline void LeaveTrainer::setMinimumObservations(int observations)
+{
+	m_minimumObservations = observations;
+}
+
+inline int LeaveTrainer::minimumObservations() const
+{
+	return m_minimumObservations;
+}
+
+inline void LeaveTrainer::setTolerance(double tolerance)
+{
+	m_tolerance = tolerance;
+}
+
+inline double LeaveTrainer::tolerance() const
+{
+	return m_tolerance;
+}
+
+inline void LeaveTrainer::setProgressCallback(const function<void (const LeaveTrainingRound &round)> &callback)
+{
+	m_progressCallback = callback;
+}
+
+inline const StrategyParameters::SuperLeavesMap &LeaveTrainer::leaves() const
+{
+	return m_leaves;
+}
+
+inline const vector<LeaveTrainingRound> &LeaveTrainer::rounds() const
+{
+	return m_rounds;
+}
+
+}
+
+#endif
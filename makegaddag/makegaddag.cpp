@@ -92,14 +92,15 @@ int main(int argc, char **argv)
 			UVcout << "not encodable without leftover: " << QuackleIO::Util::qstringToString(originalQString) << endl;
 	}
 	
-	UVcout << "Sorting " << factory.wordCount() << " words..." << endl;
-	factory.sortWords();
-
-	UVcout << "Generating nodes...";
+	UVcout << "Generating nodes for " << factory.wordCount() << " words...";
 	factory.generate();
 
 	UVcout << "Writing index...";
-	factory.writeIndex(outputFilename.toUtf8().constData());
+	if (!factory.writeIndex(outputFilename.toUtf8().constData()))
+	{
+		UVcout << endl << "Could not write " << QuackleIO::Util::qstringToString(outputFilename) << endl;
+		return 1;
+	}
 
 	UVcout << endl;
 
@@ -133,14 +133,17 @@ int main(int argc, char **argv)
 
 	UVcout << "encodable words: " << factory.encodableWords() << ", unencodable words: " << factory.unencodableWords() << endl;
 
-	UVcout << "nodelist.size(): " << factory.nodeCount() << endl;
-
 	factory.generate();
 	UVcout << "Compressed nodelist.size(): " << factory.nodeCount() << endl;
 
 	UVcout << "Hash: " << QString(QByteArray(factory.hashBytes(), 16).toHex()).toStdString() << endl;
 
-	factory.writeIndex("output.dawg");
+	if (!factory.writeIndex("output.dawg"))
+	{
+		UVcout << "Could not write output.dawg" << endl;
+		return 1;
+	}
+	factory.writeAlphagramIndex("output.alphagrams");
 
 	return 0;
 }
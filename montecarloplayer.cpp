@@ -0,0 +1,349 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "datamanager.h"
+#include "endgameplayer.h"
+#include "gameparameters.h"
+#include "montecarloplayer.h"
+#include "strategyparameters.h"
+
+using namespace Quackle;
+
+MonteCarloPlayer::MonteCarloPlayer(int numberOfThreads)
+	: m_numberOfThreads(numberOfThreads), m_maximumIterations(0), m_rootPlayer(0), m_iterations(0)
+{
+	m_name = MARK_UV("Monte Carlo Player");
+	m_id = 120;
+
+	m_parameters.secondsPerTurn = 20;
+	m_parameters.inferring = false;
+
+	m_exploration = 0.5;
+	m_priorVisits = 8;
+	m_wideningFactor = 2;
+	m_wideningExponent = 0.5;
+	m_maximumChildren = 24;
+
+	m_treePlies = 3;
+	m_rolloutPlies = 1;
+
+	if (m_numberOfThreads <= 0)
+		m_numberOfThreads = std::max(1, (int)thread::hardware_concurrency());
+}
+
+MonteCarloPlayer::~MonteCarloPlayer()
+{
+}
+
+ComputerPlayer *MonteCarloPlayer::clone()
+{
+	MonteCarloPlayer *ret = new MonteCarloPlayer(m_numberOfThreads);
+	ret->setMaximumIterations(m_maximumIterations);
+	return ret;
+}
+
+Move MonteCarloPlayer::move()
+{
+	return moves(1).back();
+}
+
+MoveList MonteCarloPlayer::moves(int nmoves)
+{
+	Deadline deadline(m_parameters.secondsPerTurn);
+	m_iterations = 0;
+
+	if (currentPosition().bag().empty())
+	{
+		signalFractionDone(0);
+		EndgamePlayer endgame;
+		endgame.setPosition(currentPosition());
+		return endgame.moves(nmoves);
+	}
+
+	currentPosition().kibitz(max(m_maximumChildren, nmoves));
+
+	// considered moves come first so that they are searched from the start
+	m_rootMoves = m_simulator.consideredMoves();
+	for (MoveList::const_iterator it = currentPosition().moves().begin(); it != currentPosition().moves().end(); ++it)
+		if (!m_rootMoves.contains(*it))
+			m_rootMoves.push_back(*it);
+
+	if (m_rootMoves.size() <= 1)
+		return m_rootMoves;
+
+	m_rootPlayer = currentPosition().currentPlayer().id();
+
+	m_nodes.clear();
+	m_nodes.push_back(Node(Move::createNonmove(), -1, 0));
+
+	for (MoveList::const_iterator it = m_simulator.consideredMoves().begin(); it != m_simulator.consideredMoves().end(); ++it)
+	{
+		m_nodes.push_back(Node(*it, m_rootPlayer, prior(currentPosition(), *it)));
+		m_nodes.front().children.push_back(m_nodes.size() - 1);
+	}
+
+	Game root;
+	root.addPosition();
+	root.setCurrentPosition(currentPosition());
+
+	signalFractionDone(0);
+
+	atomic<int> started(0);
+	atomic<bool> stop(false);
+	DataManager *dataManager = DataManager::self();
+
+	auto worker = [this, dataManager, &root, &deadline, &started, &stop]()
+	{
+		DataManagerScope scope(dataManager);
+		search(root, deadline, started, stop, false);
+	};
+
+	vector<thread> workers;
+	for (int i = 1; i < m_numberOfThreads; ++i)
+		workers.push_back(thread(worker));
+
+	// the calling thread searches too
+	search(root, deadline, started, stop, true);
+
+	for (vector<thread>::iterator it = workers.begin(); it != workers.end(); ++it)
+		(*it).join();
+
+	m_iterations = m_nodes.front().visits;
+
+	// the most visited moves are best
+	vector<int> children(m_nodes.front().children);
+	stable_sort(children.begin(), children.end(), [this](int a, int b)
+	{
+		return m_nodes[a].visits > m_nodes[b].visits;
+	});
+
+	MoveList ret;
+	int i = 0;
+	for (vector<int>::const_iterator it = children.begin(); it != children.end(); ++it, ++i)
+	{
+		const Node &node = m_nodes[*it];
+		if (i >= nmoves && !m_simulator.isConsideredMove(node.move))
+			continue;
+
+		Move move(node.move);
+		move.win = node.visits > 0? node.valueSum / node.visits : node.prior;
+		ret.push_back(move);
+	}
+
+	if (ret.empty())
+		ret.push_back(m_rootMoves.front());
+
+	return ret;
+}
+
+void MonteCarloPlayer::search(const Game &root, const Deadline &deadline, atomic<int> &started, atomic<bool> &stop, bool isMainThread)
+{
+	while (!stop)
+	{
+		if (deadline.passed() || (m_maximumIterations > 0 && started++ >= m_maximumIterations))
+			break;
+
+		if (isMainThread)
+		{
+			if (shouldAbort())
+				break;
+
+			signalFractionDone(m_maximumIterations > 0? max(deadline.fractionUsed(), static_cast<double>(started) / m_maximumIterations) : deadline.fractionUsed());
+		}
+
+		if (!iterate(root))
+			break;
+	}
+
+	// the others stop when the main thread does
+	if (isMainThread)
+		stop = true;
+}
+
+bool MonteCarloPlayer::iterate(const Game &root)
+{
+	Game game(root);
+	determinize(game.currentPosition());
+
+	ConsiderationMap considerations;
+
+	vector<int> path;
+	path.push_back(0);
+
+	for (int ply = 0; ply < m_treePlies && !game.currentPosition().gameOver(); ++ply)
+	{
+		GamePosition &position = game.currentPosition();
+
+		// the racks at the root are known, so the moves there are too
+		if (ply > 0)
+			position.kibitz(m_maximumChildren);
+
+		const MoveList &possible = ply == 0? m_rootMoves : position.moves();
+		if (possible.empty())
+			break;
+
+		Move move;
+
+		{
+			lock_guard<mutex> lock(m_mutex);
+
+			const int child = selectChild(path.back(), possible, position);
+			if (child < 0)
+				break;
+
+			path.push_back(child);
+			move = m_nodes[child].move;
+		}
+
+		play(game, move, &considerations);
+	}
+
+	if (path.size() == 1)
+		return false;
+
+	// near the end of the game, play out to the end
+	int rolloutPlies = m_parameters.rolloutPolicy.plies(root.currentPosition().bag().size() <= QUACKLE_PARAMETERS->rackSize() * 2? -1 : m_rolloutPlies);
+	if (rolloutPlies < 0)
+		rolloutPlies = 1000;
+
+	for (int ply = 0; ply < rolloutPlies && !game.currentPosition().gameOver(); ++ply)
+		play(game, m_parameters.rolloutPolicy.move(game.currentPosition()), &considerations);
+
+	backPropagate(path, evaluate(game.currentPosition(), considerations));
+	return true;
+}
+
+void MonteCarloPlayer::determinize(GamePosition &position) const
+{
+	Bag bag(position.unseenBag());
+
+	const PlayerList::const_iterator end = position.players().end();
+	for (PlayerList::const_iterator it = position.players().begin(); it != end; ++it)
+	{
+		if ((*it) == position.currentPlayer())
+			continue;
+
+		Rack rack;
+		bag.refill(rack);
+		position.setPlayerRack((*it).id(), rack, /* adjust bag */ true);
+	}
+
+	position.setDrawingOrder(position.bag().someShuffledTiles());
+}
+
+int MonteCarloPlayer::selectChild(int node, const MoveList &possible, const GamePosition &position)
+{
+	const int visits = m_nodes[node].visits + m_nodes[node].virtualLosses;
+	const int width = min((int)possible.size(), max(1, (int)ceil(m_wideningFactor * pow(visits + 1.0, m_wideningExponent))));
+
+	int best = -1;
+	double bestValue = 0;
+	int unexpanded = -1;
+
+	for (int i = 0; i < width; ++i)
+	{
+		const vector<int> &children = m_nodes[node].children;
+
+		vector<int>::const_iterator it = children.begin();
+		while (it != children.end() && !(m_nodes[*it].move == possible[i]))
+			++it;
+
+		if (it == children.end())
+		{
+			if (unexpanded < 0)
+				unexpanded = i;
+			continue;
+		}
+
+		// every child possible in this deal was available, whichever
+		// is chosen
+		Node &child = m_nodes[*it];
+		++child.availability;
+
+		const double childVisits = child.visits + child.virtualLosses + m_priorVisits;
+
+		// virtual losses count as visits that were lost
+		const double value = (child.valueSum + m_priorVisits * child.prior) / childVisits + m_exploration * sqrt(log((double)child.availability) / childVisits);
+
+		if (best < 0 || value > bestValue)
+		{
+			best = *it;
+			bestValue = value;
+		}
+	}
+
+	if (unexpanded >= 0)
+	{
+		// the next move in kibitz order the node is due
+		m_nodes.push_back(Node(possible[unexpanded], position.currentPlayer().id(), prior(position, possible[unexpanded])));
+		best = m_nodes.size() - 1;
+		m_nodes[node].children.push_back(best);
+		m_nodes[best].availability = 1;
+	}
+
+	if (best >= 0)
+		++m_nodes[best].virtualLosses;
+
+	return best;
+}
+
+void MonteCarloPlayer::play(Game &game, const Move &move, ConsiderationMap *considerations) const
+{
+	GamePosition &position = game.currentPosition();
+	(*considerations)[position.currentPlayer().id()] = position.calculatePlayerConsideration(move);
+	game.commitMove(move);
+}
+
+double MonteCarloPlayer::evaluate(const GamePosition &position, const ConsiderationMap &considerations) const
+{
+	const int spread = position.spread(m_rootPlayer);
+
+	if (position.gameOver())
+		return spread > 0? 1 : spread == 0? 0.5 : 0;
+
+	double lead = spread;
+	for (ConsiderationMap::const_iterator it = considerations.begin(); it != considerations.end(); ++it)
+		lead += it->first == m_rootPlayer? it->second : -it->second;
+
+	return QUACKLE_STRATEGY_PARAMETERS->bogowin((int)lead, position.bag().size() + QUACKLE_PARAMETERS->rackSize(), 0);
+}
+
+void MonteCarloPlayer::backPropagate(const vector<int> &path, double value)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	++m_nodes[path.front()].visits;
+
+	for (vector<int>::const_iterator it = path.begin() + 1; it != path.end(); ++it)
+	{
+		Node &node = m_nodes[*it];
+		--node.virtualLosses;
+		++node.visits;
+		node.valueSum += node.player == m_rootPlayer? value : 1 - value;
+	}
+}
+
+double MonteCarloPlayer::prior(const GamePosition &position, const Move &move) const
+{
+	const int spread = position.spread(position.currentPlayer().id());
+	return QUACKLE_STRATEGY_PARAMETERS->bogowin((int)(spread + move.equity), position.bag().size() + QUACKLE_PARAMETERS->rackSize(), 0);
+}
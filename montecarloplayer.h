@@ -0,0 +1,207 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_MONTECARLOPLAYER_H
+#define QUACKLE_MONTECARLOPLAYER_H
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "clock.h"
+#include "computerplayer.h"
+
+using namespace std;
+
+namespace Quackle
+{
+
+// Plays by Monte Carlo tree search. Where a simulation plays each
+// candidate out against static best replies, this grows a tree of
+// moves, replies to them and replies to those, spending more of its
+// iterations on the lines that look best so far.
+//
+// Each iteration deals the opponents' racks and the bag at random,
+// then walks down the tree choosing by UCT among the moves possible
+// with those racks. A reply is only possible in some deals, so its
+// exploration term counts the iterations it was available in rather
+// than the visits to its parent. A move's static equity counts as a
+// few visits won as often as that equity suggests, and a node only
+// gets more children, taken in kibitz order, as it is visited more
+// often.
+// Below the tree, moves are played by the rollout policy of the
+// player's parameters for a few plies, and the iteration is scored by
+// the chance of winning from there.
+//
+// Iterations run on several threads that share the tree. A thread
+// going down a line counts a loss on it until it is back, so that
+// other threads meanwhile try other lines.
+//
+// Not offered in the interface until matches at equal time show it
+// beating the simulating players; the test harness can still pick it
+// by name.
+class MonteCarloPlayer : public ComputerPlayer
+{
+public:
+	// numberOfThreads <= 0 means one thread per hardware thread
+	MonteCarloPlayer(int numberOfThreads = 0);
+	virtual ~MonteCarloPlayer();
+
+	virtual Move move();
+	virtual MoveList moves(int nmoves);
+	virtual ComputerPlayer *clone();
+
+	virtual bool isSlow() const;
+	virtual bool isUserVisible() const;
+
+	int numberOfThreads() const;
+
+	// Stop after this many iterations even if there is time left;
+	// zero means search until the time per turn is up.
+	void setMaximumIterations(int iterations);
+	int maximumIterations() const;
+
+	// iterations run by the last call of moves()
+	int iterations() const;
+
+protected:
+	struct Node
+	{
+		Node(const Move &_move, int _player, double _prior)
+			: move(_move), player(_player), prior(_prior), valueSum(0), visits(0), availability(0), virtualLosses(0)
+		{
+		}
+
+		// the move that leads here and the id of the player making it
+		Move move;
+		int player;
+
+		// chance of winning the player making the move has by its
+		// static equity
+		double prior;
+
+		// sum of chances of winning for the player making the move
+		double valueSum;
+		int visits;
+
+		// iterations in which the move could have been chosen; the
+		// parent's visits include deals in which it was not possible
+		int availability;
+
+		// threads below this node now
+		int virtualLosses;
+
+		// indices into m_nodes
+		vector<int> children;
+	};
+
+	// what the last move of each player left it, by player id
+	typedef map<int, double> ConsiderationMap;
+
+	// Runs iterations on this thread until time is up, the iterations
+	// started reach the maximum or stop is set. The main thread looks
+	// after the dispatch and sets stop for the others.
+	void search(const Game &root, const Deadline &deadline, atomic<int> &started, atomic<bool> &stop, bool isMainThread);
+
+	// one iteration; returns false if there was nothing to search
+	bool iterate(const Game &root);
+
+	// Deals the racks of the players other than the one to move, and
+	// the drawing order, at random.
+	void determinize(GamePosition &position) const;
+
+	// Chooses the child of node to go down to from position, which
+	// has these moves possible, adding a child if the node is due
+	// another. Counts a virtual loss on the child. Call with m_mutex.
+	int selectChild(int node, const MoveList &possible, const GamePosition &position);
+
+	void play(Game &game, const Move &move, ConsiderationMap *considerations) const;
+
+	// chance of winning of the player to move at the root
+	double evaluate(const GamePosition &position, const ConsiderationMap &considerations) const;
+
+	void backPropagate(const vector<int> &path, double value);
+
+	// win chance the static equity of move gives the player to move
+	double prior(const GamePosition &position, const Move &move) const;
+
+	int m_numberOfThreads;
+	int m_maximumIterations;
+
+	// UCT exploration constant
+	double m_exploration;
+
+	// the prior counts as this many visits
+	double m_priorVisits;
+
+	// A node visited n times may have
+	// m_wideningFactor * (n + 1) ^ m_wideningExponent children,
+	// and no more than m_maximumChildren.
+	double m_wideningFactor;
+	double m_wideningExponent;
+	int m_maximumChildren;
+
+	// plies in the tree, and played by the rollout policy below it
+	int m_treePlies;
+	int m_rolloutPlies;
+
+	// the tree; the root is node zero
+	vector<Node> m_nodes;
+	mutex m_mutex;
+
+	// moves at the root, which don't depend on the deal
+	MoveList m_rootMoves;
+	int m_rootPlayer;
+
+	int m_iterations;
+};
+
+inline bool MonteCarloPlayer::isSlow() const
+{
+	return true;
+}
+
+inline bool MonteCarloPlayer::isUserVisible() const
+{
+	return false;
+}
+
+inline int MonteCarloPlayer::numberOfThreads() const
+{
+	return m_numberOfThreads;
+}
+
+inline void MonteCarloPlayer::setMaximumIterations(int iterations)
+{
+	m_maximumIterations = iterations;
+}
+
+inline int MonteCarloPlayer::maximumIterations() const
+{
+	return m_maximumIterations;
+}
+
+inline int MonteCarloPlayer::iterations() const
+{
+	return m_iterations;
+}
+
+}
+
+#endif
@@ -67,7 +67,7 @@ double Preendgame::calculateFractionAllottedToInitialBogo() const
 	return 1.0 / static_cast<double>(timeLimitPerSecondsPerTurn);
 }
 
-void Preendgame::getInitialMoves(MoveList *moves)
+void Preendgame::getInitialMoves(MoveList *moves, const Deadline &deadline)
 {
 	if (currentPosition().nestedness() > 0)
 	{
@@ -93,7 +93,7 @@ void Preendgame::getInitialMoves(MoveList *moves)
 			scalingDispatch = new ScalingDispatch(m_dispatch, calculateFractionAllottedToInitialBogo(), 0);
 
 		bogo.setDispatch(scalingDispatch);
-		*moves = bogo.moves(calculateInitialCandidates());
+		*moves = bogo.moves(calculateInitialCandidates(), deadline);
 
 		delete scalingDispatch;
 	}
@@ -114,8 +114,7 @@ MoveList Preendgame::moves(int nmoves)
 	}
 
 	const double fractionAllottedToInitialBogo = calculateFractionAllottedToInitialBogo();
-	const int timeLimit = calculateTimeLimit();
-	Stopwatch stopwatch;
+	Deadline deadline(calculateTimeLimit());
 
 	// Get enumerated racks.
 	Bag unseenBag = currentPosition().unseenBag();
@@ -130,8 +129,10 @@ MoveList Preendgame::moves(int nmoves)
 	
 	signalFractionDone(0);
 
+	// candidates come from a bogo given its share of the time,
+	// and resolving them gets the rest
 	MoveList moves;
-	getInitialMoves(&moves);
+	getInitialMoves(&moves, deadline.phase(fractionAllottedToInitialBogo));
 	if (m_debugPreendgame)
 	{
 		UVcout << currentPosition().nestednessIndentation() << "Preendgame's candidates from bogo:" << endl;
@@ -148,9 +149,17 @@ MoveList Preendgame::moves(int nmoves)
 	GamePosition tempPosition;
 	Resolvent resolvent;
 
+	// resolving one candidate against all racks is a unit of work
+	deadline.startWork();
+
 	int j = 0;
 	for (MoveList::iterator moveIt = moves.begin(); moveIt != moves.end(); ++moveIt, ++j)
 	{
+		// Don't start on a candidate that can't be finished in time.
+		// The first one is always resolved so there's something to return.
+		if (j > 0 && deadline.unitsFitting(deadline.remaining(), 1) < 1)
+			break;
+
 		(*moveIt).win = 1;
 		(*moveIt).possibleWin = 1;
 
@@ -193,10 +202,12 @@ MoveList Preendgame::moves(int nmoves)
 			//if (currentPosition().nestedness() > 0 && resolventMove.win == 0)
 			//	break;
 			
-			signalFractionDone(fractionAllottedToInitialBogo + (1 - fractionAllottedToInitialBogo) * (max(static_cast<double>(j * racks.size() + i) / static_cast<double>(racks.size() * moves.size()), static_cast<double>(stopwatch.elapsed()) / static_cast<double>(timeLimit))));
+			signalFractionDone(fractionAllottedToInitialBogo + (1 - fractionAllottedToInitialBogo) * (max(static_cast<double>(j * racks.size() + i) / static_cast<double>(racks.size() * moves.size()), deadline.fractionUsed())));
 		}
 
-		if (stopwatch.exceeded(timeLimit))
+		deadline.recordWork(1);
+
+		if (deadline.passed())
 			break;
 
 		if (shouldAbort())
@@ -19,6 +19,7 @@
 #ifndef QUACKLE_PREENDGAME_H
 #define QUACKLE_PREENDGAME_H
 
+#include "clock.h"
 #include "computerplayer.h"
 
 namespace Quackle
@@ -44,7 +45,8 @@ private:
 	int calculateInitialCandidates() const;
 
 	// Warning: this function has many side affects!
-	void getInitialMoves(MoveList *moves);
+	// The initial bogo gets the time of deadline.
+	void getInitialMoves(MoveList *moves, const Deadline &deadline);
 
 	double calculateFractionAllottedToInitialBogo() const;
 
@@ -0,0 +1,303 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QMutexLocker>
+
+#include <sim.h>
+
+#include "analysisthread.h"
+
+// moves of a position whose following positions are analyzed
+// when the game doesn't say what comes next
+const int kSpeculativeMoves = 2;
+
+AnalysisThread::AnalysisThread(Quackle::SimulationCache *cache, QObject *parent)
+	: QThread(parent), m_cache(cache), m_generation(0), m_paused(false), m_quit(false), m_busy(false)
+{
+	m_options.kibitzLength = 15;
+	m_options.plies = 2;
+	m_options.ignoreOppos = false;
+	m_options.maximumIterations = 1000;
+	m_taskOptions = m_options;
+
+	start(LowestPriority);
+}
+
+AnalysisThread::~AnalysisThread()
+{
+	{
+		QMutexLocker locker(&m_mutex);
+		m_quit = true;
+		m_tasks.clear();
+		m_condition.wakeAll();
+	}
+
+	wait();
+}
+
+void AnalysisThread::analyze(const Quackle::GamePosition &position, const Quackle::PositionList &nextPositions)
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_tasks.clear();
+	++m_generation;
+	m_taskOptions = m_options;
+
+	if (position.gameOver())
+		return;
+
+	// a position being outcraftied is the human's view of a turn the
+	// computer is taking; what comes after it is up to the computer
+	const bool speculate = nextPositions.empty() && position.currentPlayer().id() == position.playerOnTurn().id();
+
+	QList<Task> simulateTasks;
+
+	m_tasks.push_back(Task(Task::Kibitz, position, speculate));
+	simulateTasks.push_back(Task(Task::Simulate, position));
+
+	for (Quackle::PositionList::const_iterator it = nextPositions.begin(); it != nextPositions.end(); ++it)
+	{
+		if ((*it).gameOver())
+			continue;
+
+		m_tasks.push_back(Task(Task::Kibitz, *it));
+		simulateTasks.push_back(Task(Task::Simulate, *it));
+	}
+
+	m_tasks += simulateTasks;
+	m_condition.wakeAll();
+}
+
+void AnalysisThread::stop()
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_tasks.clear();
+	++m_generation;
+	m_condition.wakeAll();
+
+	while (m_busy)
+		m_condition.wait(&m_mutex);
+}
+
+void AnalysisThread::setPaused(bool paused)
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_paused = paused;
+	m_condition.wakeAll();
+}
+
+bool AnalysisThread::isPaused() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_paused;
+}
+
+void AnalysisThread::setKibitzLength(int nmoves)
+{
+	QMutexLocker locker(&m_mutex);
+	m_options.kibitzLength = nmoves;
+}
+
+void AnalysisThread::setPlies(int plies)
+{
+	QMutexLocker locker(&m_mutex);
+	m_options.plies = plies;
+}
+
+void AnalysisThread::setIgnoreOppos(bool ignore)
+{
+	QMutexLocker locker(&m_mutex);
+	m_options.ignoreOppos = ignore;
+}
+
+void AnalysisThread::setPartialOppoRack(const Quackle::Rack &rack)
+{
+	QMutexLocker locker(&m_mutex);
+	m_options.partialOppoRack = rack;
+}
+
+void AnalysisThread::setMaximumIterations(int iterations)
+{
+	QMutexLocker locker(&m_mutex);
+	m_options.maximumIterations = iterations;
+}
+
+bool AnalysisThread::kibitzedMoves(const Quackle::GamePosition &position, int nmoves, Quackle::MoveList *moves) const
+{
+	const Quackle::SimulationCache::PositionHash hash = kibitzHash(position);
+
+	QMutexLocker locker(&m_mutex);
+
+	QMap<Quackle::SimulationCache::PositionHash, KibitzEntry>::const_iterator it = m_kibitzed.constFind(hash);
+	if (it == m_kibitzed.constEnd() || it.value().nmoves != nmoves)
+		return false;
+
+	*moves = it.value().moves;
+	return true;
+}
+
+void AnalysisThread::forgetKibitzedMoves()
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_kibitzed.clear();
+	m_kibitzOrder.clear();
+}
+
+void AnalysisThread::run()
+{
+	QMutexLocker locker(&m_mutex);
+
+	while (!m_quit)
+	{
+		if (m_tasks.empty() || m_paused)
+		{
+			m_condition.wait(&m_mutex);
+			continue;
+		}
+
+		const Task task(m_tasks.takeFirst());
+		const Options options(m_taskOptions);
+		const int generation = m_generation;
+		m_busy = true;
+
+		locker.unlock();
+
+		if (task.kind == Task::Kibitz)
+			kibitzTask(task, options, generation);
+		else
+			simulateTask(task, options, generation);
+
+		locker.relock();
+
+		m_busy = false;
+		m_condition.wakeAll();
+	}
+}
+
+void AnalysisThread::kibitzTask(const Task &task, const Options &options, int generation)
+{
+	const Quackle::MoveList moves(movesOf(task.position, options.kibitzLength));
+
+	if (!task.speculate)
+		return;
+
+	QList<Task> kibitzTasks;
+	QList<Task> simulateTasks;
+
+	for (int i = 0; i < kSpeculativeMoves && i < (int)moves.size(); ++i)
+	{
+		Quackle::Game game;
+		game.addPosition();
+		game.setCurrentPosition(task.position);
+		game.commitMove(moves[i]);
+
+		// the computer needs no help with its turns
+		const Quackle::GamePosition &next = game.currentPosition();
+		if (next.gameOver() || next.playerOnTurn().type() != Quackle::Player::HumanPlayerType)
+			continue;
+
+		kibitzTasks.push_back(Task(Task::Kibitz, next));
+		simulateTasks.push_back(Task(Task::Simulate, next));
+	}
+
+	QMutexLocker locker(&m_mutex);
+	if (generation != m_generation)
+		return;
+
+	// kibitzing comes before any simulation
+	m_tasks = kibitzTasks + m_tasks + simulateTasks;
+}
+
+void AnalysisThread::simulateTask(const Task &task, const Options &options, int generation)
+{
+	Quackle::GamePosition position(task.position);
+	position.setMoves(movesOf(position, options.kibitzLength));
+	if (position.moves().empty())
+		return;
+
+	Quackle::Simulator simulator;
+	simulator.setCache(m_cache);
+	simulator.setIgnoreOppos(options.ignoreOppos);
+	simulator.setPartialOppoRack(options.partialOppoRack);
+	simulator.setPosition(position);
+
+	bool waited = false;
+	while (simulator.iterations() < options.maximumIterations && proceed(generation, &waited))
+	{
+		// the UI may have simulated the position while we waited
+		if (waited)
+			simulator.reloadFromCache();
+
+		simulator.simulate(options.plies);
+
+		// stored as we go so that the UI finds it all whenever it looks
+		simulator.storeInCache();
+	}
+}
+
+Quackle::MoveList AnalysisThread::movesOf(const Quackle::GamePosition &position, int nmoves)
+{
+	Quackle::MoveList ret;
+	if (kibitzedMoves(position, nmoves, &ret))
+		return ret;
+
+	Quackle::GamePosition kibitzed(position);
+	kibitzed.kibitz(nmoves);
+	ret = kibitzed.moves();
+
+	KibitzEntry entry;
+	entry.nmoves = nmoves;
+	entry.moves = ret;
+
+	const Quackle::SimulationCache::PositionHash hash = kibitzHash(position);
+
+	QMutexLocker locker(&m_mutex);
+
+	if (!m_kibitzed.contains(hash))
+		m_kibitzOrder.push_back(hash);
+	m_kibitzed.insert(hash, entry);
+
+	while (m_kibitzOrder.size() > m_maximumKibitzedPositions)
+		m_kibitzed.remove(m_kibitzOrder.takeFirst());
+
+	return ret;
+}
+
+bool AnalysisThread::proceed(int generation, bool *waited)
+{
+	QMutexLocker locker(&m_mutex);
+
+	*waited = false;
+	while (m_paused && !m_quit && generation == m_generation)
+	{
+		m_condition.wait(&m_mutex);
+		*waited = true;
+	}
+
+	return !m_quit && generation == m_generation;
+}
+
+Quackle::SimulationCache::PositionHash AnalysisThread::kibitzHash(const Quackle::GamePosition &position)
+{
+	// the simulation cache's hash, leaving out the simulator options
+	// that kibitzing doesn't depend on
+	return Quackle::SimulationCache::positionHash(position, Quackle::Rack(), /* ignore oppos */ false, Quackle::RolloutPolicy());
+}
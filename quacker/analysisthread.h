@@ -0,0 +1,153 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKER_ANALYSISTHREAD_H
+#define QUACKER_ANALYSISTHREAD_H
+
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <game.h>
+#include <simulationcache.h>
+
+// Analyzes positions at low priority while the user is thinking about
+// them: kibitzes the position shown, then the positions likely to be
+// shown next, then simulates the kibitzed moves of each. Kibitzed
+// move lists are kept here by position for the UI to ask for, and
+// simulation statistics go into the simulation cache, where the UI's
+// simulator picks them up.
+//
+// Analysis yields to the UI: it waits while paused, and each new
+// position to analyze drops whatever was being analyzed before.
+class AnalysisThread : public QThread
+{
+Q_OBJECT
+
+public:
+	// the cache is not owned and must outlive the thread
+	AnalysisThread(Quackle::SimulationCache *cache, QObject *parent = 0);
+
+	// drops queued work and waits for the thread to finish
+	~AnalysisThread();
+
+	// Analyzes position, and nextPositions after it. If there are no
+	// next positions, the positions after the best kibitzed moves of
+	// position are analyzed instead, if a human is on turn in them.
+	void analyze(const Quackle::GamePosition &position, const Quackle::PositionList &nextPositions);
+
+	// Drops queued work and waits for the task under way, which
+	// may be storing simulation statistics, to wind up.
+	void stop();
+
+	// While paused, analysis waits between simulation iterations.
+	void setPaused(bool paused);
+	bool isPaused() const;
+
+	// these apply from the next analyze() on
+	void setKibitzLength(int nmoves);
+	void setPlies(int plies);
+	void setIgnoreOppos(bool ignore);
+	void setPartialOppoRack(const Quackle::Rack &rack);
+
+	// iterations a position is simulated to at most; default 1000
+	void setMaximumIterations(int iterations);
+
+	// If nmoves moves have been kibitzed for position, sets moves
+	// to them and returns true.
+	bool kibitzedMoves(const Quackle::GamePosition &position, int nmoves, Quackle::MoveList *moves) const;
+
+	// Drops the kibitzed move lists, which go stale when the lexicon,
+	// alphabet or board changes. Call stop() first.
+	void forgetKibitzedMoves();
+
+protected:
+	void run();
+
+private:
+	struct Task
+	{
+		enum Kind { Kibitz, Simulate };
+
+		Task(Kind _kind, const Quackle::GamePosition &_position, bool _speculate = false)
+			: kind(_kind), position(_position), speculate(_speculate) {}
+
+		Kind kind;
+		Quackle::GamePosition position;
+
+		// whether to go on to the positions after the best moves
+		bool speculate;
+	};
+
+	struct KibitzEntry
+	{
+		int nmoves;
+		Quackle::MoveList moves;
+	};
+
+	// options the queued tasks are run with
+	struct Options
+	{
+		int kibitzLength;
+		int plies;
+		bool ignoreOppos;
+		Quackle::Rack partialOppoRack;
+		int maximumIterations;
+	};
+
+	void kibitzTask(const Task &task, const Options &options, int generation);
+	void simulateTask(const Task &task, const Options &options, int generation);
+
+	// the kibitzed moves of position, kibitzing them if need be
+	Quackle::MoveList movesOf(const Quackle::GamePosition &position, int nmoves);
+
+	// Waits while paused. Returns false if the work of generation has
+	// been dropped meanwhile; sets waited if there was any waiting.
+	bool proceed(int generation, bool *waited);
+
+	static Quackle::SimulationCache::PositionHash kibitzHash(const Quackle::GamePosition &position);
+
+	Quackle::SimulationCache *m_cache;
+
+	// guards everything below
+	mutable QMutex m_mutex;
+	QWaitCondition m_condition;
+
+	QList<Task> m_tasks;
+	Options m_options;
+	Options m_taskOptions;
+
+	// bumped whenever queued work is dropped
+	int m_generation;
+
+	bool m_paused;
+	bool m_quit;
+
+	// whether a task is under way
+	bool m_busy;
+
+	// Kibitzed move lists, oldest first in m_kibitzOrder; the oldest
+	// are dropped to keep this many.
+	static const int m_maximumKibitzedPositions = 64;
+	QMap<Quackle::SimulationCache::PositionHash, KibitzEntry> m_kibitzed;
+	QList<Quackle::SimulationCache::PositionHash> m_kibitzOrder;
+};
+
+#endif
@@ -27,6 +27,38 @@
 #include "letterboxsettings.h"
 #include "lister.h"
 
+namespace
+{
+
+// Shows how many answers of a batch have been looked up.
+class ProgressObserver : public Dict::QueryObserver
+{
+public:
+	ProgressObserver(QStatusBar *statusBar, int total)
+		: m_statusBar(statusBar), m_total(total), m_answered(0)
+	{
+	}
+
+	void answered(int index, const Dict::WordList & /* words */)
+	{
+		m_answered = index + 1;
+	}
+
+	bool shouldAbort()
+	{
+		m_statusBar->showMessage(QObject::tr("Looking up answers: %1 of %2...").arg(m_answered).arg(m_total));
+		qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
+		return false;
+	}
+
+private:
+	QStatusBar *m_statusBar;
+	int m_total;
+	int m_answered;
+};
+
+}
+
 Letterbox *Letterbox::m_self = 0;
 Letterbox *Letterbox::self()
 {
@@ -331,10 +363,20 @@ void Letterbox::jumpTo(int index)
 		return;
 	}
 
-	while (m_answers.count() <= m_numberIterator)
+	if (m_answers.count() <= m_numberIterator)
 	{
-		m_answers.append(answersFor(m_list.at(m_answers.count())));
-		m_clueResults[m_answers.count() - 1].setWordList(m_answers.at(m_answers.count() - 1));
+		QStringList queries;
+		for (int i = m_answers.count(); i <= m_numberIterator; ++i)
+			queries.append(m_list.at(i));
+
+		ProgressObserver observer(statusBar(), queries.size());
+		const Dict::WordListList answers(QuackleIO::DictFactory::querier()->queryBatch(queries, answerFlags(), &observer));
+
+		for (Dict::WordListList::const_iterator it = answers.begin(); it != answers.end(); ++it)
+		{
+			m_answers.append(*it);
+			m_clueResults[m_answers.count() - 1].setWordList(*it);
+		}
 	}
 
 	m_clueResultsIterator = m_clueResults.begin();
@@ -673,12 +715,17 @@ Dict::WordList Letterbox::answersFor(const QString &word)
 	if (word.isNull())
 		return results;
 
-	// no updates during initialization of lists, but with extensions
-	results = QuackleIO::DictFactory::querier()->query(word, (m_initializationChuu? Dict::Querier::None : Dict::Querier::CallUpdate) | Dict::Querier::WithExtensions);
+	results = QuackleIO::DictFactory::querier()->query(word, answerFlags());
 
 	return results;
 }
 
+int Letterbox::answerFlags() const
+{
+	// no updates during initialization of lists, but with extensions
+	return (m_initializationChuu? Dict::Querier::None : Dict::Querier::CallUpdate) | Dict::Querier::WithExtensions;
+}
+
 void Letterbox::mistakeDetector(const QString &text)
 {
 	m_keystrokes++;
@@ -161,6 +161,9 @@ protected:
 	// all anagrams of letters
 	Dict::WordList answersFor(const QString &word);
 
+	// flags of the queries answersFor makes
+	int answerFlags() const;
+
 	// if answer correct, tell user and keep note.
 	// if user has given all correct answers, increment()
 	void processAnswer(const QString &answer);
@@ -138,6 +138,7 @@ void LexiconDialog::deleteLexicon()
 	string lexiconNameStr = m_originalName.toStdString();
 	string filename = QUACKLE_DATAMANAGER->makeDataFilename("lexica", lexiconNameStr + ".dawg", true);
 	QFile(QString::fromStdString(filename)).remove();
+	QFile(QString::fromStdString(QUACKLE_DATAMANAGER->makeDataFilename("lexica", lexiconNameStr + ".alphagrams", true))).remove();
 	m_deleted = true;
 	QDialog::accept();
 }
@@ -270,7 +271,14 @@ void LexiconDialog::accept()
 	m_wordFactory->generate();
 	m_lexiconInformation->setText(tr("Writing dictionary file..."));
 	qApp->processEvents();
-	m_wordFactory->writeIndex(filename);
+	if (!m_wordFactory->writeIndex(filename))
+	{
+		QFile::remove(QuackleIO::Util::stdStringToQString(filename));
+		m_lexiconInformation->setText(tr("Could not write the dictionary file."));
+		QMessageBox::critical(this, tr("Error Writing Dictionary - Quackle"), tr("<p>Could not write %1. Check that there is room on the disk and that the lexicon fits the dictionary format.</p>").arg(QuackleIO::Util::stdStringToQString(filename)));
+		return;
+	}
+	m_wordFactory->writeAlphagramIndex(QUACKLE_DATAMANAGER->makeDataFilename("lexica", lexiconNameStr + ".alphagrams", true));
 	m_finalLexiconName = m_lexiconName->text();
 	QDialog::accept();
 }
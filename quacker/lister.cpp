@@ -26,6 +26,51 @@ using namespace std;
 #include "lister.h"
 #include "customqsettings.h"
 
+namespace
+{
+
+// Adds the words of an opened list to a word list as their queries
+// are answered, keeping a progress dialog up to date.
+class OpenFileObserver : public Dict::QueryObserver
+{
+public:
+	OpenFileObserver(const QStringList &queries, QProgressDialog *progress, Dict::WordList *wordList)
+		: m_queries(queries), m_progress(progress), m_wordList(wordList)
+	{
+	}
+
+	void answered(int index, const Dict::WordList &results)
+	{
+		// a word of the list stands for itself, if it is a word;
+		// otherwise for its anagrams
+		for (Dict::WordList::ConstIterator it = results.begin(); it != results.end(); ++it)
+		{
+			if ((*it).word == m_queries.at(index))
+			{
+				m_wordList->append(*it);
+				m_progress->setValue(index + 1);
+				return;
+			}
+		}
+
+		*m_wordList += results;
+		m_progress->setValue(index + 1);
+	}
+
+	bool shouldAbort()
+	{
+		qApp->processEvents();
+		return m_progress->wasCanceled();
+	}
+
+private:
+	const QStringList &m_queries;
+	QProgressDialog *m_progress;
+	Dict::WordList *m_wordList;
+};
+
+}
+
 ListerDialog::ListerDialog(QWidget *parent, const QString &settingsGroup, const QString &appName, int flags)
 	: QDialog(parent), m_settingsGroup(settingsGroup), m_appName(appName), m_flags(flags)
 {
@@ -232,6 +277,8 @@ void ListerDialog::openFile()
 	QFile file(filename);
 	if (file.open(QIODevice::ReadOnly | QIODevice::Text))
 	{
+		QStringList queries;
+
 		QTextStream stream(&file);
 		stream.setCodec(QTextCodec::codecForName("UTF-8"));
 		QString line;
@@ -243,29 +290,17 @@ void ListerDialog::openFile()
 			if (quoteMarkIndex >= 0)
 				line = line.left(quoteMarkIndex).trimmed();
 
-			QStringList words(line.split(" "));
-			for (QStringList::Iterator it = words.begin(); it != words.end(); ++it)
-			{
-				bool found = false;
-				Dict::WordList results(QuackleIO::DictFactory::querier()->query(*it));
-				for (Dict::WordList::Iterator resultsIt = results.begin(); resultsIt != results.end(); ++resultsIt)
-				{
-					if ((*resultsIt).word == *it)
-					{
-						m_wordList.append(*resultsIt);
-						found = true;
-						break;
-					}
-				}
-
-				if (found)
-					continue;
-
-				m_wordList += results;
-			}
+			queries += line.split(" ");
 		}
 
 		file.close();
+
+		QProgressDialog progress(tr("Looking up words..."), tr("Cancel"), 0, queries.size(), this);
+		progress.setWindowModality(Qt::WindowModal);
+		progress.setMinimumDuration(500);
+
+		OpenFileObserver observer(queries, &progress, &m_wordList);
+		QuackleIO::DictFactory::querier()->queryBatch(queries, Dict::Querier::None, &observer);
 	}
 
 	setWordList(m_wordList);
@@ -612,10 +647,29 @@ RegexFilter::RegexFilter(ListerDialog *dialog)
 	m_lineEdit = new QLineEdit;
 	m_vbox->addWidget(m_lineEdit);
 	connect(m_lineEdit, SIGNAL(returnPressed()), this, SLOT(apply()));
+
+	m_lexiconChecker = new QCheckBox(tr("Search whole &lexicon"));
+	m_lexiconChecker->setToolTip(tr("Find all words of the lexicon matching a pattern of letters, ., [classes] and *, +, ?, {m,n} repeats, anchored with ^ and $"));
+	m_vbox->addWidget(m_lexiconChecker);
 }
 
 void RegexFilter::apply()
 {
+	if (m_lexiconChecker->isChecked())
+	{
+		QString error;
+		Dict::WordList list = QuackleIO::DictFactory::querier()->patternQuery(m_lineEdit->text(), Dict::Querier::None, &error);
+
+		if (!error.isEmpty())
+		{
+			QMessageBox::warning(m_dialog, tr("Unsupported Pattern - Quackle"), QString("<html>%1</html>").arg(tr("The whole lexicon can only be searched with letters, ., [classes] and repeats; %1.").arg(error)));
+			return;
+		}
+
+		m_dialog->setWordList(list);
+		return;
+	}
+
 	QRegExp regexp(m_lineEdit->text());
 	regexp.setCaseSensitivity(Qt::CaseInsensitive);
 	
@@ -630,6 +684,16 @@ void RegexFilter::apply()
 	m_dialog->setWordList(filteredList);
 }
 
+void RegexFilter::saveSettings(QSettings *settings)
+{
+	settings->setValue("regexfilter/searchLexicon", m_lexiconChecker->isChecked());
+}
+
+void RegexFilter::loadSettings(QSettings *settings)
+{
+	m_lexiconChecker->setChecked(settings->value("regexfilter/searchLexicon", false).toBool());
+}
+
 ////////////////////
 
 NumAnagramsFilter::NumAnagramsFilter(ListerDialog *dialog)
@@ -149,9 +149,14 @@ public:
 
 public slots:
 	virtual void apply();
+	virtual void saveSettings(QSettings *settings);
+	virtual void loadSettings(QSettings *settings);
 
 private:
 	QLineEdit *m_lineEdit;
+
+	// search the lexicon itself rather than the current list
+	QCheckBox *m_lexiconChecker;
 };
 
 class PlayabilityFilter : public Filter
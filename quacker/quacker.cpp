@@ -27,6 +27,7 @@ using namespace std;
 #include <boardparameters.h>
 #include <computerplayer.h>
 #include <gameparameters.h>
+#include <simulationcache.h>
 
 #include <quackleio/froggetopt.h>
 #include <quackleio/util.h>
@@ -34,6 +35,7 @@ using namespace std;
 #include <quackleio/queenie.h>
 #include <quackleio/streamingreporter.h>
 
+#include "analysisthread.h"
 #include "brb.h"
 #include "configdialog.h"
 #include "customqsettings.h"
@@ -57,6 +59,9 @@ using namespace std;
 
 const int kExtraPlaysToKibitz = 15;
 
+// positions of a game under review analyzed ahead of the one shown
+const int kPositionsToAnalyzeAhead = 2;
+
 TopLevel::TopLevel(QWidget *parent)
 	: QMainWindow(parent), m_listerDialog(0), m_letterbox(0), m_simViewer(0), m_plies(2), m_logania(0), m_modified(false)
 {
@@ -74,7 +79,11 @@ TopLevel::TopLevel(QWidget *parent)
 	connect(m_settings, SIGNAL(refreshViews()), this, SLOT(updateAllViews()));
 	
 	m_game = new Quackle::Game;
+	m_simulationCache = new Quackle::SimulationCache;
 	m_simulator = new Quackle::Simulator;
+	m_simulator->setCache(m_simulationCache);
+	m_analysisThread = new AnalysisThread(m_simulationCache);
+	connect(m_settings, SIGNAL(parametersAboutToChange()), this, SLOT(parametersAboutToChange()));
 
 	createMenu();
 	createWidgets();
@@ -89,9 +98,11 @@ TopLevel::TopLevel(QWidget *parent)
 
 TopLevel::~TopLevel()
 {
+	delete m_analysisThread;
 	QuackleIO::Queenie::cleanUp();
 	delete m_game;
 	delete m_simulator;
+	delete m_simulationCache;
 	delete m_quackerSettings;
 }
 
@@ -469,6 +480,7 @@ void TopLevel::setRack(const Quackle::Rack &rack)
 	m_game->currentPosition().setPlayerRack(m_game->currentPosition().currentPlayer().id(), rackToSet);
 	m_simulator->currentPosition().setCurrentPlayerRack(rackToSet);
 	updatePositionViews();
+	startBackgroundAnalysis();
 
 	statusMessage(tr("%1's rack set to %2.").arg(QuackleIO::Util::uvStringToQString(m_game->currentPosition().currentPlayer().name())).arg(QuackleIO::Util::letterStringToQString(rackToSet.tiles())));
 	setModified(true);
@@ -504,6 +516,8 @@ void TopLevel::stopEverything()
 	// stop simulation if it's going
 	simulate(false);
 
+	m_analysisThread->stop();
+
 	for (QList<OppoThread *>::iterator it = m_otherOppoThreads.begin(); it != m_otherOppoThreads.end(); ++it)
 		(*it)->abort();
 	for (QList<OppoThread *>::iterator it = m_oppoThreads.begin(); it != m_oppoThreads.end(); ++it)
@@ -555,6 +569,9 @@ void TopLevel::updateAllViews()
 	updateSimViews();
 
 	m_game->currentPosition().ensureBoardIsPreparedForAnalysis();
+
+	// settings changes stop it
+	startBackgroundAnalysis();
 }
 
 void TopLevel::updatePositionViews()
@@ -644,7 +661,8 @@ void TopLevel::initializeGame(const Quackle::PlayerList &players)
 		UVString prevFirst = m_firstPlayerName;
 		while (m_firstPlayerName == prevFirst || m_firstPlayerName.empty())
 		{
-			random_shuffle(newPlayers.begin(), newPlayers.end());
+			for (int i = newPlayers.size() - 1; i > 0; --i)
+				swap(newPlayers[i], newPlayers[QUACKLE_DATAMANAGER->randomNumber() % (i + 1)]);
 			m_firstPlayerName = newPlayers.front().name();
 		}
 	}
@@ -903,11 +921,18 @@ void TopLevel::kibitz(int numberOfPlays, Quackle::ComputerPlayer *computerPlayer
 
 		thread->setPlayer(computerPlayer->clone());
 		thread->findBestMoves(numberOfPlays);
+		updateBackgroundAnalysisPause();
 		statusMessage(tr("Asked %1 for her choices. Please allow her time to think.").arg(QuackleIO::Util::uvStringToQString(computerPlayer->name())));
 	}
 	else
 	{
-		m_game->currentPosition().kibitz(numberOfPlays);
+		// background analysis may have kibitzed the position already
+		Quackle::MoveList moves;
+		if (m_analysisThread->kibitzedMoves(m_game->currentPosition(), numberOfPlays, &moves))
+			m_game->currentPosition().setMoves(moves);
+		else
+			m_game->currentPosition().kibitz(numberOfPlays);
+
 		kibitzFinished();
 	}
 }
@@ -938,6 +963,7 @@ void TopLevel::kibitzThreadFinished()
 		}
 	}
 
+	updateBackgroundAnalysisPause();
 	kibitzFinished();
 
 	statusMessage(tr("Showing %1's choices from %2.").arg(name).arg(rack));
@@ -1011,6 +1037,55 @@ void TopLevel::ensureUpToDateSimulatorMoveList()
 	m_simulator->setIncludedMoves(m_game->currentPosition().moves());
 }
 
+void TopLevel::startBackgroundAnalysis()
+{
+	if (!m_game->hasPositions() || !m_backgroundAnalysisAction->isChecked())
+	{
+		m_analysisThread->stop();
+		return;
+	}
+
+	m_analysisThread->setKibitzLength(kExtraPlaysToKibitz);
+	m_analysisThread->setPlies(m_plies);
+	m_analysisThread->setIgnoreOppos(m_simulator->ignoreOppos());
+	m_analysisThread->setPartialOppoRack(m_simulator->partialOppoRack());
+
+	// someone reviewing a game is likely to step forward through it
+	Quackle::PositionList nextPositions;
+	const Quackle::History &history = m_game->history();
+	for (Quackle::History::const_iterator it = history.begin(); it != history.end(); ++it)
+	{
+		if ((*it).location() == history.currentLocation())
+		{
+			for (++it; it != history.end() && (int)nextPositions.size() < kPositionsToAnalyzeAhead; ++it)
+				nextPositions.push_back(*it);
+			break;
+		}
+	}
+
+	m_analysisThread->analyze(m_game->currentPosition(), nextPositions);
+}
+
+void TopLevel::updateBackgroundAnalysisPause()
+{
+	m_analysisThread->setPaused(m_simulateAction->isChecked() || !m_oppoThreads.empty() || !m_otherOppoThreads.empty());
+}
+
+void TopLevel::backgroundAnalysisToggled(bool /* on */)
+{
+	startBackgroundAnalysis();
+}
+
+void TopLevel::parametersAboutToChange()
+{
+	m_analysisThread->stop();
+	m_analysisThread->forgetKibitzedMoves();
+
+	// the cache is keyed by lexicon but not by board or alphabet
+	m_simulator->resetNumbers();
+	m_simulationCache->clear();
+}
+
 void TopLevel::simulate(bool startSimulation)
 {
 	m_simulateAction->setChecked(startSimulation);
@@ -1021,11 +1096,21 @@ void TopLevel::simulate(bool startSimulation)
 
 	if (startSimulation)
 	{
+		// pick up where background analysis left off
+		m_simulator->reloadFromCache();
+
 		logfileChanged();
 		incrementSimulation();
 	}
 	else
+	{
 		m_simulationTimer->stop();
+
+		// and let it pick up where we leave off
+		m_simulator->storeInCache();
+	}
+
+	updateBackgroundAnalysisPause();
 }
 
 void TopLevel::simulateToggled(bool startSimulation)
@@ -1050,6 +1135,10 @@ void TopLevel::clearSimulationResults()
 	if (!m_game->hasPositions())
 		return;
 
+	// background analysis would store its numbers for the position
+	// again, and they're cached even if we haven't simulated it yet
+	m_analysisThread->stop();
+	m_simulationCache->forget(Quackle::SimulationCache::positionHash(m_simulator->currentPosition(), m_simulator->partialOppoRack(), m_simulator->ignoreOppos(), m_simulator->rolloutPolicy()));
 	m_simulator->resetNumbers();
 
 	updateMoveViews();
@@ -1067,11 +1156,14 @@ void TopLevel::pliesSet(const QString &plyString)
 		m_plies = -1;
 	else
 		m_plies = plyString.toInt();
+
+	startBackgroundAnalysis();
 }
 
 void TopLevel::ignoreOpposChanged()
 {
 	m_simulator->setIgnoreOppos(m_ignoreOpposCheck->isChecked());
+	startBackgroundAnalysis();
 }
 
 void TopLevel::updatePliesCombo()
@@ -1192,6 +1284,7 @@ void TopLevel::partialOppoRackChanged()
 	}
 
 	m_simulator->setPartialOppoRack(rack);
+	startBackgroundAnalysis();
 }
 
 void TopLevel::showSimulationDetails()
@@ -1423,6 +1516,7 @@ void TopLevel::startOppoThread()
 
 	thread->setPlayer(m_game->currentPosition().playerOnTurn().computerPlayer()->clone());
 	thread->findBestMoves(1);
+	updateBackgroundAnalysisPause();
 }
 
 void TopLevel::startOutcraftyingCurrentPlayer()
@@ -1478,6 +1572,8 @@ void TopLevel::computerPlayerDone()
 		}
 	}
 
+	updateBackgroundAnalysisPause();
+
 	if (moves.empty())
 	{
 		UVcout << "compy moves are empty" << endl;
@@ -1550,6 +1646,8 @@ void TopLevel::showToHuman()
 	// spit things to stdout.
 
 	m_game->currentPosition().ensureProperBag();
+
+	startBackgroundAnalysis();
 }
 
 void TopLevel::timerControl(bool paused)
@@ -1714,6 +1812,11 @@ void TopLevel::createMenu()
 	m_simulateClearAction->setEnabled(false);
 	connect(m_simulateClearAction, SIGNAL(triggered()), this, SLOT(clearSimulationResults()));
 
+	m_backgroundAnalysisAction = new QAction(tr("Analyze in &background"), this);
+	m_backgroundAnalysisAction->setCheckable(true);
+	m_backgroundAnalysisAction->setChecked(true);
+	connect(m_backgroundAnalysisAction, SIGNAL(toggled(bool)), this, SLOT(backgroundAnalysisToggled(bool)));
+
 	//// Study
 
 	QAction *letterboxAction = new QAction(tr("Letter&box"), this);
@@ -1811,6 +1914,8 @@ void TopLevel::createMenu()
 	simulation->addAction(m_simulateAction);
 	simulation->addAction(m_simulateDetailsAction);
 	simulation->addAction(m_simulateClearAction);
+	simulation->addSeparator();
+	simulation->addAction(m_backgroundAnalysisAction);
 
 	if (enableLetterbox)
 	{
@@ -2184,6 +2289,7 @@ void TopLevel::saveSettings()
 	settings.setValue("quackle/logfile", userSpecifiedLogfile());
 	settings.setValue("quackle/partialopporackenabled", isPartialOppoRackEnabled());
 	settings.setValue("quackle/partialopporack", userSpecifiedPartialOppoRack());
+	settings.setValue("quackle/backgroundanalysis", m_backgroundAnalysisAction->isChecked());
 
 	settings.setValue("quackle/hasBeenRun", true);
 
@@ -2218,6 +2324,8 @@ void TopLevel::loadSettings()
 	m_partialOppoRackEnable->setChecked(partialOppoRackEnabled);
 	setPartialOppoRackEnabled(partialOppoRackEnabled);
 
+	m_backgroundAnalysisAction->setChecked(settings.value("quackle/backgroundanalysis", true).toBool());
+
 	QuackerSettings::self()->readSettings();
 }
 
@@ -53,6 +53,7 @@ namespace Quackle
 	class HistoryLocation;
 	class Move;
 	class Rack;
+	class SimulationCache;
 }
 
 namespace QuackleIO
@@ -60,6 +61,7 @@ namespace QuackleIO
 	class Logania;
 }
 
+class AnalysisThread;
 class BaseView;
 class HistoryView;
 class Letterbox;
@@ -224,6 +226,11 @@ protected slots:
 	void partialOppoRackEnabled(bool on);
 	void partialOppoRackChanged();
 	void showSimulationDetails();
+	void backgroundAnalysisToggled(bool on);
+
+	// stops background analysis and drops what was worked
+	// out with the parameters that are about to change
+	void parametersAboutToChange();
 
 	// Birthday
 	void startBirthday();
@@ -246,6 +253,13 @@ protected:
 	Quackle::Game *m_game;
 	Quackle::Simulator *m_simulator;
 
+	// keeps simulation results of positions visited before
+	Quackle::SimulationCache *m_simulationCache;
+
+	// analyzes the position shown, and those likely to be shown
+	// next, while the user is thinking
+	AnalysisThread *m_analysisThread;
+
 private:
 	void saveSettings();
 	void loadSettings();
@@ -399,6 +413,7 @@ private:
 	QAction *m_simulateAction;
 	QAction *m_simulateClearAction;
 	QAction *m_simulateDetailsAction;
+	QAction *m_backgroundAnalysisAction;
 	QAction *m_preferencesAction;
 
 #ifdef ENABLE_GRAPHICAL_REPORT
@@ -408,6 +423,14 @@ private:
 	// make sure moves in our simulator match those in current position
 	void ensureUpToDateSimulatorMoveList();
 
+	// hand the current position and the ones after it to the
+	// analysis thread, if background analysis is on
+	void startBackgroundAnalysis();
+
+	// background analysis waits while the user simulates or
+	// a computer player is thinking
+	void updateBackgroundAnalysisPause();
+
 	void createMenu();
 	void createWidgets();
 	void switchToTab(TabIndex index);
@@ -256,7 +256,14 @@ void Settings::buildGaddag()
 		setGaddagLabel(QString(tr("Lexicon total: %1 words.  Compressing...")).arg(wordCount));
 		factory.generate();
 		setGaddagLabel(QString(tr("Lexicon total: %1 words.  Writing to disk...")).arg(wordCount));
-		factory.writeIndex(gaddagFile);
+		if (!factory.writeIndex(gaddagFile))
+		{
+			// a partial GADDAG would be loaded the next time around
+			QFile::remove(QuackleIO::Util::stdStringToQString(gaddagFile));
+			setGaddagLabel(QString(tr("Could not write %1.  Operation aborted.")).arg(QuackleIO::Util::stdStringToQString(gaddagFile)));
+			return;
+		}
+		emit parametersAboutToChange();
 		QUACKLE_LEXICON_PARAMETERS->loadGaddag(gaddagFile);
 		setGaddagLabel();
 	}
@@ -305,6 +312,7 @@ void Settings::setQuackleToUseLexiconName(const QString &lexiconName)
 	string lexiconNameStr = lexiconName.toStdString();
 	if (QUACKLE_LEXICON_PARAMETERS->lexiconName() != lexiconNameStr)
 	{
+		emit parametersAboutToChange();
 		QUACKLE_LEXICON_PARAMETERS->setLexiconName(lexiconNameStr);
 
 		string dawgFile = Quackle::LexiconParameters::findDictionaryFile(lexiconNameStr + ".dawg");
@@ -371,6 +379,7 @@ void Settings::setQuackleToUseAlphabetName(const QString &alphabetName)
 				QMessageBox::warning(this, tr("Alphabet mismatch - Quackle"), QString("<html>%1</html>").arg(tr("%1 has a different number of letters than %2, so please start a new game or else Quackle will crash or act strangely.").arg(QuackleIO::Util::stdStringToQString(flexure->alphabetName())).arg(QuackleIO::Util::stdStringToQString(QUACKLE_ALPHABET_PARAMETERS->alphabetName()))));
 			}
 
+			emit parametersAboutToChange();
 			QUACKLE_DATAMANAGER->setAlphabetParameters(flexure);
 		}
 		else
@@ -397,6 +406,8 @@ void Settings::setQuackleToUseThemeName(const QString &themeName)
 
 void Settings::setQuackleToUseBoardName(const QString &boardName)
 {
+	emit parametersAboutToChange();
+
 	CustomQSettings settings;
 	settings.beginGroup("quackle/boardparameters");
 
@@ -488,6 +499,7 @@ void Settings::boardChanged(const QString &boardName)
 
 void Settings::addBoard()
 {
+	emit parametersAboutToChange();
 	QUACKLE_DATAMANAGER->setBoardParameters(new Quackle::BoardParameters());
 	QUACKLE_BOARD_PARAMETERS->setName(MARK_UV(""));
 
@@ -517,6 +529,9 @@ void Settings::addBoard()
 void Settings::editBoard()
 {
 	QString oldBoardName = m_boardNameCombo->currentText();
+
+	// the dialog edits the board parameters in place
+	emit parametersAboutToChange();
 	QUACKLE_BOARD_PARAMETERS->setName(QuackleIO::Util::qstringToString(oldBoardName));
 
 	BoardSetupDialog dialog(this);
@@ -575,6 +590,7 @@ void Settings::editLexicon()
 	LexiconDialog dialog(this, name);
 	if (dialog.exec())
 	{
+		emit parametersAboutToChange();
 		populateComboFromFilenames(m_lexiconNameCombo, "lexica", ".dawg", "lexicon");
 		qApp->processEvents();
 		if (dialog.itemWasDeleted())
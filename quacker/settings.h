@@ -48,6 +48,10 @@ public:
 signals:
 	void refreshViews();
 
+	// emitted before the lexicon, alphabet or board parameters are
+	// changed, so that nothing else is using them meanwhile
+	void parametersAboutToChange();
+
 public slots:
 	// called before anything else to initialize quackle generally
 	void preInitialize();
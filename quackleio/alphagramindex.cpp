@@ -0,0 +1,286 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "alphagramindex.h"
+
+using namespace std;
+using namespace QuackleIO;
+
+const char AlphagramIndex::magicBytes[8] = { 'Q', 'A', 'L', 'P', 'H', 'A', 'G', 'R' };
+
+AlphagramIndex::AlphagramIndex()
+	: m_data(0), m_header(0), m_alphagrams(0), m_words(0), m_letters(0)
+{
+}
+
+AlphagramIndex::~AlphagramIndex()
+{
+	unload();
+}
+
+bool AlphagramIndex::load(const QString &filename)
+{
+	unload();
+
+	m_file.setFileName(filename);
+	if (!m_file.open(QIODevice::ReadOnly))
+		return false;
+
+	const qint64 size = m_file.size();
+	if (size < (qint64)sizeof(Header))
+	{
+		m_file.close();
+		return false;
+	}
+
+	const uchar *data = m_file.map(0, size);
+	if (!data)
+	{
+		m_file.close();
+		return false;
+	}
+
+	const Header *header = (const Header *)data;
+	const qint64 expectedSize = sizeof(Header) + (qint64)header->alphagramCount * sizeof(AlphagramEntry) + (qint64)header->wordCount * sizeof(WordEntry) + header->letterBytes;
+
+	if (memcmp(header->magic, magicBytes, sizeof(magicBytes)) != 0 || header->version != currentVersion || header->byteOrder != byteOrderMark || size != expectedSize)
+	{
+		m_file.unmap((uchar *)data);
+		m_file.close();
+		return false;
+	}
+
+	m_data = data;
+	m_header = header;
+	m_alphagrams = (const AlphagramEntry *)(data + sizeof(Header));
+	m_words = (const WordEntry *)(m_alphagrams + header->alphagramCount);
+	m_letters = (const char *)(m_words + header->wordCount);
+	return true;
+}
+
+void AlphagramIndex::unload()
+{
+	if (m_data)
+		m_file.unmap((uchar *)m_data);
+
+	if (m_file.isOpen())
+		m_file.close();
+
+	m_data = 0;
+	m_header = 0;
+	m_alphagrams = 0;
+	m_words = 0;
+	m_letters = 0;
+}
+
+string AlphagramIndex::hashString() const
+{
+	if (!m_header)
+		return string();
+
+	const char hex[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
+	string ret;
+	for (size_t i = 0; i < sizeof(m_header->hash); i++)
+	{
+		ret.push_back(hex[(m_header->hash[i] & 0xF0) >> 4]);
+		ret.push_back(hex[m_header->hash[i] & 0x0F]);
+	}
+	return ret;
+}
+
+int AlphagramIndex::compare(int alphagramIndex, const Quackle::LetterString &alphagram) const
+{
+	const AlphagramEntry &entry = m_alphagrams[alphagramIndex];
+	if (entry.length != alphagram.length())
+		return entry.length < alphagram.length()? -1 : 1;
+
+	return memcmp(m_letters + entry.letters, alphagram.constData(), entry.length);
+}
+
+int AlphagramIndex::findAlphagram(const Quackle::LetterString &alphagram) const
+{
+	int first = 0;
+	int last = alphagramCount();
+	while (first < last)
+	{
+		const int middle = first + (last - first) / 2;
+		const int comparison = compare(middle, alphagram);
+		if (comparison == 0)
+			return middle;
+
+		if (comparison < 0)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+
+	return -1;
+}
+
+void AlphagramIndex::lengthRange(int length, int *first, int *last) const
+{
+	const AlphagramEntry *begin = m_alphagrams;
+	const AlphagramEntry *end = m_alphagrams + alphagramCount();
+
+	*first = lower_bound(begin, end, length, [](const AlphagramEntry &entry, int length) { return entry.length < length; }) - begin;
+	*last = upper_bound(begin, end, length, [](int length, const AlphagramEntry &entry) { return length < entry.length; }) - begin;
+}
+
+bool AlphagramIndex::matches(int alphagramIndex, const char *counts, bool anyLetters, bool mayLeaveLetters) const
+{
+	const AlphagramEntry &entry = m_alphagrams[alphagramIndex];
+	const char *letters = m_letters + entry.letters;
+
+	// letters of the alphagram that counts doesn't hold
+	int missing = 0;
+	int used = 0;
+
+	// alphagram is sorted, so equal letters come in runs
+	int i = 0;
+	while (i < entry.length)
+	{
+		const Quackle::Letter letter = letters[i];
+		int run = 1;
+		while (i + run < entry.length && letters[i + run] == letter)
+			++run;
+
+		const int available = counts[letter];
+		if (run > available)
+		{
+			missing += run - available;
+			used += available;
+		}
+		else
+			used += run;
+
+		i += run;
+	}
+
+	const int blanks = counts[QUACKLE_BLANK_MARK];
+	if (!anyLetters && missing > blanks)
+		return false;
+
+	if (mayLeaveLetters)
+		return true;
+
+	int total = 0;
+	for (int j = QUACKLE_FIRST_LETTER; j < QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE; ++j)
+		total += counts[j];
+
+	return used == total && missing >= blanks;
+}
+
+////////////
+
+AlphagramIndexFactory::AlphagramIndexFactory()
+{
+}
+
+void AlphagramIndexFactory::pushWord(const Quackle::LetterString &word, bool british, int playability)
+{
+	Entry entry;
+	entry.alphagram = Quackle::String::alphabetize(word);
+	entry.word = word;
+	entry.british = british;
+	entry.playability = playability;
+	entry.order = m_entries.size();
+	m_entries.push_back(entry);
+}
+
+bool AlphagramIndexFactory::entryLessThan(const Entry &entry1, const Entry &entry2)
+{
+	if (entry1.alphagram.length() != entry2.alphagram.length())
+		return entry1.alphagram.length() < entry2.alphagram.length();
+	if (entry1.alphagram != entry2.alphagram)
+		return entry1.alphagram < entry2.alphagram;
+	if (entry1.word != entry2.word)
+		return entry1.word < entry2.word;
+	return entry1.order < entry2.order;
+}
+
+bool AlphagramIndexFactory::writeIndex(const string &filename, const char *hash)
+{
+	sort(m_entries.begin(), m_entries.end(), entryLessThan);
+
+	// the last push of a word wins
+	vector<Entry> entries;
+	for (vector<Entry>::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+	{
+		if (!entries.empty() && entries.back().word == (*it).word)
+			entries.back() = *it;
+		else
+			entries.push_back(*it);
+	}
+
+	vector<AlphagramIndex::AlphagramEntry> alphagrams;
+	vector<AlphagramIndex::WordEntry> words;
+	string letters;
+
+	for (vector<Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+	{
+		if (alphagrams.empty() || (*it).alphagram != (it - 1)->alphagram)
+		{
+			AlphagramIndex::AlphagramEntry alphagram;
+			memset(&alphagram, 0, sizeof(alphagram));
+			alphagram.letters = letters.size();
+			alphagram.firstWord = words.size();
+			alphagram.length = (*it).alphagram.length();
+			alphagrams.push_back(alphagram);
+			letters.append((*it).alphagram.constData(), (*it).alphagram.length());
+		}
+
+		AlphagramIndex::WordEntry word;
+		memset(&word, 0, sizeof(word));
+		word.letters = letters.size();
+		word.playability = (*it).playability;
+		word.flags = (*it).british? AlphagramIndex::BritishWord : 0;
+		words.push_back(word);
+		letters.append((*it).word.constData(), (*it).word.length());
+	}
+
+	// keep the file a multiple of the entry alignment
+	while (letters.size() % sizeof(std::uint32_t) != 0)
+		letters.push_back(QUACKLE_NULL_MARK);
+
+	AlphagramIndex::Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, AlphagramIndex::magicBytes, sizeof(header.magic));
+	header.version = AlphagramIndex::currentVersion;
+	header.byteOrder = AlphagramIndex::byteOrderMark;
+	memcpy(header.hash, hash, sizeof(header.hash));
+	header.alphagramCount = alphagrams.size();
+	header.wordCount = words.size();
+	header.letterBytes = letters.size();
+
+	ofstream out(filename.c_str(), ios::out | ios::binary | ios::trunc);
+	if (!out.is_open())
+		return false;
+
+	out.write((const char *)&header, sizeof(header));
+	if (!alphagrams.empty())
+		out.write((const char *)&alphagrams[0], alphagrams.size() * sizeof(AlphagramIndex::AlphagramEntry));
+	if (!words.empty())
+		out.write((const char *)&words[0], words.size() * sizeof(AlphagramIndex::WordEntry));
+	out.write(letters.data(), letters.size());
+
+	return out.good();
+}
@@ -0,0 +1,213 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_ALPHAGRAMINDEX_H
+#define QUACKLE_ALPHAGRAMINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <QFile>
+
+#include <alphabetparameters.h>
+
+// An alphagram index lists every word of a lexicon under its alphagram.
+// Alphagrams are sorted by length and then by letters, and the words
+// of each alphagram are numbered consecutively, so finding the anagrams
+// of some letters is a binary search and listing all alphagrams with
+// some property is a linear scan. Each word carries the playability
+// and british flag of its DAWG entry.
+//
+// The file is written by the dawg tools next to the DAWG, named
+// LEXICON.alphagrams, and is memory mapped when read.
+
+namespace QuackleIO
+{
+
+class AlphagramIndex
+{
+public:
+	AlphagramIndex();
+	~AlphagramIndex();
+
+	// Map filename. Returns false, leaving the index unloaded, if the
+	// file can't be mapped or is not an alphagram index.
+	bool load(const QString &filename);
+	void unload();
+	bool isLoaded() const;
+
+	// hex digest of the words the index was built from; matches
+	// LexiconParameters::hashString(false) of the DAWG built alongside
+	std::string hashString() const;
+
+	int alphagramCount() const;
+	int wordCount() const;
+
+	// index of the alphagram with exactly these letters, or -1
+	int findAlphagram(const Quackle::LetterString &alphagram) const;
+
+	// alphagrams of this length are numbered [*first, *last)
+	void lengthRange(int length, int *first, int *last) const;
+
+	Quackle::LetterString alphagram(int alphagramIndex) const;
+	int alphagramLength(int alphagramIndex) const;
+
+	// words of the alphagram are numbered [*first, *last),
+	// in alphabetical order
+	void wordRange(int alphagramIndex, int *first, int *last) const;
+
+	Quackle::LetterString word(int wordIndex, int length) const;
+	int playability(int wordIndex) const;
+	bool isBritish(int wordIndex) const;
+
+	// Whether the letters of alphagram can be drawn from counts, which
+	// holds letter counts as filled in by Quackle::String::counts with
+	// blanks at QUACKLE_BLANK_MARK. Unless anyLetters, no more than the
+	// blanks can stand for letters not in counts; unless mayLeaveLetters,
+	// all the letters and blanks of counts must be used.
+	bool matches(int alphagramIndex, const char *counts, bool anyLetters, bool mayLeaveLetters) const;
+
+	struct Header
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t byteOrder;
+		char hash[16];
+		std::uint32_t alphagramCount;
+		std::uint32_t wordCount;
+		std::uint32_t letterBytes;
+		std::uint32_t reserved;
+	};
+
+	struct AlphagramEntry
+	{
+		std::uint32_t letters;
+		std::uint32_t firstWord;
+		std::uint8_t length;
+		std::uint8_t padding[3];
+	};
+
+	struct WordEntry
+	{
+		std::uint32_t letters;
+		std::uint32_t playability;
+		std::uint8_t flags;
+		std::uint8_t padding[3];
+	};
+
+	enum WordFlags { BritishWord = 0x01 };
+
+	static const char magicBytes[8];
+	static const std::uint32_t currentVersion = 1;
+	static const std::uint32_t byteOrderMark = 0x01020304;
+
+private:
+	int compare(int alphagramIndex, const Quackle::LetterString &alphagram) const;
+
+	QFile m_file;
+	const uchar *m_data;
+
+	const Header *m_header;
+	const AlphagramEntry *m_alphagrams;
+	const WordEntry *m_words;
+	const char *m_letters;
+};
+
+// Collects words as the dawg tools read them and writes the index.
+class AlphagramIndexFactory
+{
+public:
+	AlphagramIndexFactory();
+
+	// word is not blanked; a word pushed again replaces its earlier entry
+	void pushWord(const Quackle::LetterString &word, bool british, int playability);
+	int wordCount() const;
+
+	// hash is the 16 byte digest of the words, as in the DAWG
+	bool writeIndex(const std::string &filename, const char *hash);
+
+private:
+	struct Entry
+	{
+		Quackle::LetterString alphagram;
+		Quackle::LetterString word;
+		bool british;
+		int playability;
+		int order;
+	};
+
+	static bool entryLessThan(const Entry &entry1, const Entry &entry2);
+
+	std::vector<Entry> m_entries;
+};
+
+inline bool AlphagramIndex::isLoaded() const
+{
+	return m_data != 0;
+}
+
+inline int AlphagramIndex::alphagramCount() const
+{
+	return m_header? m_header->alphagramCount : 0;
+}
+
+inline int AlphagramIndex::wordCount() const
+{
+	return m_header? m_header->wordCount : 0;
+}
+
+inline int AlphagramIndex::alphagramLength(int alphagramIndex) const
+{
+	return m_alphagrams[alphagramIndex].length;
+}
+
+inline Quackle::LetterString AlphagramIndex::alphagram(int alphagramIndex) const
+{
+	return Quackle::LetterString(m_letters + m_alphagrams[alphagramIndex].letters, m_alphagrams[alphagramIndex].length);
+}
+
+inline void AlphagramIndex::wordRange(int alphagramIndex, int *first, int *last) const
+{
+	*first = m_alphagrams[alphagramIndex].firstWord;
+	*last = alphagramIndex + 1 < alphagramCount()? m_alphagrams[alphagramIndex + 1].firstWord : wordCount();
+}
+
+inline Quackle::LetterString AlphagramIndex::word(int wordIndex, int length) const
+{
+	return Quackle::LetterString(m_letters + m_words[wordIndex].letters, length);
+}
+
+inline int AlphagramIndex::playability(int wordIndex) const
+{
+	return m_words[wordIndex].playability;
+}
+
+inline bool AlphagramIndex::isBritish(int wordIndex) const
+{
+	return (m_words[wordIndex].flags & BritishWord) != 0;
+}
+
+inline int AlphagramIndexFactory::wordCount() const
+{
+	return m_entries.size();
+}
+
+}
+
+#endif
@@ -17,6 +17,7 @@
  */
 
 
+#include <algorithm>
 #include <iomanip>
 #include <ios>
 #include <iostream>
@@ -29,18 +30,13 @@
 
 DawgFactory::DawgFactory(const QString &alphabetFile)
 	: m_encodableWords(0), m_unencodableWords(0), m_duplicateWords(0),
-	m_countsByLength(Quackle::FixedLengthString::maxSize, 0)
+	m_countsByLength(Quackle::FixedLengthString::maxSize, 0),
+	m_rootList(0), m_nodeCount(0)
 {
 	QuackleIO::FlexibleAlphabetParameters *flexure = new QuackleIO::FlexibleAlphabetParameters;
 	flexure->load(alphabetFile);
 	m_alphas = flexure;
 
-	m_root.insmallerdict = false;
-	m_root.playability = 0;
-	m_root.c = QUACKLE_BLANK_MARK;
-	m_root.pointer = 0;
-	m_root.lastchild = true;
-
 	m_hash.int32ptr[0] = m_hash.int32ptr[1] = m_hash.int32ptr[2] = m_hash.int32ptr[3] = 0;
 }
 
@@ -62,15 +58,33 @@ bool DawgFactory::pushWord(const UVString &word, bool inSmaller, int playability
 
 bool DawgFactory::pushWord(const Quackle::LetterString &word, bool inSmaller, int playability)
 {
-	if (m_root.pushWord(word, inSmaller, playability))
+	if (word.empty())
+		return false;
+
+	// a duplicate still replaces the flags of its node, so it does in the index too
+	m_alphagramIndex.pushWord(word, !inSmaller, playability == 0 ? 1 : playability);
+
+	Word entry;
+	entry.letters = word;
+	entry.inSmaller = inSmaller;
+	entry.playability = playability == 0 ? 1 : playability; // word terminators nodes are marked by nonzero playability in the v1 DAWG format
+
+	const string key(word.constData(), word.length());
+	unordered_map<string, int>::const_iterator it = m_wordIndices.find(key);
+	if (it != m_wordIndices.end())
 	{
-		++m_encodableWords;
-		++m_countsByLength[word.length()];
-		hashWord(word);
-		return true;
+		m_words[it->second] = entry;
+		++m_duplicateWords;
+		return false;
 	}
-	++m_duplicateWords;
-	return false;
+
+	m_wordIndices[key] = m_words.size();
+	m_words.push_back(entry);
+
+	++m_encodableWords;
+	++m_countsByLength[word.length()];
+	hashWord(word);
+	return true;
 }
 
 void DawgFactory::hashWord(const Quackle::LetterString &word)
@@ -86,58 +100,53 @@ void DawgFactory::hashWord(const Quackle::LetterString &word)
 
 void DawgFactory::generate()
 {
-	const int bucketcount = 2000;
-	vector< int > bucket[bucketcount];
+	// words starting with each letter make a partition
+	const int numberOfPartitions = QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE;
+	vector< vector<int> > partitions(numberOfPartitions);
+	for (unsigned int i = 0; i < m_words.size(); i++)
+		partitions[(int)m_words[i].letters[0]].push_back(i);
 
-	m_nodelist.clear();
-	m_nodelist.push_back(&m_root);
-	m_root.print(m_nodelist);
+	auto build = [&](int partition, QuackleIO::LexiconBuilder &builder)
+	{
+		vector<int> &indices = partitions[partition];
+		sort(indices.begin(), indices.end(), [&](int i, int j) { return m_words[i].letters < m_words[j].letters; });
 
-	m_nodelist[0]->letterSum();
+		for (vector<int>::const_iterator it = indices.begin(); it != indices.end(); ++it)
+			builder.addString(m_words[*it].letters, m_words[*it].playability, m_words[*it].inSmaller);
 
-	for (unsigned int i = 0; i < m_nodelist.size(); i++)
+		vector<int>().swap(indices);
+		return builder.finish();
+	};
+
+	m_builder.clear();
+	m_rootList = m_builder.buildPartitions(numberOfPartitions, build);
+
+	// and one for the root
+	m_nodeCount = m_builder.nodeCount() + 1;
+}
+
+bool DawgFactory::writeIndex(const string &filename)
+{
+	// Lists are laid out from the root's down. Pointers are absolute, but
+	// the root's children must come first, right after the root itself.
+	vector<unsigned int> positions(m_builder.listCount(), 0);
+	unsigned int position = 1;
+	for (int list = m_rootList; list > 0; --list)
 	{
-		bucket[m_nodelist[i]->sum % bucketcount].push_back(i);
-		m_nodelist[i]->pointer = 0;
-		m_nodelist[i]->written = false;
-		m_nodelist[i]->deleted = false;
-		m_nodelist[i]->cloneof = NULL;
+		positions[list] = position;
+		position += m_builder.listLength(list);
 	}
 
-	for (int b = 0; b < bucketcount; b++)
+	if (position > 0x00FFFFFF)
 	{
-		if (bucket[b].size() == 0)
-			continue;
-		for (vector<int>::iterator it = bucket[b].begin(); it != bucket[b].end() - 1; it++)
-		{
-			if (!m_nodelist[(*it)]->deleted)
-			{	
-				for (vector<int>::iterator jt = it + 1; jt != bucket[b].end(); jt++)
-				{
-					if (!m_nodelist[(*jt)]->deleted)
-					{
-						// cout << "Comparing " << (*it) << " and " << (*jt) << endl;
-						if (m_nodelist[(*it)]->equals(m_nodelist[(*jt)][0]))
-						{
-							//cout << "Hey! " << (*it) << " == " << (*jt) << endl;
-							// ones[l].erase(jt);
-							m_nodelist[(*jt)]->deleted = true;
-							m_nodelist[(*jt)]->cloneof = m_nodelist[(*it)];
-						}
-					}
-				}
-			}
-		}
+		UVcerr << "DAWG of " << position << " nodes is too large for the DAWG format" << endl;
+		return false;
 	}
-	
-	m_nodelist.clear();
-	m_nodelist.push_back(&m_root);
-	m_root.print(m_nodelist);
-}
 
-void DawgFactory::writeIndex(const string &filename)
-{
 	ofstream out(filename.c_str(), ios::out | ios::binary);
+	if (!out.is_open())
+		return false;
+
 	unsigned char bytes[7];
 
 	bytes[0] = (m_encodableWords & 0x00FF0000) >> 16;
@@ -156,37 +165,54 @@ void DawgFactory::writeIndex(const string &filename)
 		out << utf8LetterText << ' ';
 	}
 
-	for (unsigned int i = 0; i < m_nodelist.size(); i++) {
-		//cout << m_nodelist[i]->c << " " << m_nodelist[i]->pointer << " " << m_nodelist[i]->t << " " << m_nodelist[i]->lastchild << endl;
-		Node* n = m_nodelist[i];
-		unsigned int p;
-		if (m_nodelist[i]->deleted)
+	// the root
+	QuackleIO::LexiconBuilder::Node root;
+	root.letter = QUACKLE_BLANK_MARK;
+	root.value = 0;
+	root.flag = false;
+	root.children = m_rootList;
+	writeNode(out, root, m_rootList == 0 ? 0 : positions[m_rootList], true);
+
+	for (int list = m_rootList; list > 0; --list)
+	{
+		const int length = m_builder.listLength(list);
+		for (int i = 0; i < length; i++)
 		{
-			p = (unsigned int)(m_nodelist[i]->cloneof->pointer);
-			// n = m_nodelist[i]->cloneof;
-		}
-		else
-			p = (unsigned int)(m_nodelist[i]->pointer);
-
-		bytes[0] = (p & 0x00FF0000) >> 16;
-		bytes[1] = (p & 0x0000FF00) >>  8;
-		bytes[2] = (p & 0x000000FF);
-		bytes[3] = n->c - QUACKLE_FIRST_LETTER;
-				
-		unsigned int pb = n->playability;
-		bytes[4] = (pb & 0x00FF0000) >> 16;
-		bytes[5] = (pb & 0x0000FF00) >>  8;
-		bytes[6] = (pb & 0x000000FF);
-
-		if (n->lastchild) {
-			bytes[3] |= 64;
-		}
-		if (n->insmallerdict) {
-			bytes[3] |= 128;
+			const QuackleIO::LexiconBuilder::Node &node = m_builder.node(list, i);
+			writeNode(out, node, node.children == 0 ? 0 : positions[node.children], i == length - 1);
 		}
+	}
+
+	return out.good();
+}
 
-		out.write((char*)bytes, 7);
+void DawgFactory::writeNode(ofstream &out, const QuackleIO::LexiconBuilder::Node &node, unsigned int p, bool lastchild)
+{
+	unsigned char bytes[7];
+
+	bytes[0] = (p & 0x00FF0000) >> 16;
+	bytes[1] = (p & 0x0000FF00) >>  8;
+	bytes[2] = (p & 0x000000FF);
+	bytes[3] = node.letter - QUACKLE_FIRST_LETTER;
+
+	unsigned int pb = node.value;
+	bytes[4] = (pb & 0x00FF0000) >> 16;
+	bytes[5] = (pb & 0x0000FF00) >>  8;
+	bytes[6] = (pb & 0x000000FF);
+
+	if (lastchild) {
+		bytes[3] |= 64;
 	}
+	if (node.flag) {
+		bytes[3] |= 128;
+	}
+
+	out.write((char*)bytes, 7);
+}
+
+bool DawgFactory::writeAlphagramIndex(const string &filename)
+{
+	return m_alphagramIndex.writeIndex(filename, m_hash.charptr);
 }
 
 string DawgFactory::letterCountString() const
@@ -206,121 +232,3 @@ string DawgFactory::letterCountString() const
 	}
 	return str.str();
 }
-
-
-void DawgFactory::Node::print(vector< Node* > &nodelist)
-{
-	written = true;
-	
-	if (children.size() == 0)
-		return;
-
-	if (!deleted)
-	{
-		//cout << "  Setting pointer to " << nodelist.size() << " before I push_back the children." << endl;
-		pointer = nodelist.size();
-	}
-	else
-	{
-		pointer = cloneof->pointer;
-		//cout << "  Setting pointer to clone's (" << pointer << ") and not pushing anything." << endl;
-	}
-
-	if (!deleted)
-	{
-		for (unsigned int i = 0; i < children.size(); i++) {
-			nodelist.push_back(&children[i]);
-		}
-
-		for (unsigned int i = 0; i < children.size(); i++) {
-			if (!children[i].deleted)
-				children[i].print(nodelist);
-			else if (!children[i].cloneof->written)
-				children[i].cloneof->print(nodelist);
-		}
-	}
-
-	if (children.size() > 0)	
-		children[children.size() - 1].lastchild = true;
-}
-
-
-// returns true if the word was actually added...false if it's a duplicate.
-bool DawgFactory::Node::pushWord(const Quackle::LetterString &word, bool inSmaller, int pb)
-{
-	bool added;
-	if (word.length() == 0) {
-		added = (playability == 0);
-		playability = (pb == 0) ? 1 : pb; // word terminators nodes are marked by nonzero playability in the v1 DAWG format
-		insmallerdict = inSmaller;
-	}
-	else {
-		char first = word[0];
-		Quackle::LetterString rest = word.substr(1, word.length() - 1);
-		int index = -1;
- 
-		// cout << "first: " << first << ", rest: " << rest << endl;
-
-		for (unsigned int i = 0; i < children.size(); i++) {
-			if (children[i].c == first) {
-				index = i;
-				break;
-			}
-		}
-		
-		if (index == -1) {
-			Node n;
-			n.c = first;
-			n.playability = 0;
-			n.insmallerdict = false;
-			n.pointer = 0;
-			n.lastchild = false;
-			children.push_back(n);
-			index = children.size() - 1;
-		}
-
-		added = children[index].pushWord(rest, inSmaller, pb);
-	}
-
-	sumexplored = false;
-	deleted = false;
-	written = false;
-	return added;
-}
-
-
-bool DawgFactory::Node::equals(const Node &n) const
-{
-	if (playability != n.playability)
-		return false;
-	if (c != n.c)
-		return false;
-	if (children.size() != n.children.size())
-		return false;
-	if (insmallerdict != n.insmallerdict)
-		return false;
-	if (sum != n.sum)
-		return false;
-
-	for (unsigned int i = 0; i < children.size(); i++)
-		if (!children[i].equals(n.children[i]))
-			return false;
-	
-	return true;
-}
-
-int DawgFactory::Node::letterSum() const
-{
-	if (sumexplored)
-		return sum;
-	
-	sumexplored = true;
-
-	// djb2 checksum
-	sum = 5381 * 33 + (int) c;
-
-	for (unsigned int i = 0; i < children.size(); i++)
-		sum = (sum << 5) + sum + children[i].letterSum();
-
-	return sum;
-}
@@ -21,8 +21,11 @@
 
 #include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
+#include "alphagramindex.h"
 #include "flexiblealphabet.h"
+#include "lexiconbuilder.h"
 
 
 class DawgFactory {
@@ -33,7 +36,8 @@ public:
 
 	int wordCount() const { return m_encodableWords; };
 	string letterCountString() const;
-	int nodeCount() const { return m_nodelist.size(); };
+	// nodes written to the DAWG; zero until generate is called
+	int nodeCount() const { return m_nodeCount; };
 	int encodableWords() const { return m_encodableWords; };
 	int unencodableWords() const { return m_unencodableWords; };
 	int duplicateWords() const { return m_duplicateWords; };
@@ -41,46 +45,42 @@ public:
 	bool pushWord(const UVString &word, bool inSmaller, int playability);
 	bool pushWord(const Quackle::LetterString &word, bool inSmaller, int playability);
 	void hashWord(const Quackle::LetterString &word);
+
+	// Builds the minimized DAWG of the words pushed so far, the words
+	// of each first letter on a thread of their own.
 	void generate();
-	void writeIndex(const string &filename);
+	bool writeIndex(const string &filename);
+
+	// index of the words pushed so far by alphagram; see alphagramindex.h
+	bool writeAlphagramIndex(const string &filename);
 
 	const char* hashBytes() { return m_hash.charptr; };
 
 private:
-	class Node {
-	public:
-		bool pushWord(const Quackle::LetterString& word, bool inSmaller, int pb);
-		void print(vector< Node* > &m_nodelist);
-
-		int letterSum() const;
-		bool equals(const Node &n) const;
-
-		Quackle::Letter c;
-		bool insmallerdict;
-		int playability; // if nonzero, then terminates word
-
-		vector<Node> children;
-		int pointer;
-		int location;
-
-		bool lastchild;
-
-		mutable bool sumexplored;
-		mutable unsigned int sum;
-		mutable vector<int> counts;
-			
-		bool deleted;
-		Node* cloneof;
-		bool written;
+	struct Word
+	{
+		Quackle::LetterString letters;
+		bool inSmaller;
+		int playability;
 	};
 
+	static void writeNode(ofstream &out, const QuackleIO::LexiconBuilder::Node &node, unsigned int p, bool lastchild);
+
 	int m_encodableWords;
 	int m_unencodableWords;
 	int m_duplicateWords;
-	vector< Node* > m_nodelist;
 	vector<unsigned int> m_countsByLength;
 	Quackle::AlphabetParameters *m_alphas;
-	Node m_root;
+
+	// words in the order pushed, and where each is in m_words
+	vector<Word> m_words;
+	unordered_map<string, int> m_wordIndices;
+
+	QuackleIO::LexiconBuilder m_builder;
+	std::uint32_t m_rootList;
+	int m_nodeCount;
+
+	QuackleIO::AlphagramIndexFactory m_alphagramIndex;
 	union {
 		char charptr[16];
 		std::int32_t int32ptr[4];
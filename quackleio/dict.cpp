@@ -122,6 +122,24 @@ ExtensionList Word::getExtensionList(bool front) const
 	return ret;
 }
 
+WordListList Querier::queryBatch(const QStringList &queries, int flags, QueryObserver *observer)
+{
+	WordListList ret;
+
+	for (int i = 0; i < queries.size(); ++i)
+	{
+		if (observer && observer->shouldAbort())
+			break;
+
+		ret.append(query(queries.at(i), flags));
+
+		if (observer)
+			observer->answered(i, ret.last());
+	}
+
+	return ret;
+}
+
 Extension::Extension(const Quackle::ExtensionWithInfo extensionWithInfo)
 {
 	playability = extensionWithInfo.playability;
@@ -71,6 +71,22 @@ public:
 
 typedef QList<WordList> WordListList;
 
+// Hears of the answers of Querier::queryBatch as they come in.
+// Every call is made on the thread that called queryBatch.
+class QueryObserver
+{
+public:
+	virtual ~QueryObserver() {};
+
+	// answer to query number index; answers come in query order
+	virtual void answered(int index, const WordList &words) = 0;
+
+	// Called every few tens of milliseconds while the batch runs, so
+	// a GUI can process events here. Return true to cancel the queries
+	// not yet answered.
+	virtual bool shouldAbort() { return false; }
+};
+
 class Querier
 {
 public:
@@ -79,6 +95,18 @@ public:
 	enum QueryFlags { None = 0x0000, WithExtensions = 0x0001, NoRequireAllLetters = 0x0002, CallUpdate = 0x0004 };
 
 	virtual WordList query(const QString &query, int flags = None) = 0;
+
+	// Answer each of queries as query() would, in order. Implementations
+	// may answer several queries at once on worker threads. If the
+	// observer aborts, only the answers reached so far are returned.
+	virtual WordListList queryBatch(const QStringList &queries, int flags = None, QueryObserver *observer = 0);
+
+	// Words of the whole lexicon matching pattern, a restricted regular
+	// expression as described in Quackle::WordPattern, in alphabetical
+	// order. Returns an empty list and sets error, if given, if the
+	// pattern is not in the restricted syntax.
+	virtual WordList patternQuery(const QString &pattern, int flags = None, QString *error = 0) = 0;
+
 	virtual QString alphagram(const QString &letters) const = 0;
 	virtual bool isBritish(const Quackle::LetterString &word) = 0;
 	virtual bool isLoaded() const = 0;
@@ -16,10 +16,19 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include <alphabetparameters.h>
+#include <bag.h>
 #include <datamanager.h>
 #include <generator.h>
 #include <lexiconparameters.h>
+#include <wordpattern.h>
 #include <quackleio/util.h>
 
 #include "dictimplementation.h"
@@ -33,6 +42,101 @@ QuackleIO::DictImplementation::~DictImplementation()
 }
 
 Dict::WordList QuackleIO::DictImplementation::query(const QString &query, int flags)
+{
+	ensureAlphagramIndex();
+	Dict::WordList::sortType = sortTypeFor(flags);
+	return answer(m_generator, query, flags);
+}
+
+Dict::WordListList QuackleIO::DictImplementation::queryBatch(const QStringList &queries, int flags, Dict::QueryObserver *observer)
+{
+	ensureAlphagramIndex();
+	Dict::WordList::sortType = sortTypeFor(flags);
+
+	const int total = queries.size();
+	vector<Dict::WordList> answers(total);
+	vector<char> isAnswered(total, false);
+
+	mutex answersMutex;
+	condition_variable answerReady;
+	atomic<int> nextQuery(0);
+	atomic<bool> aborted(false);
+
+	// workers evaluate in the data manager of the calling thread
+	Quackle::DataManager *dataManager = QUACKLE_DATAMANAGER;
+
+	auto work = [&]()
+	{
+		Quackle::DataManagerScope scope(dataManager);
+		Quackle::Generator generator;
+
+		for (int index = nextQuery++; index < total && !aborted; index = nextQuery++)
+		{
+			Dict::WordList words = answer(generator, queries.at(index), flags);
+
+			lock_guard<mutex> lock(answersMutex);
+			answers[index] = words;
+			isAnswered[index] = true;
+			answerReady.notify_one();
+		}
+	};
+
+	const int numberOfThreads = min(total, max(1, (int)thread::hardware_concurrency()));
+	vector<thread> threads;
+	for (int i = 0; i < numberOfThreads; ++i)
+		threads.push_back(thread(work));
+
+	// hand answers out in order on this thread
+	const chrono::milliseconds observerInterval(50);
+	chrono::steady_clock::time_point lastPoll = chrono::steady_clock::now();
+
+	Dict::WordListList ret;
+	unique_lock<mutex> lock(answersMutex);
+	while (ret.size() < total)
+	{
+		const int next = ret.size();
+		if (isAnswered[next])
+		{
+			ret.append(answers[next]);
+			answers[next] = Dict::WordList();
+
+			if (observer)
+			{
+				lock.unlock();
+				observer->answered(next, ret.last());
+				lock.lock();
+			}
+		}
+		else
+			answerReady.wait_for(lock, observerInterval);
+
+		if (observer && chrono::steady_clock::now() - lastPoll >= observerInterval)
+		{
+			lock.unlock();
+			const bool shouldAbort = observer->shouldAbort();
+			lock.lock();
+
+			if (shouldAbort)
+				break;
+
+			lastPoll = chrono::steady_clock::now();
+		}
+	}
+	lock.unlock();
+
+	aborted = true;
+	for (auto &it : threads)
+		it.join();
+
+	return ret;
+}
+
+Dict::WordList::SortType QuackleIO::DictImplementation::sortTypeFor(int flags)
+{
+	return (flags & NoRequireAllLetters)? Dict::WordList::LengthLongestFirst : Dict::WordList::Alphabetical;
+}
+
+Dict::WordList QuackleIO::DictImplementation::answer(Quackle::Generator &generator, const QString &query, int flags) const
 {
 	QString modifiedQuery = query;
 	modifiedQuery.replace(".", "?");
@@ -51,33 +155,72 @@ Dict::WordList QuackleIO::DictImplementation::query(const QString &query, int fl
 		modifiedQuery.replace(wildcardRegexp, QString());
 	}
 
-	vector<Quackle::LetterString> words(m_generator.anagramLetters(QuackleIO::Util::encode(modifiedQuery), anagramFlags));
+	const Quackle::LetterString letters(QuackleIO::Util::encode(modifiedQuery));
 	Dict::WordList ret;
 
-	vector<Quackle::LetterString>::const_iterator end = words.end();
-	for (vector<Quackle::LetterString>::const_iterator it = words.begin(); it != end; ++it)
+	if (m_alphagramIndex.isLoaded())
 	{
-		Dict::Word dictWord;
-		dictWord.word = QuackleIO::Util::letterStringToQString(*it);
-		dictWord.wordLetterString = (*it);
-		m_generator.storeWordInfo(&dictWord);
-
-		if (flags & WithExtensions)
-			m_generator.storeExtensions(&dictWord);
+		ret = indexedAnagrams(letters, anagramFlags);
+	}
+	else
+	{
+		vector<Quackle::LetterString> words(generator.anagramLetters(letters, anagramFlags));
 
-		ret.push_back(dictWord);
+		vector<Quackle::LetterString>::const_iterator end = words.end();
+		for (vector<Quackle::LetterString>::const_iterator it = words.begin(); it != end; ++it)
+		{
+			Dict::Word dictWord;
+			dictWord.word = QuackleIO::Util::letterStringToQString(*it);
+			dictWord.wordLetterString = (*it);
+			generator.storeWordInfo(&dictWord);
+			ret.push_back(dictWord);
+		}
 	}
 
-	if (flags & NoRequireAllLetters)
+	if (flags & WithExtensions)
 	{
-		ret.setSortBy(Dict::WordList::LengthLongestFirst);
+		for (Dict::WordList::iterator it = ret.begin(); it != ret.end(); ++it)
+			generator.storeExtensions(&(*it));
 	}
-	else
+
+	// sorts by Dict::WordList::sortType, set by the caller
+	qSort(ret);
+
+	return ret;
+}
+
+Dict::WordList QuackleIO::DictImplementation::patternQuery(const QString &pattern, int flags, QString *error)
+{
+	Quackle::WordPattern wordPattern;
+	UVString compileError;
+	if (!wordPattern.compile(QuackleIO::Util::qstringToString(pattern), Quackle::WordPattern::Regex, &compileError))
 	{
-		ret.setSortBy(Dict::WordList::Alphabetical);
+		if (error)
+			*error = QuackleIO::Util::uvStringToQString(compileError);
+		return Dict::WordList();
 	}
 
-	qSort(ret);
+	// matchingWords finds words in alphabetical order
+	Dict::WordList::sortType = Dict::WordList::Alphabetical;
+
+	vector<Quackle::WordWithInfo> words(m_generator.matchingWords(wordPattern));
+	Dict::WordList ret;
+
+	vector<Quackle::WordWithInfo>::const_iterator end = words.end();
+	for (vector<Quackle::WordWithInfo>::const_iterator it = words.begin(); it != end; ++it)
+	{
+		Dict::Word dictWord;
+		dictWord.word = QuackleIO::Util::letterStringToQString((*it).wordLetterString);
+		dictWord.wordLetterString = (*it).wordLetterString;
+		dictWord.playability = (*it).playability;
+		dictWord.probability = (*it).probability;
+		dictWord.british = (*it).british;
+
+		if (flags & WithExtensions)
+			m_generator.storeExtensions(&dictWord);
+
+		ret.push_back(dictWord);
+	}
 
 	return ret;
 }
@@ -94,9 +237,112 @@ bool QuackleIO::DictImplementation::isLoaded() const
 
 bool QuackleIO::DictImplementation::isBritish(const Quackle::LetterString &word)
 {
+	if (ensureAlphagramIndex())
+	{
+		const int alphagramIndex = m_alphagramIndex.findAlphagram(Quackle::String::alphabetize(word));
+		if (alphagramIndex < 0)
+			return false;
+
+		int first, last;
+		m_alphagramIndex.wordRange(alphagramIndex, &first, &last);
+		for (int i = first; i < last; ++i)
+			if (m_alphagramIndex.word(i, word.length()) == word)
+				return m_alphagramIndex.isBritish(i);
+
+		return false;
+	}
+
 	Quackle::WordWithInfo wordWithInfo;
 	wordWithInfo.wordLetterString = word;
 	m_generator.storeWordInfo(&wordWithInfo);
 	return wordWithInfo.british;
 }
 
+
+bool QuackleIO::DictImplementation::ensureAlphagramIndex()
+{
+	const string lexicon = QUACKLE_LEXICON_PARAMETERS->lexiconName();
+	const string hash = QUACKLE_LEXICON_PARAMETERS->hashString(false);
+
+	if (lexicon == m_alphagramIndexLexicon && hash == m_alphagramIndexHash)
+		return m_alphagramIndex.isLoaded();
+
+	m_alphagramIndexLexicon = lexicon;
+	m_alphagramIndexHash = hash;
+	m_alphagramIndex.unload();
+
+	if (lexicon.empty() || !QUACKLE_LEXICON_PARAMETERS->hasSomething())
+		return false;
+
+	const string filename = Quackle::LexiconParameters::findDictionaryFile(lexicon + ".alphagrams");
+	if (filename.empty() || !m_alphagramIndex.load(QString::fromStdString(filename)))
+		return false;
+
+	// an index left over from another version of the lexicon is no use
+	if (m_alphagramIndex.hashString() != hash)
+		m_alphagramIndex.unload();
+
+	return m_alphagramIndex.isLoaded();
+}
+
+Dict::WordList QuackleIO::DictImplementation::indexedAnagrams(const Quackle::LetterString &letters, int anagramFlags) const
+{
+	Dict::WordList ret;
+
+	const Quackle::LetterString clearedLetters(Quackle::String::clearBlankness(letters));
+	char counts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
+	Quackle::String::counts(clearedLetters, counts);
+
+	const bool anyLetters = (anagramFlags & Quackle::Generator::AddAnyLetters) != 0;
+	const bool mayLeaveLetters = (anagramFlags & Quackle::Generator::NoRequireAllLetters) != 0;
+	const int length = clearedLetters.length();
+
+	int first;
+	int last;
+	int unused;
+
+	if (!anyLetters && !mayLeaveLetters && counts[QUACKLE_BLANK_MARK] == 0)
+	{
+		first = m_alphagramIndex.findAlphagram(Quackle::String::alphabetize(clearedLetters));
+		last = first < 0? first : first + 1;
+	}
+	else if (anyLetters)
+	{
+		m_alphagramIndex.lengthRange(length, &first, &unused);
+		last = m_alphagramIndex.alphagramCount();
+	}
+	else if (mayLeaveLetters)
+	{
+		first = 0;
+		m_alphagramIndex.lengthRange(length, &unused, &last);
+	}
+	else
+	{
+		m_alphagramIndex.lengthRange(length, &first, &last);
+	}
+
+	for (int alphagramIndex = first; alphagramIndex < last; ++alphagramIndex)
+	{
+		if (!m_alphagramIndex.matches(alphagramIndex, counts, anyLetters, mayLeaveLetters))
+			continue;
+
+		const int wordLength = m_alphagramIndex.alphagramLength(alphagramIndex);
+
+		int firstWord;
+		int lastWord;
+		m_alphagramIndex.wordRange(alphagramIndex, &firstWord, &lastWord);
+
+		for (int wordIndex = firstWord; wordIndex < lastWord; ++wordIndex)
+		{
+			Dict::Word dictWord;
+			dictWord.wordLetterString = m_alphagramIndex.word(wordIndex, wordLength);
+			dictWord.word = QuackleIO::Util::letterStringToQString(dictWord.wordLetterString);
+			dictWord.probability = Quackle::Bag::probabilityOfDrawingFromFullBag(dictWord.wordLetterString);
+			dictWord.playability = m_alphagramIndex.playability(wordIndex);
+			dictWord.british = m_alphagramIndex.isBritish(wordIndex);
+			ret.push_back(dictWord);
+		}
+	}
+
+	return ret;
+}
@@ -19,8 +19,11 @@
 #ifndef QUACKLE_DICTIMPLEMENTATION_H
 #define QUACKLE_DICTIMPLEMENTATION_H
 
+#include <string>
+
 #include <generator.h>
 
+#include "alphagramindex.h"
 #include "dict.h"
 
 namespace QuackleIO
@@ -33,12 +36,39 @@ public:
 	virtual ~DictImplementation();
 
 	virtual Dict::WordList query(const QString &query, int flags = None);
+
+	// answers queries on one worker thread per hardware thread,
+	// each with its own Generator
+	virtual Dict::WordListList queryBatch(const QStringList &queries, int flags = None, Dict::QueryObserver *observer = 0);
+
+	// walks the lexicon only along prefixes the pattern can match
+	virtual Dict::WordList patternQuery(const QString &pattern, int flags = None, QString *error = 0);
+
 	virtual QString alphagram(const QString &letters) const;
 	virtual bool isBritish(const Quackle::LetterString &word);
 	virtual bool isLoaded() const;
 
 private:
+	static Dict::WordList::SortType sortTypeFor(int flags);
+
+	// Answer query using generator. Safe to call from several threads
+	// at once with different generators once ensureAlphagramIndex()
+	// has been called.
+	Dict::WordList answer(Quackle::Generator &generator, const QString &query, int flags) const;
+
+	// Loads the alphagram index of the current lexicon if there is
+	// one built from the same words. Returns whether one is loaded.
+	bool ensureAlphagramIndex();
+
+	// words matching letters under anagramLetters flags, looked up
+	// in the alphagram index rather than the lexicon
+	Dict::WordList indexedAnagrams(const Quackle::LetterString &letters, int anagramFlags) const;
+
 	Quackle::Generator m_generator;
+
+	AlphagramIndex m_alphagramIndex;
+	std::string m_alphagramIndexLexicon;
+	std::string m_alphagramIndexHash;
 };
 
 }
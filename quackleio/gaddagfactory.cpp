@@ -17,6 +17,7 @@
  */
 
 
+#include <algorithm>
 #include <iostream>
 #include <QtCore>
 #include <QCryptographicHash>
@@ -25,7 +26,7 @@
 #include "util.h"
 
 GaddagFactory::GaddagFactory(const UVString &alphabetFile)
-	: m_encodableWords(0), m_unencodableWords(0), m_alphas(NULL)
+	: m_encodableWords(0), m_unencodableWords(0), m_alphas(NULL), m_rootList(0), m_nodeCount(0)
 {
 	if (!alphabetFile.empty())
 	{
@@ -34,12 +35,6 @@ GaddagFactory::GaddagFactory(const UVString &alphabetFile)
 		m_alphas = flexure;
 	}
 
-	// So the separator is sorted to last.
-	m_root.t = false;
-	m_root.c = QUACKLE_NULL_MARK;  // "_"
-	m_root.pointer = 0;
-	m_root.lastchild = true;
-
 	m_hash.int32ptr[0] = m_hash.int32ptr[1] = m_hash.int32ptr[2] = m_hash.int32ptr[3] = 0;
 }
 
@@ -70,22 +65,41 @@ bool GaddagFactory::pushWord(const Quackle::LetterString &word)
 	// But testing for duplicate words isn't so easy without keeping
 	// an entirely separate list.
 
-	for (unsigned i = 1; i <= word.length(); i++)
-	{
-		Quackle::LetterString newword;
+	m_words.push_back(word);
+	return true;
+}
 
-		for (int j = i - 1; j >= 0; j--)
-			newword.push_back(word[j]);
+void GaddagFactory::gaddagize(Quackle::Letter first, Quackle::WordList *strings) const
+{
+	Quackle::WordList::const_iterator wordsEnd = m_words.end();
+	for (Quackle::WordList::const_iterator wordsIt = m_words.begin(); wordsIt != wordsEnd; ++wordsIt)
+	{
+		const Quackle::LetterString &word = *wordsIt;
 
-		if (i < word.length())
+		// the string for i starts with word[i - 1]
+		for (unsigned i = 1; i <= word.length(); i++)
 		{
-			newword.push_back(internalSeparatorRepresentation);  // "^"
-			for (unsigned j = i; j < word.length(); j++)
+			if (word[i - 1] != first)
+				continue;
+
+			Quackle::LetterString newword;
+
+			for (int j = i - 1; j >= 0; j--)
 				newword.push_back(word[j]);
+
+			if (i < word.length())
+			{
+				newword.push_back(internalSeparatorRepresentation);  // "^"
+				for (unsigned j = i; j < word.length(); j++)
+					newword.push_back(word[j]);
+			}
+			strings->push_back(newword);
 		}
-		m_gaddagizedWords.push_back(newword);
 	}
-	return true;
+
+	// So the separator is sorted to last.
+	sort(strings->begin(), strings->end());
+	strings->erase(unique(strings->begin(), strings->end(), [](const Quackle::LetterString &a, const Quackle::LetterString &b) { return a == b; }), strings->end());
 }
 
 void GaddagFactory::hashWord(const Quackle::LetterString &word)
@@ -101,100 +115,96 @@ void GaddagFactory::hashWord(const Quackle::LetterString &word)
 
 void GaddagFactory::generate()
 {
-	sort(m_gaddagizedWords.begin(), m_gaddagizedWords.end());
-	Quackle::WordList::const_iterator wordsEnd = m_gaddagizedWords.end();
-	for (Quackle::WordList::const_iterator wordsIt = m_gaddagizedWords.begin(); wordsIt != wordsEnd; ++wordsIt)
-		m_root.pushWord(*wordsIt);
-	//	for (const auto& words : gaddaggizedWords)
-	//		m_root.pushWord(words);
-}
-
-void GaddagFactory::writeIndex(const string &fname)
-{
-	m_nodelist.push_back(&m_root);
-
-	m_root.print(m_nodelist);    
-
-	ofstream out(fname.c_str(), ios::out | ios::binary);
-
-	out.put(1); // GADDAG format version 1
-	out.write(m_hash.charptr, sizeof(m_hash.charptr));
-
-	for (size_t i = 0; i < m_nodelist.size(); i++)
+	// gaddagized strings starting with each letter make a partition
+	auto build = [&](int partition, QuackleIO::LexiconBuilder &builder)
 	{
-		unsigned int p = (unsigned int)(m_nodelist[i]->pointer);
-		if (p != 0)
-			p -= i; // offset indexing
-
-		char bytes[4];
-		unsigned char n1 = (p & 0x00FF0000) >> 16;
-		unsigned char n2 = (p & 0x0000FF00) >> 8;
-		unsigned char n3 = (p & 0x000000FF) >> 0;
-		unsigned char n4; 
+		Quackle::WordList strings;
+		gaddagize(QUACKLE_FIRST_LETTER + partition, &strings);
 
-		n4 = m_nodelist[i]->c;
-		if (n4 == internalSeparatorRepresentation)
-			n4 = QUACKLE_NULL_MARK;
+		Quackle::WordList::const_iterator stringsEnd = strings.end();
+		for (Quackle::WordList::const_iterator stringsIt = strings.begin(); stringsIt != stringsEnd; ++stringsIt)
+			builder.addString(*stringsIt, 1, false);
 
-		if (m_nodelist[i]->t)
-			n4 |= 64;
+		return builder.finish();
+	};
 
-		if (m_nodelist[i]->lastchild)
-			n4 |= 128;
+	m_builder.clear();
+	m_rootList = m_builder.buildPartitions(QUACKLE_MAXIMUM_ALPHABET_SIZE, build);
 
-		bytes[0] = n1; bytes[1] = n2; bytes[2] = n3; bytes[3] = n4;
-		out.write(bytes, 4);
-	}
+	// and one for the root
+	m_nodeCount = m_builder.nodeCount() + 1;
 }
 
-
-void GaddagFactory::Node::print(vector< Node* >& nodelist)
+bool GaddagFactory::writeIndex(const string &fname)
 {
-	if (children.size() > 0)
+	// Pointers are offsets forward from the node, so each list must come
+	// after every node pointing to it. A list is numbered higher than the
+	// lists below it, so laying them out in decreasing order does that.
+	vector<unsigned int> positions(m_builder.listCount(), 0);
+	unsigned int position = 1;
+	for (int list = m_rootList; list > 0; --list)
 	{
-		pointer = nodelist.size();
-		children[children.size() - 1].lastchild = true;
+		positions[list] = position;
+		position += m_builder.listLength(list);
 	}
 
-	for (size_t i = 0; i < children.size(); i++)
-		nodelist.push_back(&children[i]);
+	ofstream out(fname.c_str(), ios::out | ios::binary);
+	if (!out.is_open())
+		return false;
 
-	for (size_t i = 0; i < children.size(); i++)
-		children[i].print(nodelist);
-}
+	out.put(1); // GADDAG format version 1
+	out.write(m_hash.charptr, sizeof(m_hash.charptr));
 
+	// the root
+	QuackleIO::LexiconBuilder::Node root;
+	root.letter = QUACKLE_NULL_MARK;  // "_"
+	root.value = 0;
+	root.flag = false;
+	root.children = m_rootList;
 
-void GaddagFactory::Node::pushWord(const Quackle::LetterString& word)
-{
-	if (word.length() == 0)
-	{
-		t = true;
-		return;
-	}
-
-	Quackle::Letter first = Quackle::String::front(word);
-	Quackle::LetterString rest = Quackle::String::allButFront(word);
-	int index = -1;
+	unsigned int index = 0;
+	bool fits = writeNode(out, root, m_rootList == 0 ? 0 : positions[m_rootList] - index, true);
 
-	for (size_t i = 0; i < children.size(); i++)
+	for (int list = m_rootList; list > 0; --list)
 	{
-		if (children[i].c == first)
+		const int length = m_builder.listLength(list);
+		for (int i = 0; i < length; i++)
 		{
-			index = i;
-			i = children.size();
+			++index;
+			const QuackleIO::LexiconBuilder::Node &node = m_builder.node(list, i);
+			fits = writeNode(out, node, node.children == 0 ? 0 : positions[node.children] - index, i == length - 1) && fits;
 		}
 	}
 
-	if (index == -1)
+	if (!fits)
 	{
-		Node n;
-		n.c = first;
-		n.t = false;
-		n.pointer = 0;
-		n.lastchild = false;
-		children.push_back(n);
-		index = children.size() - 1;
+		UVcerr << "GADDAG of " << m_nodeCount << " nodes overflows node pointers" << endl;
+		return false;
 	}
 
-	children[index].pushWord(rest);
+	return out.good();
+}
+
+bool GaddagFactory::writeNode(ofstream &out, const QuackleIO::LexiconBuilder::Node &node, unsigned int p, bool lastchild)
+{
+	char bytes[4];
+	unsigned char n1 = (p & 0x00FF0000) >> 16;
+	unsigned char n2 = (p & 0x0000FF00) >> 8;
+	unsigned char n3 = (p & 0x000000FF) >> 0;
+	unsigned char n4; 
+
+	n4 = node.letter;
+	if (n4 == internalSeparatorRepresentation)
+		n4 = QUACKLE_NULL_MARK;
+
+	if (node.value != 0)
+		n4 |= 64;
+
+	if (lastchild)
+		n4 |= 128;
+
+	bytes[0] = n1; bytes[1] = n2; bytes[2] = n3; bytes[3] = n4;
+	out.write(bytes, 4);
+
+	return p <= 0x00FFFFFF;
 }
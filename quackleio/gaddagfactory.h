@@ -21,10 +21,10 @@
 
 #include <cstdint>
 #include "flexiblealphabet.h"
+#include "lexiconbuilder.h"
 
 // This isn't a strict maximum...you can go higher...but too much higher, and you risk overflowing
-// node pointers, which will get you garbage words.  The OSPS dictionary is known to trigger
-// such overflows.
+// node pointers, which writeIndex refuses to do.
 const int QUACKLE_MAX_GADDAG_WORDCOUNT = 500000;
 
 class GaddagFactory {
@@ -35,39 +35,42 @@ public:
 	GaddagFactory(const UVString &alphabetFile);
 	~GaddagFactory();
 
-	int wordCount() const { return m_gaddagizedWords.size(); };
-	int nodeCount() const { return m_nodelist.size(); };
+	int wordCount() const { return m_words.size(); };
+	// nodes written to the GADDAG; zero until generate is called
+	int nodeCount() const { return m_nodeCount; };
 	int encodableWords() const { return m_encodableWords; };
 	int unencodableWords() const { return m_unencodableWords; };
 
 	bool pushWord(const UVString &word);
 	bool pushWord(const Quackle::LetterString &word);
 	void hashWord(const Quackle::LetterString &word);
-	void sortWords() { sort(m_gaddagizedWords.begin(), m_gaddagizedWords.end()); };
+
+	// Builds the minimized GADDAG of the words pushed so far. The
+	// gaddagized strings starting with each letter are made, sorted and
+	// built on a thread of their own, so only a few of the partitions
+	// are expanded at any time.
 	void generate();
-	void writeIndex(const string &fname);
+	bool writeIndex(const string &fname);
 
 	const char* hashBytes() { return m_hash.charptr; };
 
 
 private:
-	class Node {
-		public:
-			Quackle::Letter c;
-			bool t;
-			vector<Node> children;
-			int pointer;
-			bool lastchild;
-			void pushWord(const Quackle::LetterString& word);
-			void print(vector< Node* >& m_nodelist);
-	};
+	// those gaddagized strings of all the words that start with first, sorted
+	void gaddagize(Quackle::Letter first, Quackle::WordList *strings) const;
+
+	// returns false if p doesn't fit
+	static bool writeNode(ofstream &out, const QuackleIO::LexiconBuilder::Node &node, unsigned int p, bool lastchild);
 
 	int m_encodableWords;
 	int m_unencodableWords;
-	Quackle::WordList m_gaddagizedWords;
-	vector< Node* > m_nodelist;
+	Quackle::WordList m_words;
 	Quackle::AlphabetParameters *m_alphas;
-	Node m_root;
+
+	QuackleIO::LexiconBuilder m_builder;
+	std::uint32_t m_rootList;
+	int m_nodeCount;
+
 	union {
 		char charptr[16];
 		std::int32_t int32ptr[4];
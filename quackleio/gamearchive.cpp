@@ -0,0 +1,590 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include <QByteArray>
+
+#include <game.h>
+
+#include "gamearchive.h"
+#include "util.h"
+
+using namespace std;
+using namespace QuackleIO;
+
+namespace
+{
+
+enum MoveFlags { ActionMask = 0x0F, Horizontal = 0x10, ChallengedPhoney = 0x20, HasNote = 0x40, Bingo = 0x80 };
+
+inline uint32_t readNumber(const unsigned char *&data)
+{
+	uint32_t ret = 0;
+	int shift = 0;
+	while (*data & 0x80)
+	{
+		ret |= (uint32_t)(*data++ & 0x7F) << shift;
+		shift += 7;
+	}
+
+	ret |= (uint32_t)(*data++) << shift;
+	return ret;
+}
+
+inline int readSignedNumber(const unsigned char *&data)
+{
+	const uint32_t zigzag = readNumber(data);
+	return (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+}
+
+inline const char *readString(const unsigned char *&data, int *length)
+{
+	*length = readNumber(data);
+	const char *ret = (const char *)data;
+	data += *length;
+	return ret;
+}
+
+inline const unsigned char *readRack(const unsigned char *&data, int *letters)
+{
+	*letters = readNumber(data);
+	const unsigned char *ret = data;
+	data += 2 * *letters;
+	return ret;
+}
+
+void writeNumber(QByteArray &out, uint32_t number)
+{
+	while (number >= 0x80)
+	{
+		out.append((char)((number & 0x7F) | 0x80));
+		number >>= 7;
+	}
+
+	out.append((char)number);
+}
+
+void writeSignedNumber(QByteArray &out, int number)
+{
+	writeNumber(out, ((uint32_t)number << 1) ^ (uint32_t)(number >> 31));
+}
+
+void writeString(QByteArray &out, const UVString &string)
+{
+	const QByteArray utf8 = Util::uvStringToQString(string).toUtf8();
+	writeNumber(out, utf8.size());
+	out.append(utf8);
+}
+
+void writeRack(QByteArray &out, const Quackle::Rack &rack)
+{
+	char counts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
+	Quackle::String::counts(rack.tiles(), counts);
+
+	int letters = 0;
+	for (int i = 0; i < QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE; ++i)
+		if (counts[i] > 0)
+			++letters;
+
+	writeNumber(out, letters);
+	for (int i = 0; i < QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE; ++i)
+	{
+		if (counts[i] > 0)
+		{
+			out.append((char)i);
+			out.append(counts[i]);
+		}
+	}
+}
+
+Quackle::Rack rackFromCounts(const unsigned char *rack, int letters)
+{
+	Quackle::LetterString tiles;
+	for (int i = 0; i < letters; ++i)
+		for (int j = 0; j < rack[2 * i + 1]; ++j)
+			tiles.push_back(rack[2 * i]);
+
+	return Quackle::Rack(tiles);
+}
+
+UVString utf8ToString(const char *data, int length)
+{
+	return Util::qstringToString(QString::fromUtf8(data, length));
+}
+
+}
+
+Quackle::Rack MoveRecord::rack() const
+{
+	return rackFromCounts(m_rack, m_rackLetters);
+}
+
+void MoveRecord::rackCounts(char *countsArray) const
+{
+	memset(countsArray, 0, QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE);
+	for (int i = 0; i < m_rackLetters; ++i)
+		countsArray[m_rack[2 * i]] = m_rack[2 * i + 1];
+}
+
+Quackle::LetterString MoveRecord::tiles() const
+{
+	return Quackle::LetterString((const char *)m_tiles, m_tileCount);
+}
+
+Quackle::Move MoveRecord::move() const
+{
+	Quackle::Move ret;
+
+	switch (action)
+	{
+	case Quackle::Move::Place:
+	case Quackle::Move::PlaceError:
+		ret = Quackle::Move::createPlaceMove(startrow, startcol, horizontal, tiles());
+		break;
+
+	case Quackle::Move::Exchange:
+	case Quackle::Move::BlindExchange:
+		ret = Quackle::Move::createExchangeMove(tiles(), action == Quackle::Move::BlindExchange);
+		break;
+
+	case Quackle::Move::Pass:
+		ret = Quackle::Move::createPassMove();
+		break;
+
+	case Quackle::Move::UnusedTilesBonus:
+	case Quackle::Move::UnusedTilesBonusError:
+		ret = Quackle::Move::createUnusedTilesBonus(tiles(), score);
+		break;
+
+	case Quackle::Move::TimePenalty:
+		ret = Quackle::Move::createTimePenalty(-score);
+		break;
+
+	case Quackle::Move::Nonmove:
+		ret = Quackle::Move::createNonmove();
+		break;
+	}
+
+	ret.action = action;
+	ret.score = score;
+	ret.isBingo = isBingo;
+	ret.setScoreAddition(scoreAddition);
+	ret.setIsChallengedPhoney(isChallengedPhoney);
+	return ret;
+}
+
+UVString MoveRecord::explanatoryNote() const
+{
+	return utf8ToString(m_note, m_noteLength);
+}
+
+////////////
+
+GameRecord::const_iterator::const_iterator(const unsigned char *data, int remaining)
+	: m_data(data), m_remaining(remaining)
+{
+	if (m_remaining > 0)
+		decode();
+}
+
+GameRecord::const_iterator &GameRecord::const_iterator::operator++()
+{
+	if (--m_remaining > 0)
+		decode();
+	return *this;
+}
+
+void GameRecord::const_iterator::decode()
+{
+	const unsigned char flags = *m_data++;
+	m_move.action = (Quackle::Move::Action)(flags & ActionMask);
+	m_move.horizontal = flags & Horizontal;
+	m_move.isChallengedPhoney = flags & ChallengedPhoney;
+	m_move.isBingo = flags & Bingo;
+
+	m_move.player = readNumber(m_data);
+	m_move.m_rack = readRack(m_data, &m_move.m_rackLetters);
+
+	if (m_move.action == Quackle::Move::Place || m_move.action == Quackle::Move::PlaceError)
+	{
+		m_move.startrow = readNumber(m_data);
+		m_move.startcol = readNumber(m_data);
+	}
+	else
+	{
+		m_move.startrow = 0;
+		m_move.startcol = 0;
+	}
+
+	int tileCount;
+	m_move.m_tiles = (const Quackle::Letter *)readString(m_data, &tileCount);
+	m_move.m_tileCount = tileCount;
+
+	m_move.score = readSignedNumber(m_data);
+	m_move.scoreAddition = readSignedNumber(m_data);
+
+	if (flags & HasNote)
+		m_move.m_note = readString(m_data, &m_move.m_noteLength);
+	else
+	{
+		m_move.m_note = 0;
+		m_move.m_noteLength = 0;
+	}
+}
+
+GameRecord::GameRecord()
+	: m_title(0), m_titleLength(0), m_description(0), m_descriptionLength(0), m_finalRackPlayer(-1), m_finalRack(0), m_finalRackLetters(0), m_moveCount(0), m_moves(0)
+{
+}
+
+GameRecord::GameRecord(const unsigned char *data)
+{
+	const int playerCount = readNumber(data);
+	m_players.resize(playerCount);
+	for (int i = 0; i < playerCount; ++i)
+	{
+		m_players[i].id = readNumber(data);
+		m_players[i].abbreviation = readString(data, &m_players[i].abbreviationLength);
+		m_players[i].name = readString(data, &m_players[i].nameLength);
+	}
+
+	m_title = readString(data, &m_titleLength);
+	m_description = readString(data, &m_descriptionLength);
+
+	// stored one higher, so zero means none
+	m_finalRackPlayer = (int)readNumber(data) - 1;
+	m_finalRack = readRack(data, &m_finalRackLetters);
+
+	m_moveCount = readNumber(data);
+	m_moves = data;
+}
+
+GameRecord GameRecord::decode(const QByteArray &record)
+{
+	return GameRecord((const unsigned char *)record.constData());
+}
+
+Quackle::Player GameRecord::player(int index) const
+{
+	const PlayerEntry &entry = m_players[index];
+	Quackle::Player ret(utf8ToString(entry.name, entry.nameLength), Quackle::Player::HumanPlayerType, entry.id);
+	ret.setAbbreviatedName(utf8ToString(entry.abbreviation, entry.abbreviationLength));
+	return ret;
+}
+
+UVString GameRecord::title() const
+{
+	return utf8ToString(m_title, m_titleLength);
+}
+
+UVString GameRecord::description() const
+{
+	return utf8ToString(m_description, m_descriptionLength);
+}
+
+GameRecord::const_iterator GameRecord::begin() const
+{
+	return const_iterator(m_moves, m_moveCount);
+}
+
+GameRecord::const_iterator GameRecord::end() const
+{
+	return const_iterator(0, 0);
+}
+
+Quackle::Rack GameRecord::finalRack() const
+{
+	return rackFromCounts(m_finalRack, m_finalRackLetters);
+}
+
+Quackle::Game *GameRecord::createGame(int flags) const
+{
+	const bool canMaintainCrosses = flags & Logania::MaintainBoardPreparation;
+
+	Quackle::Game *ret = new Quackle::Game;
+	ret->setTitle(title());
+	ret->setDescription(description());
+
+	Quackle::PlayerList players;
+	for (int i = 0; i < playerCount(); ++i)
+		players.push_back(player(i));
+	ret->setPlayers(players);
+
+	// this follows GCGIO::read, minus the parsing and rescoring
+	for (const_iterator it = begin(); it != end(); ++it)
+	{
+		const MoveRecord &record = *it;
+
+		if (record.action == Quackle::Move::UnusedTilesBonus || record.action == Quackle::Move::UnusedTilesBonusError)
+		{
+			if (ret->hasPositions() && !ret->currentPosition().gameOver())
+				ret->commitCandidate(canMaintainCrosses);
+			else
+				ret->addPosition();
+
+			ret->currentPosition().setTileBonus(players[record.player].abbreviatedName(), record.tiles(), record.score);
+		}
+		else
+		{
+			if (ret->hasPositions())
+				ret->commitCandidate(canMaintainCrosses);
+			else
+				ret->addPosition();
+
+			ret->currentPosition().setCurrentPlayerRack(record.rack());
+
+			Quackle::Move move = record.move();
+			ret->currentPosition().ensureMovePrettiness(move);
+			ret->currentPosition().setMoveMade(move);
+		}
+
+		if (record.hasExplanatoryNote())
+			ret->currentPosition().setExplanatoryNote(record.explanatoryNote());
+	}
+
+	if (!ret->hasPositions() || !ret->currentPosition().gameOver())
+	{
+		if (ret->hasPositions())
+			ret->commitCandidate(canMaintainCrosses);
+		else
+			ret->addPosition();
+
+		if (m_finalRackPlayer >= 0)
+			ret->currentPosition().setPlayerRack(m_finalRackPlayer, finalRack());
+	}
+
+	return ret;
+}
+
+////////////
+
+const char GameArchive::magicBytes[8] = { 'Q', 'G', 'A', 'M', 'E', 'A', 'R', 'C' };
+
+GameArchive::GameArchive()
+	: m_data(0), m_header(0), m_index(0)
+{
+}
+
+GameArchive::~GameArchive()
+{
+	unload();
+}
+
+bool GameArchive::load(const QString &filename)
+{
+	unload();
+
+	m_file.setFileName(filename);
+	if (!m_file.open(QIODevice::ReadOnly))
+		return false;
+
+	const qint64 size = m_file.size();
+	if (size < (qint64)sizeof(Header))
+	{
+		m_file.close();
+		return false;
+	}
+
+	const uchar *data = m_file.map(0, size);
+	if (!data)
+	{
+		m_file.close();
+		return false;
+	}
+
+	const Header *header = (const Header *)data;
+	const bool indexFits = header->indexOffset >= sizeof(Header) && header->indexOffset % sizeof(std::uint64_t) == 0 && (qint64)header->indexOffset + ((qint64)header->gameCount + 1) * (qint64)sizeof(std::uint64_t) == size;
+
+	if (memcmp(header->magic, magicBytes, sizeof(magicBytes)) != 0 || header->version != currentVersion || header->byteOrder != byteOrderMark || !indexFits)
+	{
+		m_file.unmap((uchar *)data);
+		m_file.close();
+		return false;
+	}
+
+	m_data = data;
+	m_header = header;
+	m_index = (const std::uint64_t *)(data + header->indexOffset);
+	return true;
+}
+
+void GameArchive::unload()
+{
+	if (m_data)
+		m_file.unmap((uchar *)m_data);
+
+	if (m_file.isOpen())
+		m_file.close();
+
+	m_data = 0;
+	m_header = 0;
+	m_index = 0;
+}
+
+////////////
+
+GameArchiveWriter::GameArchiveWriter()
+{
+}
+
+GameArchiveWriter::~GameArchiveWriter()
+{
+	if (m_file.isOpen())
+		close();
+}
+
+bool GameArchiveWriter::open(const QString &filename)
+{
+	m_file.setFileName(filename);
+	if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	// the header is rewritten by close() once the index is known
+	GameArchive::Header header;
+	memset(&header, 0, sizeof(header));
+	if (m_file.write((const char *)&header, sizeof(header)) != sizeof(header))
+	{
+		m_file.close();
+		return false;
+	}
+
+	m_offsets.clear();
+	m_offsets.push_back(sizeof(header));
+	return true;
+}
+
+bool GameArchiveWriter::addGame(const Quackle::Game &game)
+{
+	const QByteArray record = encode(game);
+	if (m_file.write(record) != record.size())
+		return false;
+
+	m_offsets.push_back(m_offsets.back() + record.size());
+	return true;
+}
+
+bool GameArchiveWriter::close()
+{
+	// align the index
+	const QByteArray padding((sizeof(std::uint64_t) - m_offsets.back() % sizeof(std::uint64_t)) % sizeof(std::uint64_t), 0);
+	bool ok = m_file.write(padding) == padding.size();
+
+	GameArchive::Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, GameArchive::magicBytes, sizeof(header.magic));
+	header.version = GameArchive::currentVersion;
+	header.byteOrder = GameArchive::byteOrderMark;
+	header.gameCount = gameCount();
+	header.indexOffset = m_offsets.back() + padding.size();
+
+	const qint64 indexBytes = m_offsets.size() * sizeof(std::uint64_t);
+	ok = ok && m_file.write((const char *)&m_offsets[0], indexBytes) == indexBytes;
+	ok = ok && m_file.seek(0) && m_file.write((const char *)&header, sizeof(header)) == sizeof(header);
+
+	m_file.close();
+	m_offsets.clear();
+	return ok;
+}
+
+QByteArray GameArchiveWriter::encode(const Quackle::Game &game)
+{
+	QByteArray ret;
+
+	const Quackle::PlayerList &players = game.players();
+	writeNumber(ret, players.size());
+	for (Quackle::PlayerList::const_iterator it = players.begin(); it != players.end(); ++it)
+	{
+		writeNumber(ret, (*it).id());
+		writeString(ret, (*it).abbreviatedName());
+		writeString(ret, (*it).name());
+	}
+
+	writeString(ret, game.title());
+	writeString(ret, game.description());
+
+	// index of a player in the game's player list
+	auto playerIndex = [&players](int id)
+	{
+		int index = 0;
+		for (Quackle::PlayerList::const_iterator it = players.begin(); it != players.end(); ++it, ++index)
+			if ((*it).id() == id)
+				return index;
+		return 0;
+	};
+
+	// the rack left when the game ends unfinished, as GCGIO::write puts
+	// in a #rack line
+	if (game.hasPositions() && !game.history().lastPosition().gameOver())
+	{
+		const Quackle::GamePosition &lastPosition = game.history().lastPosition();
+		writeNumber(ret, playerIndex(lastPosition.currentPlayer().id()) + 1);
+		writeRack(ret, lastPosition.currentPlayer().rack());
+	}
+	else
+	{
+		writeNumber(ret, 0);
+		writeNumber(ret, 0);
+	}
+
+	int moveCount = 0;
+	for (Quackle::PositionList::const_iterator it = game.history().begin(); it != game.history().end(); ++it)
+		if ((*it).committedMove().isAMove())
+			++moveCount;
+	writeNumber(ret, moveCount);
+
+	for (Quackle::PositionList::const_iterator it = game.history().begin(); it != game.history().end(); ++it)
+	{
+		const Quackle::Move &move = (*it).committedMove();
+		if (!move.isAMove())
+			continue;
+
+		const bool hasNote = !(*it).explanatoryNote().empty();
+
+		unsigned char flags = move.action & ActionMask;
+		if (move.horizontal)
+			flags |= Horizontal;
+		if (move.isChallengedPhoney())
+			flags |= ChallengedPhoney;
+		if (hasNote)
+			flags |= HasNote;
+		if (move.isBingo)
+			flags |= Bingo;
+
+		ret.append((char)flags);
+		writeNumber(ret, playerIndex((*it).currentPlayer().id()));
+		writeRack(ret, (*it).currentPlayer().rack());
+
+		if (move.action == Quackle::Move::Place || move.action == Quackle::Move::PlaceError)
+		{
+			writeNumber(ret, move.startrow);
+			writeNumber(ret, move.startcol);
+		}
+
+		writeNumber(ret, move.tiles().length());
+		ret.append((const char *)move.tiles().constData(), move.tiles().length());
+
+		writeSignedNumber(ret, move.score);
+		writeSignedNumber(ret, move.scoreAddition());
+
+		if (hasNote)
+			writeString(ret, (*it).explanatoryNote());
+	}
+
+	return ret;
+}
@@ -0,0 +1,276 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_GAMEARCHIVE_H
+#define QUACKLE_GAMEARCHIVE_H
+
+#include <cstdint>
+#include <vector>
+
+#include <QByteArray>
+#include <QFile>
+
+#include <alphabetparameters.h>
+#include <move.h>
+#include <player.h>
+#include <rack.h>
+
+#include "logania.h"
+
+// A game archive holds many games in a compact binary form, for tools
+// that scan whole game collections. Each game record lists its players,
+// title and description, and then its moves as a GCG file would, each
+// with the rack of the player who made it:
+//
+//   numbers     unsigned varints, or zigzag varints where they may be
+//               negative (scores)
+//   strings     a varint byte count and UTF-8 bytes
+//   racks       a varint count of distinct letters and a (letter, count)
+//               byte pair for each, blanks at QUACKLE_BLANK_MARK
+//   tiles       a varint count and the letters of Move::tiles()
+//
+// The records are followed by an index of their offsets, so any game
+// can be found without reading those before it. Archives are memory
+// mapped, and games and their moves are decoded straight from the
+// mapping; only createGame() builds a Quackle::Game, by replaying the
+// moves on a board.
+//
+// GCG files are converted by reading them into a Game with GCGIO and
+// adding that to a GameArchiveWriter, and back by writing the Game from
+// createGame() with GCGIO.
+
+namespace QuackleIO
+{
+
+// One move of a game record, pointing into the archive.
+class MoveRecord
+{
+public:
+	// index of the player in the game record
+	int player;
+
+	Quackle::Move::Action action;
+	bool horizontal;
+	int startrow;
+	int startcol;
+	bool isChallengedPhoney;
+	bool isBingo;
+
+	int score;
+	int scoreAddition;
+
+	// rack of the player before the move
+	Quackle::Rack rack() const;
+
+	// Fills countsArray, of size QUACKLE_FIRST_LETTER +
+	// QUACKLE_MAXIMUM_ALPHABET_SIZE, as Quackle::String::counts would
+	// from the rack's tiles.
+	void rackCounts(char *countsArray) const;
+
+	// as Move::tiles()
+	Quackle::LetterString tiles() const;
+	const Quackle::Letter *tileData() const { return m_tiles; }
+	int tileCount() const { return m_tileCount; }
+
+	Quackle::Move move() const;
+
+	UVString explanatoryNote() const;
+	bool hasExplanatoryNote() const { return m_noteLength > 0; }
+
+private:
+	friend class GameRecord;
+
+	const unsigned char *m_rack;
+	int m_rackLetters;
+	const Quackle::Letter *m_tiles;
+	int m_tileCount;
+	const char *m_note;
+	int m_noteLength;
+};
+
+// A game of an archive. Records are only valid while the archive they
+// came from stays loaded.
+class GameRecord
+{
+public:
+	// walks the moves, decoding one at a time
+	class const_iterator
+	{
+	public:
+		const MoveRecord &operator*() const { return m_move; }
+		const MoveRecord *operator->() const { return &m_move; }
+		const_iterator &operator++();
+		bool operator==(const const_iterator &other) const { return m_remaining == other.m_remaining; }
+		bool operator!=(const const_iterator &other) const { return m_remaining != other.m_remaining; }
+
+	private:
+		friend class GameRecord;
+
+		const_iterator(const unsigned char *data, int remaining);
+		void decode();
+
+		const unsigned char *m_data;
+		int m_remaining;
+		MoveRecord m_move;
+	};
+
+	GameRecord();
+
+	int playerCount() const { return m_players.size(); }
+
+	// Human players with ids and names as in the game.
+	// Their scores and racks are not set.
+	Quackle::Player player(int index) const;
+
+	UVString title() const;
+	UVString description() const;
+
+	int moveCount() const { return m_moveCount; }
+	const_iterator begin() const;
+	const_iterator end() const;
+
+	// index of the player whose rack was known when the game record
+	// ends unfinished, or -1
+	int finalRackPlayer() const { return m_finalRackPlayer; }
+	Quackle::Rack finalRack() const;
+
+	// Replays the moves into a new game, as GCGIO::read would.
+	// See Logania::ReadFlags for flags.
+	Quackle::Game *createGame(int flags = Logania::MaintainBoardPreparation) const;
+
+	// The game GameArchiveWriter::encode made record of. The record
+	// must outlive what is decoded from it, and is trusted as archives
+	// are.
+	static GameRecord decode(const QByteArray &record);
+
+private:
+	friend class GameArchive;
+
+	// decodes the record at data
+	GameRecord(const unsigned char *data);
+
+	struct PlayerEntry
+	{
+		int id;
+		const char *abbreviation;
+		int abbreviationLength;
+		const char *name;
+		int nameLength;
+	};
+
+	std::vector<PlayerEntry> m_players;
+	const char *m_title;
+	int m_titleLength;
+	const char *m_description;
+	int m_descriptionLength;
+	int m_finalRackPlayer;
+	const unsigned char *m_finalRack;
+	int m_finalRackLetters;
+	int m_moveCount;
+	const unsigned char *m_moves;
+};
+
+class GameArchive
+{
+public:
+	GameArchive();
+	~GameArchive();
+
+	// Map filename. Returns false, leaving the archive unloaded, if the
+	// file can't be mapped or is not a game archive.
+	bool load(const QString &filename);
+	void unload();
+	bool isLoaded() const;
+
+	int gameCount() const;
+	GameRecord game(int index) const;
+
+	struct Header
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t byteOrder;
+		std::uint32_t gameCount;
+		std::uint32_t reserved;
+
+		// the index is gameCount + 1 offsets from the start of the
+		// file; game i is in [index[i], index[i + 1])
+		std::uint64_t indexOffset;
+	};
+
+	static const char magicBytes[8];
+	static const std::uint32_t currentVersion = 1;
+	static const std::uint32_t byteOrderMark = 0x01020304;
+
+private:
+	QFile m_file;
+	const uchar *m_data;
+
+	const Header *m_header;
+	const std::uint64_t *m_index;
+};
+
+// Writes games to a new archive one at a time, so converting a
+// collection never needs more than one game in memory.
+class GameArchiveWriter
+{
+public:
+	GameArchiveWriter();
+	~GameArchiveWriter();
+
+	bool open(const QString &filename);
+
+	// Records the moves of the game's history. Returns false if the
+	// record couldn't be written.
+	bool addGame(const Quackle::Game &game);
+	int gameCount() const;
+
+	// writes the index; returns false if the archive couldn't be written
+	bool close();
+
+	// the record of game, as it is stored in the archive
+	static QByteArray encode(const Quackle::Game &game);
+
+private:
+	QFile m_file;
+	std::vector<std::uint64_t> m_offsets;
+};
+
+inline bool GameArchive::isLoaded() const
+{
+	return m_data != 0;
+}
+
+inline int GameArchive::gameCount() const
+{
+	return m_header? m_header->gameCount : 0;
+}
+
+inline GameRecord GameArchive::game(int index) const
+{
+	return GameRecord(m_data + m_index[index]);
+}
+
+inline int GameArchiveWriter::gameCount() const
+{
+	return m_offsets.empty()? 0 : m_offsets.size() - 1;
+}
+
+}
+
+#endif
@@ -0,0 +1,236 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "lexiconbuilder.h"
+
+using namespace std;
+using namespace QuackleIO;
+
+namespace
+{
+
+const size_t initialTableSize = 1024;
+
+}
+
+LexiconBuilder::LexiconBuilder()
+{
+	clear();
+}
+
+void LexiconBuilder::clear()
+{
+	m_open.clear();
+	m_last.clear();
+	m_nodes.clear();
+
+	// list zero is the empty list
+	m_listStarts.assign(2, 0);
+	m_table.assign(initialTableSize, 0);
+}
+
+void LexiconBuilder::addString(const Quackle::LetterString &string, uint32_t value, bool flag)
+{
+	unsigned int common = 0;
+	while (common < m_last.length() && common < string.length() && m_last[common] == string[common])
+		++common;
+
+	// nothing after this string can reach below the first letter that
+	// differs from the last string
+	closeLevels(common + 1);
+
+	if (m_open.size() < string.length() + 1)
+		m_open.resize(string.length() + 1);
+
+	for (unsigned int depth = common; depth < string.length(); ++depth)
+	{
+		Node node;
+		node.letter = string[depth];
+		node.value = 0;
+		node.flag = false;
+		node.children = 0;
+		m_open[depth].push_back(node);
+	}
+
+	if (!string.empty())
+	{
+		Node &last = m_open[string.length() - 1].back();
+		last.value = value;
+		last.flag = flag;
+	}
+
+	m_last = string;
+}
+
+void LexiconBuilder::closeLevels(unsigned int depth)
+{
+	for (unsigned int level = m_open.size(); level-- > depth; )
+	{
+		if (m_open[level].empty())
+			continue;
+
+		m_open[level - 1].back().children = intern(m_open[level]);
+		m_open[level].clear();
+	}
+}
+
+uint32_t LexiconBuilder::finish()
+{
+	closeLevels(1);
+	m_last.clear();
+
+	if (m_open.empty())
+		return 0;
+
+	const uint32_t ret = intern(m_open[0]);
+	m_open[0].clear();
+	return ret;
+}
+
+uint32_t LexiconBuilder::importList(const LexiconBuilder &other, uint32_t list, vector<uint32_t> &memo)
+{
+	if (list == 0)
+		return 0;
+
+	// only nonempty lists are memoized, so zero marks a list not yet seen
+	if (memo.size() < (size_t)other.listCount())
+		memo.resize(other.listCount(), 0);
+
+	if (memo[list] != 0)
+		return memo[list];
+
+	vector<Node> nodes(other.m_nodes.begin() + other.m_listStarts[list], other.m_nodes.begin() + other.m_listStarts[list + 1]);
+	for (vector<Node>::iterator it = nodes.begin(); it != nodes.end(); ++it)
+		(*it).children = importList(other, (*it).children, memo);
+
+	memo[list] = intern(nodes);
+	return memo[list];
+}
+
+uint32_t LexiconBuilder::buildPartitions(int numberOfPartitions, const function<uint32_t (int partition, LexiconBuilder &builder)> &build)
+{
+	vector<LexiconBuilder> builders(numberOfPartitions);
+	vector<uint32_t> roots(numberOfPartitions, 0);
+	atomic<int> nextPartition(0);
+
+	auto work = [&]()
+	{
+		for (int partition = nextPartition++; partition < numberOfPartitions; partition = nextPartition++)
+			roots[partition] = build(partition, builders[partition]);
+	};
+
+	const int numberOfThreads = min(numberOfPartitions, max(1, (int)thread::hardware_concurrency()));
+	vector<thread> threads;
+	for (int i = 0; i < numberOfThreads; ++i)
+		threads.push_back(thread(work));
+	for (auto &it : threads)
+		it.join();
+
+	vector<Node> firstLetters;
+	for (int partition = 0; partition < numberOfPartitions; ++partition)
+	{
+		vector<uint32_t> memo;
+		const LexiconBuilder &builder = builders[partition];
+
+		for (int i = 0; i < builder.listLength(roots[partition]); ++i)
+		{
+			Node node = builder.node(roots[partition], i);
+			node.children = importList(builder, node.children, memo);
+			firstLetters.push_back(node);
+		}
+
+		builders[partition].clear();
+	}
+
+	return intern(firstLetters);
+}
+
+uint32_t LexiconBuilder::intern(const vector<Node> &nodes)
+{
+	if (nodes.empty())
+		return 0;
+
+	const size_t mask = m_table.size() - 1;
+	size_t slot = hashNodes(&nodes[0], nodes.size()) & mask;
+	while (m_table[slot] != 0)
+	{
+		if (nodesEqual(m_table[slot], &nodes[0], nodes.size()))
+			return m_table[slot];
+		slot = (slot + 1) & mask;
+	}
+
+	const uint32_t ret = listCount();
+	m_nodes.insert(m_nodes.end(), nodes.begin(), nodes.end());
+	m_listStarts.push_back(m_nodes.size());
+	m_table[slot] = ret;
+
+	if ((size_t)listCount() * 2 > m_table.size())
+		growTable();
+
+	return ret;
+}
+
+void LexiconBuilder::growTable()
+{
+	m_table.assign(m_table.size() * 2, 0);
+	const size_t mask = m_table.size() - 1;
+
+	for (int list = 1; list < listCount(); ++list)
+	{
+		size_t slot = hashNodes(&m_nodes[m_listStarts[list]], listLength(list)) & mask;
+		while (m_table[slot] != 0)
+			slot = (slot + 1) & mask;
+		m_table[slot] = list;
+	}
+}
+
+uint64_t LexiconBuilder::hashNodes(const Node *nodes, int count)
+{
+	// FNV-1a over the fields of each node
+	uint64_t ret = 14695981039346656037ULL;
+	const uint64_t prime = 1099511628211ULL;
+
+	for (int i = 0; i < count; ++i)
+	{
+		ret = (ret ^ (unsigned char)nodes[i].letter) * prime;
+		ret = (ret ^ nodes[i].value) * prime;
+		ret = (ret ^ nodes[i].flag) * prime;
+		ret = (ret ^ nodes[i].children) * prime;
+	}
+
+	return ret;
+}
+
+bool LexiconBuilder::nodesEqual(uint32_t list, const Node *nodes, int count) const
+{
+	if (listLength(list) != count)
+		return false;
+
+	const Node *listNodes = &m_nodes[m_listStarts[list]];
+	for (int i = 0; i < count; ++i)
+	{
+		if (listNodes[i].letter != nodes[i].letter || listNodes[i].value != nodes[i].value || listNodes[i].flag != nodes[i].flag || listNodes[i].children != nodes[i].children)
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,135 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_LEXICONBUILDER_H
+#define QUACKLE_LEXICONBUILDER_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <alphabetparameters.h>
+
+namespace QuackleIO
+{
+
+// Builds the minimal automaton accepting a set of letter strings, as
+// stored in DAWG and GADDAG files: each node is a letter, a value that
+// is nonzero where a string ends, a flag, and the list of its children.
+//
+// Strings are added in sorted order. Once a string that doesn't share
+// some prefix is added, no later string can reach below that prefix,
+// so its child lists are looked up in a table of the lists built so far
+// and stored only if they are new. The builder therefore never holds
+// more than the minimized automaton plus the path to the last string.
+//
+// Builders for disjoint parts of the input, like the strings starting
+// with each letter, can run on separate threads; importList then merges
+// their automata into one builder, still sharing equal lists.
+class LexiconBuilder
+{
+public:
+	struct Node
+	{
+		Quackle::Letter letter;
+		std::uint32_t value;
+		bool flag;
+
+		// list of children; zero, the empty list, if there are none
+		std::uint32_t children;
+	};
+
+	LexiconBuilder();
+
+	// string must not sort before the string added before it; adding
+	// the same string again replaces its value and flag
+	void addString(const Quackle::LetterString &string, std::uint32_t value, bool flag);
+
+	// Closes the lists still open after the last string and returns the
+	// list of nodes for the first letters of the strings. Strings can be
+	// added again afterwards for a new automaton sharing these lists.
+	std::uint32_t finish();
+
+	// Copies list of other and every list below it into this builder,
+	// returning the list's number here. memo must start out empty and be
+	// reused for each list of the same builder.
+	std::uint32_t importList(const LexiconBuilder &other, std::uint32_t list, std::vector<std::uint32_t> &memo);
+
+	// Calls build for each partition number in [0, numberOfPartitions)
+	// on worker threads, each with an empty builder of its own; build
+	// adds the strings of the partition and returns finish(). The
+	// automata are merged into this builder in partition order, and the
+	// list of all their first letters is returned, so partitions must
+	// hold strings with different first letters, in increasing order.
+	std::uint32_t buildPartitions(int numberOfPartitions, const std::function<std::uint32_t (int partition, LexiconBuilder &builder)> &build);
+
+	// number of a list of these nodes, which is stored if it is new
+	std::uint32_t intern(const std::vector<Node> &nodes);
+
+	// Lists are numbered from zero, the empty list, up. A list is
+	// numbered higher than every list below it.
+	int listCount() const;
+	int listLength(std::uint32_t list) const;
+	const Node &node(std::uint32_t list, int index) const;
+
+	// total nodes of all lists
+	int nodeCount() const;
+
+	void clear();
+
+private:
+	static std::uint64_t hashNodes(const Node *nodes, int count);
+	bool nodesEqual(std::uint32_t list, const Node *nodes, int count) const;
+	void growTable();
+
+	// children of each prefix of the last string added, not yet interned
+	void closeLevels(unsigned int depth);
+	std::vector< std::vector<Node> > m_open;
+	Quackle::LetterString m_last;
+
+	// list i is m_nodes[m_listStarts[i], m_listStarts[i + 1])
+	std::vector<Node> m_nodes;
+	std::vector<std::uint32_t> m_listStarts;
+
+	// open addressing table of list numbers, zero for an empty slot
+	std::vector<std::uint32_t> m_table;
+};
+
+inline int LexiconBuilder::listCount() const
+{
+	return m_listStarts.size() - 1;
+}
+
+inline int LexiconBuilder::listLength(std::uint32_t list) const
+{
+	return m_listStarts[list + 1] - m_listStarts[list];
+}
+
+inline const LexiconBuilder::Node &LexiconBuilder::node(std::uint32_t list, int index) const
+{
+	return m_nodes[m_listStarts[list] + index];
+}
+
+inline int LexiconBuilder::nodeCount() const
+{
+	return m_nodes.size();
+}
+
+}
+
+#endif
@@ -0,0 +1,646 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtCore>
+
+#include <algorithm>
+
+#include <computerplayer.h>
+#include <datamanager.h>
+#include <game.h>
+#include <lexiconparameters.h>
+#include <rolloutpolicy.h>
+#include <sim.h>
+
+#include "gamearchive.h"
+#include "simulationcoordinator.h"
+#include "util.h"
+
+using namespace Quackle;
+using namespace QuackleIO;
+
+namespace
+{
+
+// both ends must agree on this, whatever Qt each was built with
+const int streamVersion = QDataStream::Qt_5_0;
+
+QByteArray lettersToBytes(const LetterString &letters)
+{
+	return QByteArray(letters.constData(), letters.length());
+}
+
+bool bytesToLetters(const QByteArray &bytes, LetterString *letters)
+{
+	if (bytes.size() > QUACKLE_MAXIMUM_BOARD_SIZE)
+		return false;
+
+	*letters = LetterString(bytes.constData(), bytes.size());
+	return true;
+}
+
+void writeMove(QDataStream &stream, const Move &move)
+{
+	stream << (qint32)move.action << move.horizontal << (qint32)move.startrow << (qint32)move.startcol;
+	stream << (qint32)move.score << (qint32)move.scoreAddition() << move.isBingo << move.isChallengedPhoney();
+	stream << move.equity << move.win;
+	stream << lettersToBytes(move.tiles()) << lettersToBytes(move.prettyTiles());
+}
+
+bool readMove(QDataStream &stream, Move *move)
+{
+	qint32 action;
+	bool horizontal;
+	qint32 startrow;
+	qint32 startcol;
+	qint32 score;
+	qint32 scoreAddition;
+	bool isBingo;
+	bool isChallengedPhoney;
+	double equity;
+	double win;
+	QByteArray tileBytes;
+	QByteArray prettyTileBytes;
+
+	stream >> action >> horizontal >> startrow >> startcol >> score >> scoreAddition >> isBingo >> isChallengedPhoney >> equity >> win >> tileBytes >> prettyTileBytes;
+
+	LetterString tiles;
+	LetterString prettyTiles;
+	if (stream.status() != QDataStream::Ok || action < Move::Place || action > Move::Nonmove || !bytesToLetters(tileBytes, &tiles) || !bytesToLetters(prettyTileBytes, &prettyTiles))
+		return false;
+
+	*move = Move::createNonmove();
+	move->action = (Move::Action)action;
+	move->horizontal = horizontal;
+	move->startrow = startrow;
+	move->startcol = startcol;
+	move->score = score;
+	move->setScoreAddition(scoreAddition);
+	move->isBingo = isBingo;
+	move->setIsChallengedPhoney(isChallengedPhoney);
+	move->equity = equity;
+	move->win = win;
+	move->setTiles(tiles);
+	move->setPrettyTiles(prettyTiles);
+	return true;
+}
+
+// sums go as doubles, which every host has the same
+void writeAveragedValue(QDataStream &stream, const AveragedValue &value)
+{
+	stream << (double)value.valueSum() << (double)value.squaredValueSum() << (qint64)value.incorporatedValues();
+}
+
+bool readAveragedValue(QDataStream &stream, AveragedValue *value)
+{
+	double valueSum;
+	double squaredValueSum;
+	qint64 incorporatedValues;
+	stream >> valueSum >> squaredValueSum >> incorporatedValues;
+	if (stream.status() != QDataStream::Ok)
+		return false;
+
+	*value = AveragedValue(valueSum, squaredValueSum, incorporatedValues);
+	return true;
+}
+
+// sanity limits on counts read from a result
+const quint32 maximumLevels = 1000;
+const quint32 maximumPlayers = 100;
+
+}
+
+SimulationWorker::SimulationWorker()
+	: m_position(0), m_plies(0), m_done(false)
+{
+}
+
+void SimulationWorker::serve(QTextStream &in, QTextStream &out)
+{
+	out << "ready" << endl;
+
+	while (!m_done && !in.atEnd())
+	{
+		const QStringList response = handleLine(in.readLine());
+		for (QStringList::const_iterator it = response.begin(); it != response.end(); ++it)
+			out << *it << endl;
+	}
+}
+
+QStringList SimulationWorker::handleLine(const QString &line)
+{
+	QStringList words = line.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+	if (words.isEmpty())
+		return QStringList();
+
+	const QString request = words.front();
+
+	if (request == "quit")
+	{
+		m_done = true;
+		return QStringList();
+	}
+
+	if (request == "position" && words.size() == 2)
+	{
+		QString error;
+		if (!setPosition(QByteArray::fromBase64(words[1].toLatin1()), &error))
+			return QStringList(QString("error %1").arg(error));
+		return QStringList();
+	}
+
+	if (request == "job" && words.size() == 5)
+	{
+		const quint32 position = words[1].toUInt();
+		if (position == 0 || position != m_position)
+			return QStringList(QString("error no position %1").arg(words[1]));
+
+		return QStringList(runJob(position, words[2].toUInt(), words[3].toUInt(), words[4].toInt()));
+	}
+
+	return QStringList(QString("error bad request %1").arg(request));
+}
+
+bool SimulationWorker::setPosition(const QByteArray &data, QString *error)
+{
+	QDataStream stream(data);
+	stream.setVersion(streamVersion);
+
+	quint32 position;
+	QString lexicon;
+	qint32 plies;
+	bool ignoreOppos;
+	qint32 policyType;
+	qint32 sampledMoves;
+	double temperature;
+	qint32 maximumPlies;
+	QByteArray partialOppoRack;
+	QByteArray record;
+	quint32 candidateCount;
+
+	stream >> position >> lexicon >> plies >> ignoreOppos >> policyType >> sampledMoves >> temperature >> maximumPlies >> partialOppoRack >> record >> candidateCount;
+
+	LetterString partialOppoTiles;
+	if (stream.status() != QDataStream::Ok || position == 0 || record.isEmpty() || !bytesToLetters(partialOppoRack, &partialOppoTiles))
+	{
+		*error = "bad position";
+		return false;
+	}
+
+	if (lexicon != QString::fromStdString(QUACKLE_LEXICON_PARAMETERS->lexiconName()))
+	{
+		*error = QString("lexicon %1 is not loaded").arg(lexicon);
+		return false;
+	}
+
+	MoveList candidates;
+	for (quint32 i = 0; i < candidateCount; ++i)
+	{
+		Move move(Move::createNonmove());
+		if (!readMove(stream, &move))
+		{
+			*error = "bad candidate";
+			return false;
+		}
+
+		candidates.push_back(move);
+	}
+
+	Game *game = QuackleIO::GameRecord::decode(record).createGame();
+	if (!game->hasPositions() || game->currentPosition().gameOver())
+	{
+		delete game;
+		*error = "position is over";
+		return false;
+	}
+
+	GamePosition simulatedPosition(game->currentPosition());
+	simulatedPosition.setMoves(candidates);
+	delete game;
+
+	RolloutPolicy policy((RolloutPolicy::Type)policyType);
+	policy.setSampledMoves(sampledMoves);
+	policy.setTemperature(temperature);
+	policy.setMaximumPlies(maximumPlies);
+
+	m_simulator.setPosition(simulatedPosition);
+	m_simulator.setIgnoreOppos(ignoreOppos);
+	m_simulator.setPartialOppoRack(Rack(partialOppoTiles));
+	m_simulator.setRolloutPolicy(policy);
+
+	m_candidates = candidates;
+	m_position = position;
+	m_plies = plies;
+	return true;
+}
+
+QString SimulationWorker::runJob(quint32 position, quint32 chunk, unsigned int firstSeed, int count)
+{
+	// each job's sums start from zero
+	m_simulator.resetNumbers();
+	m_simulator.simulateSeeds(m_plies, firstSeed, count);
+
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream.setVersion(streamVersion);
+
+	stream << position << chunk << (qint32)m_simulator.iterations() << (quint32)m_candidates.size();
+
+	for (MoveList::const_iterator it = m_candidates.begin(); it != m_candidates.end(); ++it)
+	{
+		const SimmedMove &simmedMove = m_simulator.simmedMoveForMove(*it);
+		writeAveragedValue(stream, simmedMove.residual);
+		writeAveragedValue(stream, simmedMove.gameSpread);
+		writeAveragedValue(stream, simmedMove.wins);
+
+		stream << (quint32)simmedMove.levels.size();
+		for (LevelList::const_iterator levelIt = simmedMove.levels.begin(); levelIt != simmedMove.levels.end(); ++levelIt)
+		{
+			stream << (quint32)(*levelIt).statistics.size();
+			for (PositionStatisticsList::const_iterator statisticsIt = (*levelIt).statistics.begin(); statisticsIt != (*levelIt).statistics.end(); ++statisticsIt)
+			{
+				writeAveragedValue(stream, (*statisticsIt).score);
+				writeAveragedValue(stream, (*statisticsIt).bingos);
+			}
+		}
+	}
+
+	return QString("result %1").arg(QString::fromLatin1(data.toBase64()));
+}
+
+////////////
+
+SimulationCoordinator::SimulationCoordinator()
+	: m_chunkSize(0), m_stragglerFactor(2), m_workerTimeout(0), m_firstSeed(0), m_position(0), m_simulator(0), m_plies(0), m_chunksDone(0), m_workerChunksDone(0), m_chunkMilliseconds(0), m_duplicatedChunks(0), m_lostWorkers(0), m_localChunks(0)
+{
+}
+
+SimulationCoordinator::~SimulationCoordinator()
+{
+	for (std::vector<Worker>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+		if ((*it).process)
+			sendLine(*it, "quit");
+
+	for (std::vector<Worker>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+	{
+		if (!(*it).process)
+			continue;
+
+		if (!(*it).process->waitForFinished(1000))
+		{
+			(*it).process->kill();
+			(*it).process->waitForFinished(1000);
+		}
+
+		delete (*it).process;
+	}
+}
+
+void SimulationCoordinator::addWorker(const QString &program, const QStringList &arguments)
+{
+	Worker worker;
+	worker.process = new QProcess;
+
+	// workers' complaints go where ours do
+	worker.process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+	worker.process->start(program, arguments);
+	worker.silence.start();
+
+	m_workers.push_back(worker);
+
+	if (!m_workers.back().process->waitForStarted())
+		loseWorker(m_workers.back(), QString("could not start %1").arg(program));
+}
+
+int SimulationCoordinator::workerCount() const
+{
+	int ret = 0;
+	for (std::vector<Worker>::const_iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+		if ((*it).process)
+			++ret;
+	return ret;
+}
+
+void SimulationCoordinator::setChunkSize(int iterations)
+{
+	m_chunkSize = iterations;
+}
+
+void SimulationCoordinator::setStragglerFactor(double factor)
+{
+	m_stragglerFactor = factor;
+}
+
+void SimulationCoordinator::setWorkerTimeout(int seconds)
+{
+	m_workerTimeout = seconds;
+}
+
+void SimulationCoordinator::setFirstSeed(unsigned int seed)
+{
+	m_firstSeed = seed;
+}
+
+int SimulationCoordinator::simulate(const Game &game, Simulator *simulator, int plies, int iterations)
+{
+	m_duplicatedChunks = 0;
+	m_lostWorkers = 0;
+	m_localChunks = 0;
+
+	const int startingIterations = simulator->iterations();
+	if (iterations <= 0)
+		return 0;
+
+	++m_position;
+	m_simulator = simulator;
+	m_plies = plies;
+
+	m_candidates.clear();
+	for (SimmedMoveList::const_iterator it = simulator->simmedMoves().begin(); it != simulator->simmedMoves().end(); ++it)
+		if ((*it).includeInSimulation())
+			m_candidates.push_back((*it).move);
+
+	m_positionMessage = positionMessage(game, *simulator, plies);
+
+	const unsigned int firstSeed = m_firstSeed + startingIterations;
+	const int chunksPerWorker = 4;
+	const int chunkSize = m_chunkSize > 0? m_chunkSize : std::max(1, iterations / (chunksPerWorker * std::max(1, workerCount())));
+
+	m_chunks.clear();
+	for (int start = 0; start < iterations; start += chunkSize)
+		m_chunks.push_back(Chunk(firstSeed + start, std::min(chunkSize, iterations - start)));
+
+	m_chunksDone = 0;
+	m_workerChunksDone = 0;
+	m_chunkMilliseconds = 0;
+
+	while (m_chunksDone < (int)m_chunks.size())
+	{
+		if (simulator->dispatch() && simulator->dispatch()->shouldAbort())
+			break;
+
+		int running = 0;
+		for (std::vector<Worker>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+		{
+			Worker &worker = *it;
+			if (!worker.process)
+				continue;
+
+			readWorker(worker);
+			if (!worker.process)
+				continue;
+
+			if (worker.process->state() == QProcess::NotRunning)
+			{
+				loseWorker(worker, "worker exited");
+				continue;
+			}
+
+			if (m_workerTimeout > 0 && (worker.chunk >= 0 || !worker.isReady) && worker.silence.elapsed() > m_workerTimeout * 1000)
+			{
+				loseWorker(worker, "worker timed out");
+				continue;
+			}
+
+			if (worker.isReady && worker.chunk < 0)
+				assignChunk(worker);
+
+			++running;
+		}
+
+		if (m_chunksDone == (int)m_chunks.size())
+			break;
+
+		if (running == 0)
+		{
+			// nobody left to run the rest
+			for (std::vector<Chunk>::iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+			{
+				if ((*it).isDone)
+					continue;
+
+				if (simulator->dispatch() && simulator->dispatch()->shouldAbort())
+					break;
+
+				simulator->simulateSeeds(plies, (*it).firstSeed, (*it).count);
+				(*it).isDone = true;
+				++m_chunksDone;
+				++m_localChunks;
+			}
+
+			break;
+		}
+
+		// wait a little for one of the workers to say something
+		const int pollMilliseconds = std::max(1, 20 / running);
+		for (std::vector<Worker>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+			if ((*it).process && (*it).process->waitForReadyRead(pollMilliseconds))
+				break;
+	}
+
+	m_simulator = 0;
+	return simulator->iterations() - startingIterations;
+}
+
+QByteArray SimulationCoordinator::positionMessage(const Game &game, const Simulator &simulator, int plies) const
+{
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream.setVersion(streamVersion);
+
+	const RolloutPolicy &policy = simulator.rolloutPolicy();
+
+	stream << m_position << QString::fromStdString(QUACKLE_LEXICON_PARAMETERS->lexiconName()) << (qint32)plies << simulator.ignoreOppos();
+	stream << (qint32)policy.type() << (qint32)policy.sampledMoves() << policy.temperature() << (qint32)policy.maximumPlies();
+	stream << lettersToBytes(simulator.partialOppoRack().tiles()) << QuackleIO::GameArchiveWriter::encode(game);
+
+	stream << (quint32)m_candidates.size();
+	for (MoveList::const_iterator it = m_candidates.begin(); it != m_candidates.end(); ++it)
+		writeMove(stream, *it);
+
+	return "position " + data.toBase64();
+}
+
+void SimulationCoordinator::readWorker(Worker &worker)
+{
+	while (worker.process && worker.process->canReadLine())
+		handleLine(worker, worker.process->readLine().trimmed());
+}
+
+void SimulationCoordinator::handleLine(Worker &worker, const QByteArray &line)
+{
+	worker.silence.start();
+
+	const int space = line.indexOf(' ');
+	const QByteArray request = space < 0? line : line.left(space);
+
+	if (request == "ready")
+		worker.isReady = true;
+	else if (request == "result")
+	{
+		if (worker.chunk >= 0 && worker.jobPosition == m_position)
+			--m_chunks[worker.chunk].copies;
+		worker.chunk = -1;
+
+		if (!incorporateResult(QByteArray::fromBase64(line.mid(space + 1))))
+			loseWorker(worker, "worker sent a bad result");
+	}
+	else if (request == "error")
+	{
+		// a worker that can't take our position is no use to us
+		loseWorker(worker, QString::fromUtf8(line.mid(space + 1)));
+	}
+
+	// anything else is the worker talking to itself
+}
+
+bool SimulationCoordinator::incorporateResult(const QByteArray &data)
+{
+	QDataStream stream(data);
+	stream.setVersion(streamVersion);
+
+	quint32 position;
+	quint32 chunk;
+	qint32 iterations;
+	quint32 candidateCount;
+	stream >> position >> chunk >> iterations >> candidateCount;
+
+	if (stream.status() != QDataStream::Ok)
+		return false;
+
+	// a straggler's copy of a chunk that is done already, or of an
+	// earlier simulation
+	if (position != m_position || chunk >= m_chunks.size() || m_chunks[chunk].isDone)
+		return true;
+
+	if (candidateCount != m_candidates.size())
+		return false;
+
+	SimmedMoveList results;
+	for (MoveList::const_iterator it = m_candidates.begin(); it != m_candidates.end(); ++it)
+	{
+		SimmedMove simmedMove(*it);
+		if (!readAveragedValue(stream, &simmedMove.residual) || !readAveragedValue(stream, &simmedMove.gameSpread) || !readAveragedValue(stream, &simmedMove.wins))
+			return false;
+
+		quint32 levelCount;
+		stream >> levelCount;
+		if (stream.status() != QDataStream::Ok || levelCount > maximumLevels)
+			return false;
+
+		simmedMove.setNumberLevels(levelCount);
+		for (LevelList::iterator levelIt = simmedMove.levels.begin(); levelIt != simmedMove.levels.end(); ++levelIt)
+		{
+			quint32 statisticsCount;
+			stream >> statisticsCount;
+			if (stream.status() != QDataStream::Ok || statisticsCount > maximumPlayers)
+				return false;
+
+			(*levelIt).setNumberScores(statisticsCount);
+			for (PositionStatisticsList::iterator statisticsIt = (*levelIt).statistics.begin(); statisticsIt != (*levelIt).statistics.end(); ++statisticsIt)
+				if (!readAveragedValue(stream, &(*statisticsIt).score) || !readAveragedValue(stream, &(*statisticsIt).bingos))
+					return false;
+		}
+
+		results.push_back(simmedMove);
+	}
+
+	m_simulator->incorporateResults(m_plies, results, iterations);
+
+	m_chunks[chunk].isDone = true;
+	++m_chunksDone;
+	++m_workerChunksDone;
+	m_chunkMilliseconds += (int)m_chunks[chunk].started.elapsed();
+	return true;
+}
+
+void SimulationCoordinator::assignChunk(Worker &worker)
+{
+	int chunk = -1;
+	for (int i = 0; i < (int)m_chunks.size() && chunk < 0; ++i)
+		if (!m_chunks[i].isDone && m_chunks[i].copies == 0)
+			chunk = i;
+
+	if (chunk < 0 && m_workerChunksDone > 0)
+	{
+		// Everything is handed out; back up the chunk that has been
+		// out longest, if it has been out much longer than chunks take.
+		const double averageMilliseconds = (double)m_chunkMilliseconds / m_workerChunksDone;
+		int longest = 0;
+
+		for (int i = 0; i < (int)m_chunks.size(); ++i)
+		{
+			if (m_chunks[i].isDone || m_chunks[i].copies != 1)
+				continue;
+
+			const int elapsed = (int)m_chunks[i].started.elapsed();
+			if (elapsed > m_stragglerFactor * averageMilliseconds && elapsed > longest)
+			{
+				chunk = i;
+				longest = elapsed;
+			}
+		}
+
+		if (chunk >= 0)
+			++m_duplicatedChunks;
+	}
+
+	if (chunk < 0)
+		return;
+
+	if (worker.position != m_position)
+	{
+		sendLine(worker, m_positionMessage);
+		worker.position = m_position;
+	}
+
+	Chunk &assigned = m_chunks[chunk];
+	if (assigned.copies == 0)
+		assigned.started.start();
+	++assigned.copies;
+
+	worker.chunk = chunk;
+	worker.jobPosition = m_position;
+	worker.silence.start();
+
+	sendLine(worker, QString("job %1 %2 %3 %4").arg(m_position).arg(chunk).arg(assigned.firstSeed).arg(assigned.count).toLatin1());
+}
+
+void SimulationCoordinator::loseWorker(Worker &worker, const QString &reason)
+{
+	UVcerr << "Lost simulation worker: " << QuackleIO::Util::qstringToString(reason) << endl;
+
+	if (worker.chunk >= 0 && worker.jobPosition == m_position && m_simulator)
+		--m_chunks[worker.chunk].copies;
+	worker.chunk = -1;
+
+	worker.process->kill();
+	worker.process->waitForFinished(1000);
+	delete worker.process;
+	worker.process = 0;
+
+	++m_lostWorkers;
+}
+
+void SimulationCoordinator::sendLine(Worker &worker, const QByteArray &line)
+{
+	worker.process->write(line + "\n");
+
+	// the rest goes out while we wait for workers to answer
+	worker.process->waitForBytesWritten(1000);
+}
@@ -0,0 +1,217 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_SIMULATIONCOORDINATOR_H
+#define QUACKLE_SIMULATIONCOORDINATOR_H
+
+#include <vector>
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include <game.h>
+#include <sim.h>
+
+class QProcess;
+class QTextStream;
+
+// A simulation can be spread over worker processes, each of which
+// runs some of the iterations and sends back the sums of what it saw.
+// Iterations are seeded one by one (see Simulator::simulateSeeds), so
+// the sums add up to the same simulation however the seeds are split,
+// and a range of seeds lost with a worker can be run again by another.
+//
+// Coordinator and worker talk over the worker's standard input and
+// output, one message per line:
+//
+//   ready                     worker is loaded and waiting
+//   position DATA             coordinator: the position to simulate
+//   job ID CHUNK SEED COUNT   coordinator: simulate COUNT iterations of
+//                             position ID from seed SEED on
+//   result DATA               worker: the sums of a job
+//   error MESSAGE             worker: a request it could not carry out
+//   quit
+//
+// DATA is base64 of a QDataStream. A position carries its game as a
+// game archive record, the candidates, plies, rollout policy and the
+// lexicon name, which the worker checks against its own; a result
+// carries the sums of each candidate in the order the position listed
+// them. Anything else a worker prints is ignored.
+
+namespace QuackleIO
+{
+
+// Answers coordinator requests, usually on standard input and output.
+class SimulationWorker
+{
+public:
+	SimulationWorker();
+
+	// serve requests from in, answering on out, until quit or end of input
+	void serve(QTextStream &in, QTextStream &out);
+
+	// Handle one line of input. Returns the response lines.
+	QStringList handleLine(const QString &line);
+
+	bool isDone() const { return m_done; }
+
+private:
+	bool setPosition(const QByteArray &data, QString *error);
+	QString runJob(quint32 position, quint32 chunk, unsigned int firstSeed, int count);
+
+	Quackle::Simulator m_simulator;
+	Quackle::MoveList m_candidates;
+	quint32 m_position;
+	int m_plies;
+	bool m_done;
+};
+
+// Runs simulations on worker processes, started by commands that speak
+// the protocol above -- for local workers, the test harness in
+// simworker mode; for workers on other hosts, something like ssh
+// running the same there. Any program linking quackleio can be a
+// coordinator, or a worker by calling SimulationWorker::serve.
+class SimulationCoordinator
+{
+public:
+	SimulationCoordinator();
+
+	// tells the workers to quit and waits a moment for them to
+	~SimulationCoordinator();
+
+	// Starts a worker running program with arguments. Workers that
+	// can't be started are counted as lost straight away.
+	void addWorker(const QString &program, const QStringList &arguments);
+
+	// workers still running
+	int workerCount() const;
+
+	// Iterations are handed out in chunks of this many. Zero, the
+	// default, makes about four chunks per worker.
+	void setChunkSize(int iterations);
+
+	// A chunk still out after this many times the time chunks have
+	// taken so far is handed to an idle worker as well, and whichever
+	// copy finishes first counts. Default 2.
+	void setStragglerFactor(double factor);
+
+	// A worker that has sent nothing for this many seconds while it
+	// has a job, or is starting up, is killed and its job handed out
+	// again. Zero, the default, waits as long as it takes.
+	void setWorkerTimeout(int seconds);
+
+	// Seeds of a position start here and carry on from the iterations
+	// the simulator already has, so repeating a simulation runs the
+	// same iterations however many workers there are. Default 0.
+	void setFirstSeed(unsigned int seed);
+
+	// Runs iterations more iterations of plies plies of the candidates
+	// simulator includes and adds them to its results. The simulated
+	// position is the last of game, which must be the position of the
+	// simulator. Chunks that no worker is left to run are run here.
+	// Returns the number of iterations added, which is less than asked
+	// for only if the simulator's dispatch aborted.
+	int simulate(const Quackle::Game &game, Quackle::Simulator *simulator, int plies, int iterations);
+
+	// the last simulate()'s count of chunks run twice, workers lost,
+	// and chunks run here
+	int duplicatedChunks() const { return m_duplicatedChunks; }
+	int lostWorkers() const { return m_lostWorkers; }
+	int localChunks() const { return m_localChunks; }
+
+private:
+	struct Worker
+	{
+		Worker() : process(0), isReady(false), position(0), chunk(-1), jobPosition(0) {}
+
+		QProcess *process;
+		bool isReady;
+
+		// position the worker has been sent, zero for none
+		quint32 position;
+
+		// chunk it is running, or -1, and the position that is of;
+		// a straggler may still be on a chunk of an earlier simulation
+		int chunk;
+		quint32 jobPosition;
+
+		// since the job was sent or the worker was last heard from
+		QElapsedTimer silence;
+	};
+
+	struct Chunk
+	{
+		Chunk(unsigned int _firstSeed, int _count) : firstSeed(_firstSeed), count(_count), copies(0), isDone(false) {}
+
+		unsigned int firstSeed;
+		int count;
+
+		// workers running the chunk
+		int copies;
+		bool isDone;
+
+		// since the first copy was handed out
+		QElapsedTimer started;
+	};
+
+	// encodes the position message for the simulation under way
+	QByteArray positionMessage(const Quackle::Game &game, const Quackle::Simulator &simulator, int plies) const;
+
+	// handles the lines the worker has sent
+	void readWorker(Worker &worker);
+	void handleLine(Worker &worker, const QByteArray &line);
+
+	// Merges a result into the simulator, unless its chunk is done
+	// already. Returns false if the result can't be decoded.
+	bool incorporateResult(const QByteArray &data);
+
+	// hands the worker a chunk that needs running, if there is one
+	void assignChunk(Worker &worker);
+
+	void loseWorker(Worker &worker, const QString &reason);
+	void sendLine(Worker &worker, const QByteArray &line);
+
+	std::vector<Worker> m_workers;
+
+	int m_chunkSize;
+	double m_stragglerFactor;
+	int m_workerTimeout;
+	unsigned int m_firstSeed;
+
+	// the simulation under way
+	quint32 m_position;
+	QByteArray m_positionMessage;
+	Quackle::Simulator *m_simulator;
+	Quackle::MoveList m_candidates;
+	int m_plies;
+	std::vector<Chunk> m_chunks;
+	int m_chunksDone;
+
+	// chunks workers have done and the milliseconds they took
+	int m_workerChunksDone;
+	int m_chunkMilliseconds;
+
+	int m_duplicatedChunks;
+	int m_lostWorkers;
+	int m_localChunks;
+};
+
+}
+
+#endif
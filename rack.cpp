@@ -17,6 +17,7 @@
  */
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 
 #include "datamanager.h"
@@ -34,44 +35,50 @@ LetterString Rack::alphaTiles() const
 
 bool Rack::equals(const Rack &rack) const
 {
-	return alphaTiles() == rack.alphaTiles();
+	return memcmp(m_counts, rack.m_counts, sizeof(m_counts)) == 0;
 }
 
 bool Rack::unload(const LetterString &used)
 {
 	// UVcout << *this << ".unload(" << used << ")" << endl;
 
-	LetterString newtiles = m_tiles;
+	char unloaded[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
+	memset(unloaded, 0, sizeof(unloaded));
+
 	bool ret = true;
+	bool any = false;
 
 	LetterString::const_iterator usedEnd(used.end());
 	for (LetterString::const_iterator usedIt = used.begin(); usedIt != usedEnd; ++usedIt)
 	{
-		bool found = false;
-
-		LetterString::iterator newEnd(newtiles.end());
-		for (LetterString::iterator newIt = newtiles.begin(); newIt != newEnd; ++newIt)
+		if (unloaded[(int)*usedIt] < m_counts[(int)*usedIt])
 		{
-			if (*newIt == *usedIt)
-			{
-				*newIt = QUACKLE_NULL_MARK;
-				found = true;
-				break;
-			}
+			++unloaded[(int)*usedIt];
+			any = true;
 		}
-
-		if (!found)
+		else
 			ret = false;
 	}
 
-	// UVcout << "newtiles: " << newtiles << endl;
+	if (!any)
+		return ret;
 
-	m_tiles.clear();
+	// the first of each letter on the rack go
+	LetterString newtiles;
+
+	LetterString::const_iterator end(m_tiles.end());
+	for (LetterString::const_iterator it = m_tiles.begin(); it != end; ++it)
+	{
+		if (unloaded[(int)*it] > 0)
+		{
+			--unloaded[(int)*it];
+			--m_counts[(int)*it];
+		}
+		else
+			newtiles += *it;
+	}
 
-	LetterString::const_iterator newEnd(newtiles.end());
-	for (LetterString::const_iterator newIt = newtiles.begin(); newIt != newEnd; ++newIt)
-		if (*newIt != QUACKLE_NULL_MARK)
-			m_tiles += *newIt; 
+	m_tiles = newtiles;
 
 	return ret;
 }
@@ -80,19 +87,32 @@ void Rack::load(const LetterString &tiles)
 {
 	for (LetterString::const_iterator it = tiles.begin(); it != tiles.end(); ++it)
 	{
-		if (it != QUACKLE_NULL_MARK)
+		if (*it != QUACKLE_NULL_MARK)
+		{
 			m_tiles += *it;
+			++m_counts[(int)*it];
+		}
 	}
 }
 
 bool Rack::contains(const LetterString &used) const
 {
-	return Rack(*this).unload(used);
+	char remaining[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
+	memcpy(remaining, m_counts, sizeof(remaining));
+
+	LetterString::const_iterator usedEnd(used.end());
+	for (LetterString::const_iterator usedIt = used.begin(); usedIt != usedEnd; ++usedIt)
+		if (--remaining[(int)*usedIt] < 0)
+			return false;
+
+	return true;
 }
 
 void Rack::shuffle()
 {
-	random_shuffle(m_tiles.begin(), m_tiles.end());
+	LetterString::iterator tiles = m_tiles.begin();
+	for (int i = m_tiles.length() - 1; i > 0; --i)
+		swap(tiles[i], tiles[DataManager::self()->randomNumber() % (i + 1)]);
 }
 
 int Rack::score() const
@@ -106,11 +126,6 @@ int Rack::score() const
 	return ret;
 }
 
-unsigned int Rack::size() const
-{
-	return m_tiles.size();
-}
-
 const Rack operator-(const Rack &rack, const Move &move)
 {
 	Rack ret(rack);
@@ -19,6 +19,8 @@
 #ifndef QUACKLE_RACK_H
 #define QUACKLE_RACK_H
 
+#include <cstring>
+
 #include "alphabetparameters.h"
 
 using namespace std;
@@ -28,6 +30,10 @@ namespace Quackle
 
 class Move;
 
+// The tiles of a rack, in the order they're on the rack, along with
+// how many of each letter there are, so that what a rack contains can
+// be found without going through its tiles. Tiles are blanks and plain
+// letters.
 class Rack
 {
 public:
@@ -67,15 +73,20 @@ public:
 	// sum of scores of letters on rack
 	int score() const;
 
+	// how many of letter are on rack
+	int count(Letter letter) const;
+
 	UVString xml() const;
 	UVString toString() const;
 
 private:
 	LetterString m_tiles;
+	char m_counts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
 };
 
 inline Rack::Rack()
 {
+	memset(m_counts, 0, sizeof(m_counts));
 }
 
 inline Rack::Rack(const LetterString &tiles)
@@ -86,6 +97,7 @@ inline Rack::Rack(const LetterString &tiles)
 inline void Rack::setTiles(const LetterString &tiles)
 {
 	m_tiles = tiles;
+	String::counts(m_tiles, m_counts);
 }
 
 inline const LetterString &Rack::tiles() const
@@ -98,6 +110,16 @@ inline bool Rack::empty() const
 	return m_tiles.empty();
 }
 
+inline unsigned int Rack::size() const
+{
+	return m_tiles.size();
+}
+
+inline int Rack::count(Letter letter) const
+{
+	return m_counts[(int)letter];
+}
+
 }
 
 const Quackle::Rack operator-(const Quackle::Rack &rack, const Quackle::Move &move);
@@ -0,0 +1,89 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <cstdlib>
+
+#include "datamanager.h"
+#include "game.h"
+#include "rolloutpolicy.h"
+
+using namespace Quackle;
+
+RolloutPolicy::RolloutPolicy(Type type)
+	: m_type(type), m_sampledMoves(4), m_temperature(5), m_maximumPlies(-1)
+{
+}
+
+int RolloutPolicy::plies(int plies) const
+{
+	if (m_maximumPlies >= 0 && (plies < 0 || plies > m_maximumPlies))
+		return m_maximumPlies;
+
+	return plies;
+}
+
+bool RolloutPolicy::operator==(const RolloutPolicy &other) const
+{
+	return m_type == other.m_type && m_sampledMoves == other.m_sampledMoves && m_temperature == other.m_temperature && m_maximumPlies == other.m_maximumPlies;
+}
+
+Move RolloutPolicy::move(GamePosition &position, const GenerationContext *context) const
+{
+	switch (m_type)
+	{
+	case ScoreGreedy:
+		return position.highestScoringMove(context);
+
+	case TopSampled:
+		return sampledMove(position, context);
+
+	case StaticBest:
+	default:
+		return position.staticBestMove(context);
+	}
+}
+
+Move RolloutPolicy::sampledMove(GamePosition &position, const GenerationContext *context) const
+{
+	if (m_sampledMoves <= 1 || m_temperature <= 0)
+		return position.staticBestMove(context);
+
+	position.kibitz(m_sampledMoves, context);
+
+	const MoveList &moves = position.moves();
+	if (moves.size() <= 1)
+		return moves.front();
+
+	const double bestEquity = moves.front().equity;
+
+	double total = 0;
+	for (MoveList::const_iterator it = moves.begin(); it != moves.end(); ++it)
+		total += exp(((*it).equity - bestEquity) / m_temperature);
+
+	double choice = total * DataManager::self()->randomNumber() / (RAND_MAX + 1.0);
+
+	for (MoveList::const_iterator it = moves.begin(); it != moves.end(); ++it)
+	{
+		choice -= exp(((*it).equity - bestEquity) / m_temperature);
+		if (choice < 0)
+			return *it;
+	}
+
+	return moves.back();
+}
@@ -0,0 +1,142 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_ROLLOUTPOLICY_H
+#define QUACKLE_ROLLOUTPOLICY_H
+
+#include "move.h"
+
+namespace Quackle
+{
+
+class GamePosition;
+class GenerationContext;
+
+// How a simulation plays the plies after the candidate. Static best
+// moves are the strongest replies, but each costs generating and
+// valuing every move; the other policies are cheaper, so that a
+// simulation can look further ahead in the same time.
+//
+// Any policy can be truncated: a simulation then plays no more than
+// maximumPlies() plies after the candidate, however many it is asked
+// for, and values the racks left with the evaluator as it does at the
+// end of any simulation.
+class RolloutPolicy
+{
+public:
+	enum Type
+	{
+		// the static best move
+		StaticBest,
+
+		// the highest scoring move, with no leaves valued
+		ScoreGreedy,
+
+		// one of the best sampledMoves() moves by static equity,
+		// chosen less often the further its equity is below the best
+		TopSampled
+	};
+
+	// static best moves, not truncated
+	RolloutPolicy(Type type = StaticBest);
+
+	Type type() const;
+	void setType(Type type);
+
+	// moves TopSampled chooses from; 4 by default
+	int sampledMoves() const;
+	void setSampledMoves(int moves);
+
+	// Points of equity below the best at which TopSampled chooses
+	// a move 1/e times as often as the best; 5 by default.
+	double temperature() const;
+	void setTemperature(double temperature);
+
+	// negative, the default, means not truncated
+	int maximumPlies() const;
+	void setMaximumPlies(int plies);
+
+	// Plies to play after the candidate when asked for plies;
+	// negative plies means to the end of the game.
+	int plies(int plies) const;
+
+	// The move for the player to move on position to play. Replaces
+	// the moves of position. If context is given, it must have been
+	// prepared from the board of position.
+	Move move(GamePosition &position, const GenerationContext *context = 0) const;
+
+	bool operator==(const RolloutPolicy &other) const;
+	bool operator!=(const RolloutPolicy &other) const;
+
+private:
+	Move sampledMove(GamePosition &position, const GenerationContext *context) const;
+
+	Type m_type;
+	int m_sampledMoves;
+	double m_temperature;
+	int m_maximumPlies;
+};
+
+inline RolloutPolicy::Type RolloutPolicy::type() const
+{
+	return m_type;
+}
+
+inline void RolloutPolicy::setType(Type type)
+{
+	m_type = type;
+}
+
+inline int RolloutPolicy::sampledMoves() const
+{
+	return m_sampledMoves;
+}
+
+inline void RolloutPolicy::setSampledMoves(int moves)
+{
+	m_sampledMoves = moves;
+}
+
+inline double RolloutPolicy::temperature() const
+{
+	return m_temperature;
+}
+
+inline void RolloutPolicy::setTemperature(double temperature)
+{
+	m_temperature = temperature;
+}
+
+inline int RolloutPolicy::maximumPlies() const
+{
+	return m_maximumPlies;
+}
+
+inline void RolloutPolicy::setMaximumPlies(int plies)
+{
+	m_maximumPlies = plies;
+}
+
+inline bool RolloutPolicy::operator!=(const RolloutPolicy &other) const
+{
+	return !(*this == other);
+}
+
+}
+
+#endif
@@ -16,6 +16,7 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <iostream>
 #include <math.h>
 
@@ -25,7 +26,9 @@
 #include "gameparameters.h"
 #include "move.h"
 #include "sim.h"
+#include "simulationcache.h"
 #include "strategyparameters.h"
+#include "trainingexporter.h"
 
 // define this to get lame debugging messages
 //#define DEBUG_SIM
@@ -33,13 +36,15 @@
 using namespace Quackle;
 
 Simulator::Simulator()
-	: m_logfileIsOpen(false), m_hasHeader(false), m_dispatch(0), m_iterations(0), m_ignoreOppos(false)
+	: m_cache(0), m_isAttachedToCache(false), m_cachePosition(0), m_cachePlies(0), m_trainingExporter(0), m_resultsExported(true), m_hasHeader(false), m_dispatch(0), m_iterations(0), m_ignoreOppos(false)
 {
 	m_originalGame.addPosition();
 }
 
 Simulator::~Simulator()
 {
+	storeInCache();
+	exportResults();
 	closeLogfile();
 }
 
@@ -48,6 +53,10 @@ void Simulator::setPosition(const GamePosition &position)
 	if (hasSimulationResults())
 		writeLogFooter();
 
+	storeInCache();
+	exportResults();
+	m_isAttachedToCache = false;
+
 	m_originalGame.setCurrentPosition(position);
 
 	m_consideredMoves.clear();
@@ -73,20 +82,13 @@ void Simulator::setLogfile(const string &logfile, bool append)
 		return;
 	}
 
-	const ios::openmode flags = append? (ios::out | ios::app) : ios::out;
-	m_logfileStream.open(m_logfile.c_str(), flags);
-
-	m_logfileIsOpen = m_logfileStream.is_open();
-	if (!m_logfileIsOpen)
-		cerr << "Could not open " << m_logfile << " to write simulation log" << endl;
-
+	m_log.open(m_logfile, append);
 	m_hasHeader = false;
 }
 
 void Simulator::logMessage(const UVString &message)
 {
-	if (isLogging())
-		m_logfileStream << message << endl;
+	m_log.message(message);
 }
 
 void Simulator::closeLogfile()
@@ -96,8 +98,7 @@ void Simulator::closeLogfile()
 		if (m_hasHeader)
 			writeLogFooter();
 
-		m_logfileStream.close();
-		m_logfileIsOpen = false;
+		m_log.close();
 	}
 }
 
@@ -105,8 +106,7 @@ void Simulator::writeLogHeader()
 {
 	if (isLogging())
 	{
-		m_logfileStream << "<simulation>" << endl;
-		m_xmlIndent = MARK_UV("\t");
+		m_log.beginSimulation();
 
 		m_hasHeader = true;
 
@@ -118,8 +118,7 @@ void Simulator::writeLogFooter()
 {
 	if (isLogging())
 	{
-		m_xmlIndent = MARK_UV("");
-		m_logfileStream << "</simulation>" << endl;
+		m_log.endSimulation();
 
 		m_hasHeader = false;
 	}
@@ -130,6 +129,113 @@ void Simulator::setDispatch(ComputerDispatch *dispatch)
 	m_dispatch = dispatch;
 }
 
+void Simulator::setCache(SimulationCache *cache)
+{
+	storeInCache();
+	m_cache = cache;
+
+	// numbers we have now are kept and stored under the position
+	// they're for the next time it's simulated
+	m_isAttachedToCache = false;
+}
+
+void Simulator::storeInCache()
+{
+	if (!m_cache || !m_isAttachedToCache)
+		return;
+
+	const SimmedMoveList::const_iterator end = m_simmedMoves.end();
+	for (SimmedMoveList::const_iterator it = m_simmedMoves.begin(); it != end; ++it)
+		if ((*it).gameSpread.hasValues())
+			m_cache->store(m_cachePosition, m_cachePlies, *it);
+}
+
+void Simulator::reloadFromCache()
+{
+	if (!m_cache || !m_isAttachedToCache)
+		return;
+
+	m_iterations = 0;
+
+	const SimmedMoveList::iterator end = m_simmedMoves.end();
+	for (SimmedMoveList::iterator it = m_simmedMoves.begin(); it != end; ++it)
+	{
+		(*it).clear();
+		restoreFromCache(*it);
+	}
+}
+
+void Simulator::setRolloutPolicy(const RolloutPolicy &policy)
+{
+	if (policy == m_rolloutPolicy)
+		return;
+
+	storeInCache();
+
+	// the policy is part of the cache's key, so what is cached
+	// under the old one stays; it's attached to anew when simulating
+	m_isAttachedToCache = false;
+	resetNumbers();
+
+	m_rolloutPolicy = policy;
+}
+
+void Simulator::setTrainingExporter(TrainingExporter *exporter)
+{
+	exportResults();
+	m_trainingExporter = exporter;
+}
+
+void Simulator::exportResults()
+{
+	if (!m_trainingExporter || m_resultsExported)
+		return;
+
+	m_trainingExporter->exportSimulation(*this);
+	m_resultsExported = true;
+}
+
+void Simulator::attachToCache(int plies)
+{
+	if (plies < 0)
+		plies = -1;
+
+	if (m_isAttachedToCache && m_cachePlies == plies)
+		return;
+
+	storeInCache();
+
+	const bool keepNumbers = !m_isAttachedToCache;
+
+	m_cachePosition = SimulationCache::positionHash(m_originalGame.currentPosition(), m_partialOppoRack, m_ignoreOppos, m_rolloutPolicy);
+	m_cachePlies = plies;
+	m_isAttachedToCache = true;
+
+	// numbers run before there was a cache to attach to are adopted
+	if (keepNumbers && hasSimulationResults())
+		return;
+
+	const SimmedMoveList::iterator end = m_simmedMoves.end();
+	for (SimmedMoveList::iterator it = m_simmedMoves.begin(); it != end; ++it)
+	{
+		(*it).clear();
+		restoreFromCache(*it);
+	}
+
+	m_iterations = 0;
+	for (SimmedMoveList::iterator it = m_simmedMoves.begin(); it != end; ++it)
+		m_iterations = max(m_iterations, (int)(*it).gameSpread.incorporatedValues());
+}
+
+void Simulator::restoreFromCache(SimmedMove &move)
+{
+	if (!m_cache || !m_isAttachedToCache)
+		return;
+
+	if (m_cache->restore(m_cachePosition, m_cachePlies, move))
+		m_iterations = max(m_iterations, (int)move.gameSpread.incorporatedValues());
+}
+
 void Simulator::setIncludedMoves(const MoveList &moves)
 {
 	for (SimmedMoveList::iterator simmedMoveIt = m_simmedMoves.begin(); simmedMoveIt != m_simmedMoves.end(); ++simmedMoveIt)
@@ -150,7 +256,10 @@ void Simulator::setIncludedMoves(const MoveList &moves)
 
 		// move wasn't found; add it
 		if (simmedMoveIt == m_simmedMoves.end())
+		{
 			m_simmedMoves.push_back(SimmedMove(*it));
+			restoreFromCache(m_simmedMoves.back());
+		}
 	}
 }
 
@@ -208,6 +317,11 @@ void Simulator::pruneTo(double equityThreshold, int maxNumberOfMoves)
 
 void Simulator::resetNumbers()
 {
+	exportResults();
+
+	if (m_cache && m_isAttachedToCache)
+		m_cache->forget(m_cachePosition);
+
 	SimmedMoveList::iterator end = m_simmedMoves.end();
 	for (SimmedMoveList::iterator moveIt = m_simmedMoves.begin(); moveIt != end; ++moveIt)
 		(*moveIt).clear();
@@ -225,13 +339,77 @@ void Simulator::simulate(int plies, int iterations)
 	}
 }
 
+void Simulator::simulateSeeds(int plies, unsigned int firstSeed, int numberOfSeeds)
+{
+	for (int i = 0; i < numberOfSeeds; ++i)
+	{
+		if (m_dispatch && m_dispatch->shouldAbort())
+			break;
+		canonicalizeUnseenTiles();
+		QUACKLE_DATAMANAGER->seedRandomNumbers(firstSeed + i);
+		simulate(plies);
+	}
+}
+
+void Simulator::canonicalizeUnseenTiles()
+{
+	GamePosition &position = m_originalGame.currentPosition();
+
+	char counts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
+	position.unseenBag().letterCounts(counts);
+
+	LongLetterString tiles;
+	for (Letter letter = 0; letter <= QUACKLE_ALPHABET_PARAMETERS->lastLetter(); ++letter)
+		tiles.append(counts[(int)letter], letter);
+
+	const PlayerList::const_iterator end = position.players().end();
+	for (PlayerList::const_iterator it = position.players().begin(); it != end; ++it)
+		if (!((*it) == position.currentPlayer()))
+			position.setPlayerRack((*it).id(), Rack(), /* adjust bag */ false);
+
+	Bag bag;
+	bag.clear();
+	bag.toss(tiles);
+	position.setBag(bag);
+
+	position.setCurrentPlayerRack(Rack(String::alphabetize(position.currentPlayer().rack().tiles())), /* adjust bag */ false);
+}
+
+void Simulator::incorporateResults(int plies, const SimmedMoveList &moves, int iterations)
+{
+	if (m_cache)
+		attachToCache(m_rolloutPolicy.plies(plies));
+
+	for (SimmedMoveList::const_iterator it = moves.begin(); it != moves.end(); ++it)
+	{
+		const SimmedMoveList::iterator end = m_simmedMoves.end();
+		for (SimmedMoveList::iterator moveIt = m_simmedMoves.begin(); moveIt != end; ++moveIt)
+		{
+			if ((*moveIt).move == (*it).move)
+			{
+				(*moveIt).incorporateResults(*it);
+				break;
+			}
+		}
+	}
+
+	m_iterations += iterations;
+	m_resultsExported = false;
+}
+
 void Simulator::simulate(int plies)
 {
 #ifdef DEBUG_SIM
 	UVcout << "let's simulate for " << plies << " plies" << endl;
 #endif
 
+	plies = m_rolloutPolicy.plies(plies);
+
+	if (m_cache)
+		attachToCache(plies);
+
 	++m_iterations;
+	m_resultsExported = false;
 
 	randomizeOppoRacks();
 	randomizeDrawingOrder();
@@ -256,8 +434,7 @@ void Simulator::simulate(int plies)
 		if (!m_hasHeader)
 			writeLogHeader();
 
-		m_logfileStream << m_xmlIndent << "<iteration index=\"" << m_iterations << "\">" << endl;
-		m_xmlIndent += MARK_UV('\t');
+		m_log.beginIteration(m_iterations);
 	}
 
 	SimmedMoveList::iterator moveEnd = m_simmedMoves.end();
@@ -272,8 +449,7 @@ void Simulator::simulate(int plies)
 
 		if (isLogging())
 		{
-			m_logfileStream << m_xmlIndent << "<playahead>" << endl;
-			m_xmlIndent += MARK_UV('\t');
+			m_log.beginPlayahead();
 		}
 
 		m_simulatedGame = m_originalGame;
@@ -294,21 +470,24 @@ void Simulator::simulate(int plies)
 			for (PositionStatisticsList::iterator scoresIt = (*levelIt).statistics.begin(); scoresIt != (*levelIt).statistics.end() && !m_simulatedGame.currentPosition().gameOver(); ++scoresIt, ++playerNumber)
 			{
 				const int playerId = m_simulatedGame.currentPosition().currentPlayer().id();
+				const bool isCandidate = playerId == startPlayerId && levelNumber == 1;
+				const bool isReply = levelNumber == 1 && playerNumber == 2;
 
 				if (isLogging())
 				{
-					m_logfileStream << m_xmlIndent << "<ply index=\"" << (levelNumber - 1) * numberOfPlayers + playerNumber - 1 << "\">" << endl;
-					m_xmlIndent += MARK_UV('\t');
+					m_log.beginPly((levelNumber - 1) * numberOfPlayers + playerNumber - 1);
 				}
 
 				Move move = Move::createNonmove();
 
-				if (playerId == startPlayerId && levelNumber == 1)
+				if (isCandidate)
 					move = (*moveIt).move;
 				else if (m_ignoreOppos && playerId != startPlayerId)
 					move = Move::createPassMove();
+				else if (isReply && (*moveIt).replyContext.isPrepared())
+					move = m_rolloutPolicy.move(m_simulatedGame.currentPosition(), &(*moveIt).replyContext);
 				else
-					move = m_simulatedGame.currentPosition().staticBestMove();
+					move = m_rolloutPolicy.move(m_simulatedGame.currentPosition());
 
 				int deadwoodScore = 0;
 				if (m_simulatedGame.currentPosition().doesMoveEndGame(move))
@@ -325,8 +504,8 @@ void Simulator::simulate(int plies)
 
 				if (isLogging())
 				{
-					m_logfileStream << m_xmlIndent << m_simulatedGame.currentPosition().currentPlayer().rack().xml() << endl;
-					m_logfileStream << m_xmlIndent << move.xml() << endl;
+					m_log.rack(m_simulatedGame.currentPosition().currentPlayer().rack());
+					m_log.move(move);
 				}
 
 				// record future-looking residuals
@@ -343,7 +522,7 @@ void Simulator::simulate(int plies)
 				{
 					double residualAddend = m_simulatedGame.currentPosition().calculatePlayerConsideration(move);
 					if (isLogging())
-						m_logfileStream << m_xmlIndent << "<pc value=\"" << residualAddend << "\" />" << endl;
+						m_log.playerConsideration(residualAddend);
 
 					if (isVeryFinalTurnOfSimulation)
 					{
@@ -354,7 +533,7 @@ void Simulator::simulate(int plies)
 						residualAddend += sharedResidual;
 
 						if (isLogging() && sharedResidual != 0)
-							m_logfileStream << m_xmlIndent << "<sc value=\"" << sharedResidual << "\" />" << endl;
+							m_log.sharedConsideration(sharedResidual);
 					}
 
 					if (playerId == startPlayerId)
@@ -368,12 +547,23 @@ void Simulator::simulate(int plies)
 				move.score -= deadwoodScore; 
 				m_simulatedGame.setCandidate(move);
 
-				m_simulatedGame.commitCandidate(!isVeryFinalTurnOfSimulation);
+				if (isCandidate && (*moveIt).replyContext.isPrepared())
+				{
+					// no need to work out the board's crosses again
+					m_simulatedGame.commitCandidate(false);
+					m_simulatedGame.currentPosition().setBoard((*moveIt).replyContext.board());
+				}
+				else
+				{
+					m_simulatedGame.commitCandidate(!isVeryFinalTurnOfSimulation);
+
+					if (isCandidate && !isVeryFinalTurnOfSimulation)
+						(*moveIt).replyContext.prepare(m_simulatedGame.currentPosition().board());
+				}
 
 				if (isLogging())
 				{
-					m_xmlIndent = m_xmlIndent.substr(0, m_xmlIndent.length() - 1);
-					m_logfileStream << m_xmlIndent << "</ply>" << endl;
+					m_log.endPly();
 				}
 			}
 		}
@@ -390,7 +580,7 @@ void Simulator::simulate(int plies)
 
 			if (isLogging())
 			{
-				m_logfileStream << m_xmlIndent << "<gameover win=\"" << wins << "\" />" << endl;
+				m_log.gameOver(wins);
 			}
 		}
 		else
@@ -404,15 +594,14 @@ void Simulator::simulate(int plies)
 
 		if (isLogging())
 		{
-			m_xmlIndent = m_xmlIndent.substr(0, m_xmlIndent.length() - 1);
-			m_logfileStream << m_xmlIndent << "</playahead>" << endl;
+			m_log.endPlayahead();
 		}
 	}
 
 	if (isLogging())
 	{
-		m_xmlIndent = m_xmlIndent.substr(0, m_xmlIndent.length() - 1);
-		m_logfileStream << m_xmlIndent << "</iteration>" << endl;
+		// hands the iteration to the log's writer, which flushes it
+		m_log.endIteration();
 	}
 }
 
@@ -574,6 +763,30 @@ void SimmedMove::setNumberLevels(unsigned int number)
 void SimmedMove::clear()
 {
 	levels.clear();
+	residual.clear();
+	gameSpread.clear();
+	wins.clear();
+}
+
+void SimmedMove::incorporateResults(const SimmedMove &other)
+{
+	setNumberLevels(other.levels.size());
+
+	for (unsigned int i = 0; i < other.levels.size(); ++i)
+	{
+		const PositionStatisticsList &statistics = other.levels[i].statistics;
+		levels[i].setNumberScores(statistics.size());
+
+		for (unsigned int j = 0; j < statistics.size(); ++j)
+		{
+			levels[i].statistics[j].score.incorporateValues(statistics[j].score);
+			levels[i].statistics[j].bingos.incorporateValues(statistics[j].bingos);
+		}
+	}
+
+	residual.incorporateValues(other.residual);
+	gameSpread.incorporateValues(other.gameSpread);
+	wins.incorporateValues(other.wins);
 }
 
 PositionStatistics SimmedMove::getPositionStatistics(int level, int playerIndex) const
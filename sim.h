@@ -19,15 +19,21 @@
 #ifndef QUACKLE_SIM_H
 #define QUACKLE_SIM_H
 
+#include <stdint.h>
 #include <vector>
 
 #include "alphabetparameters.h"
 #include "game.h"
+#include "generationcontext.h"
+#include "rolloutpolicy.h"
+#include "simulationlog.h"
 
 namespace Quackle
 {
 
 class ComputerDispatch;
+class SimulationCache;
+class TrainingExporter;
 
 struct AveragedValue
 {
@@ -37,8 +43,17 @@ struct AveragedValue
     {
     }
 
+    // value with sums already accumulated elsewhere
+    AveragedValue(long double valueSum, long double squaredValueSum, long int incorporatedValues)
+        : m_valueSum(valueSum), m_squaredValueSum(squaredValueSum), m_incorporatedValues(incorporatedValues)
+    {
+    }
+
     void incorporateValue(double newValue);
 
+    // add the sums of other, as if its values had been incorporated here
+    void incorporateValues(const AveragedValue &other);
+
     // zero everything
     void clear();
 
@@ -69,6 +84,13 @@ inline void AveragedValue::incorporateValue(double newValue)
     ++m_incorporatedValues;
 }
 
+inline void AveragedValue::incorporateValues(const AveragedValue &other)
+{
+    m_valueSum += other.m_valueSum;
+    m_squaredValueSum += other.m_squaredValueSum;
+    m_incorporatedValues += other.m_incorporatedValues;
+}
+
 inline long double AveragedValue::valueSum() const
 {
     return m_valueSum;
@@ -130,9 +152,13 @@ struct SimmedMove
     // expand the levels list to be at least number long
     void setNumberLevels(unsigned int number);
 
-    // clear all level values
+    // clear all level values, residual, spread and wins
     void clear();
 
+    // Add the statistics of other, a simulation of the same move that
+    // was run elsewhere, to these.
+    void incorporateResults(const SimmedMove &other);
+
     bool includeInSimulation() const;
     void setIncludeInSimulation(bool includeInSimulation);
 
@@ -142,6 +168,11 @@ struct SimmedMove
     AveragedValue gameSpread;
     AveragedValue wins;
 
+    // The board after the move, which is the same every iteration,
+    // made ready for generating the replies to it. Prepared by the
+    // first iteration.
+    GenerationContext replyContext;
+
     PositionStatistics getPositionStatistics(int level, int playerIndex) const;
 
 private:
@@ -191,6 +222,31 @@ public:
     void setDispatch(ComputerDispatch *dispatch);
     ComputerDispatch *dispatch() const;
 
+    // Statistics of moves are saved in cache when the simulator is
+    // given another position, and restored when simulating a position
+    // and number of plies found in it. Simulating at another number
+    // of plies than before starts from what is cached for those plies.
+    // The cache is not owned; pass 0 to stop using one.
+    void setCache(SimulationCache *cache);
+    SimulationCache *cache() const;
+
+    // save statistics of moves simulated so far in the cache
+    void storeInCache();
+
+    // Replace the statistics of moves with what is cached for them,
+    // as when another simulator sharing the cache has simulated the
+    // position meanwhile. Does nothing before the first simulate().
+    void reloadFromCache();
+
+    // Results of each position are exported as training records when
+    // the simulator is given another position or destroyed. The
+    // exporter is not owned; pass 0 to stop exporting.
+    void setTrainingExporter(TrainingExporter *exporter);
+    TrainingExporter *trainingExporter() const;
+
+    // export results of iterations run since the last export now
+    void exportResults();
+
     // append message to logfile if one is open
     void logMessage(const UVString &message);
 
@@ -222,7 +278,14 @@ public:
     void setIgnoreOppos(bool ignore);
     bool ignoreOppos() const;
 
-    // set values for all levels of all moves to zero
+    // How plies after the candidate are played; static best
+    // moves by default. Numbers run under another policy are
+    // reset, and left in the cache under that policy.
+    void setRolloutPolicy(const RolloutPolicy &policy);
+    const RolloutPolicy &rolloutPolicy() const;
+
+    // set values for all levels of all moves to zero, and
+    // forget what is cached for the position
     void resetNumbers();
 
     // Run a chunk of the simulation.
@@ -235,6 +298,18 @@ public:
     // simulate one iteration
     void simulate(int plies);
 
+    // Run numberOfSeeds iterations, seeding the random numbers with
+    // firstSeed, firstSeed + 1 and so on before each. An iteration
+    // then plays out the same on any simulator of the same position,
+    // so a range of seeds can be split among simulators in several
+    // processes and their results added up with incorporateResults.
+    void simulateSeeds(int plies, unsigned int firstSeed, int numberOfSeeds);
+
+    // Add the statistics of moves simulated for plies elsewhere, over
+    // iterations iterations, to those of the matching simmed moves.
+    // Moves this simulator doesn't have are ignored.
+    void incorporateResults(int plies, const SimmedMoveList &moves, int iterations);
+
     // Set oppo's rack to some partially-known tiles.
     // Set this to an empty rack if no tiles are known, so
     // that all tiles are chosen randomly each iteration.
@@ -273,11 +348,34 @@ protected:
     void writeLogHeader();
     void writeLogFooter();
 
-    UVOFStream m_logfileStream;
+    // zero numbers and restore them from the cache if they
+    // are not yet for this position and number of plies
+    void attachToCache(int plies);
+
+    // restore from the cache, and count iterations in, a move
+    // new to the simulation
+    void restoreFromCache(SimmedMove &move);
+
+    // Puts the opponents' racks back in the bag and sorts the bag and
+    // the rack on turn, so that what an iteration deals depends on the
+    // random numbers alone and not on the iterations before it.
+    void canonicalizeUnseenTiles();
+
+    SimulationCache *m_cache;
+
+    // whether numbers are for the position and plies below
+    bool m_isAttachedToCache;
+    uint64_t m_cachePosition;
+    int m_cachePlies;
+
+    TrainingExporter *m_trainingExporter;
+
+    // false once iterations have been run that aren't exported yet
+    bool m_resultsExported;
+
+    SimulationLog m_log;
     string m_logfile;
-    bool m_logfileIsOpen;
     bool m_hasHeader;
-    UVString m_xmlIndent;
 
     Rack m_partialOppoRack;
 
@@ -292,6 +390,8 @@ protected:
 
     int m_iterations;
     bool m_ignoreOppos;
+
+    RolloutPolicy m_rolloutPolicy;
 };
 
 inline GamePosition &Simulator::currentPosition()
@@ -314,6 +414,16 @@ inline ComputerDispatch *Simulator::dispatch() const
 	return m_dispatch;
 }
 
+inline SimulationCache *Simulator::cache() const
+{
+	return m_cache;
+}
+
+inline TrainingExporter *Simulator::trainingExporter() const
+{
+	return m_trainingExporter;
+}
+
 inline string Simulator::logfile() const
 {
 	return m_logfile;
@@ -321,7 +431,7 @@ inline string Simulator::logfile() const
 
 inline bool Simulator::isLogging() const
 {
-	return m_logfileIsOpen;
+	return m_log.isOpen();
 }
 
 inline const Rack &Simulator::partialOppoRack() const
@@ -329,6 +439,11 @@ inline const Rack &Simulator::partialOppoRack() const
 	return m_partialOppoRack;
 }
 
+inline const RolloutPolicy &Simulator::rolloutPolicy() const
+{
+	return m_rolloutPolicy;
+}
+
 inline void Simulator::setConsideredMoves(const MoveList &moves)
 {
 	m_consideredMoves = moves;
@@ -0,0 +1,420 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+#include "datamanager.h"
+#include "lexiconparameters.h"
+#include "simulationcache.h"
+
+using namespace std;
+using namespace Quackle;
+
+namespace
+{
+
+// FNV-1a
+const SimulationCache::PositionHash hashOffsetBasis = 14695981039346656037ULL;
+const SimulationCache::PositionHash hashPrime = 1099511628211ULL;
+
+void hashBytes(SimulationCache::PositionHash &hash, const char *bytes, size_t length)
+{
+	for (size_t i = 0; i < length; ++i)
+	{
+		hash ^= (unsigned char)bytes[i];
+		hash *= hashPrime;
+	}
+}
+
+void hashInt(SimulationCache::PositionHash &hash, int value)
+{
+	hashBytes(hash, (const char *)&value, sizeof(value));
+}
+
+void hashLetters(SimulationCache::PositionHash &hash, const LetterString &letters)
+{
+	hashInt(hash, letters.length());
+	hashBytes(hash, letters.constData(), letters.length());
+}
+
+// Moves that are equal but compare differently with operator<,
+// like exchanges of the same tiles in another order, get one key.
+Move keyMove(const Move &move)
+{
+	Move ret(move);
+	if (ret.action == Move::Exchange || ret.action == Move::UnusedTilesBonus || ret.action == Move::UnusedTilesBonusError)
+		ret.setTiles(String::alphabetize(ret.tiles()));
+	return ret;
+}
+
+// The statistics of move alone, which are what restore hands back;
+// the reply context carries a whole board.
+SimmedMove statistics(const SimmedMove &move)
+{
+	SimmedMove ret(move.move);
+	ret.levels = move.levels;
+	ret.residual = move.residual;
+	ret.gameSpread = move.gameSpread;
+	ret.wins = move.wins;
+	return ret;
+}
+
+const char cacheFileMagic[] = "QUACKLE SIMCACHE 1";
+
+// sanity limits on counts read from a cache file; a simulation
+// to the end of the game has at most this many levels
+const int maximumLevels = 1000;
+const int maximumPlayers = 100;
+
+template <typename T> void writeValue(ofstream &file, const T &value)
+{
+	file.write((const char *)&value, sizeof(value));
+}
+
+template <typename T> bool readValue(ifstream &file, T *value)
+{
+	file.read((char *)value, sizeof(*value));
+	return file.good();
+}
+
+void writeAveragedValue(ofstream &file, const AveragedValue &value)
+{
+	writeValue(file, value.valueSum());
+	writeValue(file, value.squaredValueSum());
+	writeValue(file, value.incorporatedValues());
+}
+
+bool readAveragedValue(ifstream &file, AveragedValue *value)
+{
+	long double valueSum;
+	long double squaredValueSum;
+	long int incorporatedValues;
+	if (!readValue(file, &valueSum) || !readValue(file, &squaredValueSum) || !readValue(file, &incorporatedValues))
+		return false;
+
+	*value = AveragedValue(valueSum, squaredValueSum, incorporatedValues);
+	return true;
+}
+
+}
+
+SimulationCache::Key::Key(PositionHash _position, int _plies, const Move &_move)
+	: position(_position), plies(_plies), move(keyMove(_move))
+{
+}
+
+bool SimulationCache::Key::operator<(const Key &other) const
+{
+	if (position != other.position)
+		return position < other.position;
+	if (plies != other.plies)
+		return plies < other.plies;
+	return move < other.move;
+}
+
+SimulationCache::SimulationCache()
+	: m_maximumSize(50000)
+{
+}
+
+SimulationCache::PositionHash SimulationCache::positionHash(const GamePosition &position, const Rack &partialOppoRack, bool ignoreOppos, const RolloutPolicy &rolloutPolicy)
+{
+	PositionHash ret = hashOffsetBasis;
+
+	const string lexicon = QUACKLE_LEXICON_PARAMETERS->lexiconName();
+	hashBytes(ret, lexicon.c_str(), lexicon.length());
+
+	const Board &board = position.board();
+	hashInt(ret, board.width());
+	hashInt(ret, board.height());
+	for (int row = 0; row < board.height(); ++row)
+	{
+		for (int col = 0; col < board.width(); ++col)
+		{
+			hashInt(ret, board.letter(row, col));
+			hashInt(ret, board.isBlank(row, col));
+		}
+	}
+
+	hashLetters(ret, String::alphabetize(position.currentPlayer().rack().tiles()));
+	hashInt(ret, position.bag().size());
+
+	const int currentPlayerId = position.currentPlayer().id();
+	const PlayerList::const_iterator end = position.players().end();
+	for (PlayerList::const_iterator it = position.players().begin(); it != end; ++it)
+		if ((*it).id() != currentPlayerId)
+			hashInt(ret, position.spread(currentPlayerId) - position.spread((*it).id()));
+
+	hashLetters(ret, String::alphabetize(partialOppoRack.tiles()));
+	hashInt(ret, ignoreOppos);
+
+	hashInt(ret, rolloutPolicy.type());
+	if (rolloutPolicy.type() == RolloutPolicy::TopSampled)
+	{
+		const double temperature = rolloutPolicy.temperature();
+		hashInt(ret, rolloutPolicy.sampledMoves());
+		hashBytes(ret, (const char *)&temperature, sizeof(temperature));
+	}
+
+	return ret;
+}
+
+void SimulationCache::store(PositionHash position, int plies, const SimmedMove &move)
+{
+	const Key key(position, plies, move.move);
+	const SimmedMove entry(statistics(move));
+	lock_guard<mutex> lock(m_mutex);
+
+	EntryMap::iterator it = m_entries.find(key);
+	if (it == m_entries.end())
+		m_entries.insert(EntryMap::value_type(key, entry));
+	else if (it->second.gameSpread.incorporatedValues() <= entry.gameSpread.incorporatedValues())
+		it->second = entry;
+
+	use(position);
+	evict();
+}
+
+bool SimulationCache::restore(PositionHash position, int plies, SimmedMove &move) const
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	EntryMap::const_iterator it = m_entries.find(Key(position, plies, move.move));
+	if (it == m_entries.end())
+		return false;
+
+	use(position);
+
+	move.levels = it->second.levels;
+	move.residual = it->second.residual;
+	move.gameSpread = it->second.gameSpread;
+	move.wins = it->second.wins;
+	return true;
+}
+
+void SimulationCache::forget(PositionHash position)
+{
+	lock_guard<mutex> lock(m_mutex);
+	erase(position);
+}
+
+void SimulationCache::clear()
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_entries.clear();
+	m_recency.clear();
+	m_recencyOfPosition.clear();
+}
+
+int SimulationCache::size() const
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_entries.size();
+}
+
+void SimulationCache::setMaximumSize(int maximumSize)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_maximumSize = maximumSize;
+	evict();
+}
+
+int SimulationCache::maximumSize() const
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_maximumSize;
+}
+
+void SimulationCache::use(PositionHash position) const
+{
+	map<PositionHash, RecencyList::iterator>::iterator it = m_recencyOfPosition.find(position);
+	if (it == m_recencyOfPosition.end())
+	{
+		m_recency.push_front(position);
+		m_recencyOfPosition.insert(make_pair(position, m_recency.begin()));
+	}
+	else
+		m_recency.splice(m_recency.begin(), m_recency, it->second);
+}
+
+void SimulationCache::erase(PositionHash position)
+{
+	// keys of a position are together, starting below any plies
+	EntryMap::iterator it = m_entries.lower_bound(Key(position, numeric_limits<int>::min(), Move()));
+	while (it != m_entries.end() && it->first.position == position)
+		m_entries.erase(it++);
+
+	map<PositionHash, RecencyList::iterator>::iterator recencyIt = m_recencyOfPosition.find(position);
+	if (recencyIt != m_recencyOfPosition.end())
+	{
+		m_recency.erase(recencyIt->second);
+		m_recencyOfPosition.erase(recencyIt);
+	}
+}
+
+void SimulationCache::evict()
+{
+	// the position used last stays, however big it is
+	while (m_maximumSize > 0 && (int)m_entries.size() > m_maximumSize && m_recency.size() > 1)
+		erase(m_recency.back());
+}
+
+bool SimulationCache::save(const string &filename) const
+{
+	ofstream file(filename.c_str(), ios::out | ios::binary | ios::trunc);
+	if (!file.is_open())
+	{
+		cerr << "Could not open " << filename << " to write simulation cache" << endl;
+		return false;
+	}
+
+	lock_guard<mutex> lock(m_mutex);
+
+	file.write(cacheFileMagic, sizeof(cacheFileMagic));
+	writeValue(file, (int)m_entries.size());
+
+	for (EntryMap::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+	{
+		const Move &move = it->first.move;
+		writeValue(file, it->first.position);
+		writeValue(file, it->first.plies);
+
+		writeValue(file, (int)move.action);
+		writeValue(file, move.horizontal);
+		writeValue(file, move.startrow);
+		writeValue(file, move.startcol);
+		writeValue(file, move.scoreAddition());
+		writeValue(file, move.isChallengedPhoney());
+		writeValue(file, (int)move.tiles().length());
+		file.write(move.tiles().constData(), move.tiles().length());
+
+		const SimmedMove &simmedMove = it->second;
+		writeAveragedValue(file, simmedMove.residual);
+		writeAveragedValue(file, simmedMove.gameSpread);
+		writeAveragedValue(file, simmedMove.wins);
+
+		writeValue(file, (int)simmedMove.levels.size());
+		for (LevelList::const_iterator levelIt = simmedMove.levels.begin(); levelIt != simmedMove.levels.end(); ++levelIt)
+		{
+			writeValue(file, (int)(*levelIt).statistics.size());
+			for (PositionStatisticsList::const_iterator statisticsIt = (*levelIt).statistics.begin(); statisticsIt != (*levelIt).statistics.end(); ++statisticsIt)
+			{
+				writeAveragedValue(file, (*statisticsIt).score);
+				writeAveragedValue(file, (*statisticsIt).bingos);
+			}
+		}
+	}
+
+	return file.good();
+}
+
+bool SimulationCache::load(const string &filename)
+{
+	ifstream file(filename.c_str(), ios::in | ios::binary);
+	if (!file.is_open())
+	{
+		cerr << "Could not open " << filename << " to read simulation cache" << endl;
+		return false;
+	}
+
+	char magic[sizeof(cacheFileMagic)];
+	int numberOfEntries;
+	if (!file.read(magic, sizeof(magic)) || string(magic, sizeof(magic)) != string(cacheFileMagic, sizeof(cacheFileMagic)) || !readValue(file, &numberOfEntries))
+	{
+		cerr << filename << " is not a simulation cache" << endl;
+		return false;
+	}
+
+	int entriesRead;
+	for (entriesRead = 0; entriesRead < numberOfEntries; ++entriesRead)
+	{
+		PositionHash position;
+		int plies;
+		int action;
+		bool horizontal;
+		int startrow;
+		int startcol;
+		int scoreAddition;
+		bool isChallengedPhoney;
+		int tilesLength;
+
+		if (!readValue(file, &position) || !readValue(file, &plies) || !readValue(file, &action) || !readValue(file, &horizontal) || !readValue(file, &startrow) || !readValue(file, &startcol) || !readValue(file, &scoreAddition) || !readValue(file, &isChallengedPhoney) || !readValue(file, &tilesLength))
+			break;
+
+		if (action < Move::Place || action > Move::Nonmove || tilesLength < 0 || tilesLength > QUACKLE_MAXIMUM_BOARD_SIZE)
+			break;
+
+		char tiles[QUACKLE_MAXIMUM_BOARD_SIZE];
+		if (!file.read(tiles, tilesLength))
+			break;
+
+		Move move(Move::createNonmove());
+		move.action = (Move::Action)action;
+		move.horizontal = horizontal;
+		move.startrow = startrow;
+		move.startcol = startcol;
+		move.setScoreAddition(scoreAddition);
+		move.setIsChallengedPhoney(isChallengedPhoney);
+		move.setTiles(LetterString(tiles, tilesLength));
+
+		SimmedMove simmedMove(move);
+		if (!readAveragedValue(file, &simmedMove.residual) || !readAveragedValue(file, &simmedMove.gameSpread) || !readAveragedValue(file, &simmedMove.wins))
+			break;
+
+		int numberOfLevels;
+		if (!readValue(file, &numberOfLevels) || numberOfLevels < 0 || numberOfLevels > maximumLevels)
+			break;
+
+		bool levelsRead = true;
+		simmedMove.setNumberLevels(numberOfLevels);
+		for (LevelList::iterator levelIt = simmedMove.levels.begin(); levelsRead && levelIt != simmedMove.levels.end(); ++levelIt)
+		{
+			int numberOfScores;
+			if (!readValue(file, &numberOfScores) || numberOfScores < 0 || numberOfScores > maximumPlayers)
+			{
+				levelsRead = false;
+				break;
+			}
+
+			(*levelIt).setNumberScores(numberOfScores);
+			for (PositionStatisticsList::iterator statisticsIt = (*levelIt).statistics.begin(); statisticsIt != (*levelIt).statistics.end(); ++statisticsIt)
+			{
+				if (!readAveragedValue(file, &(*statisticsIt).score) || !readAveragedValue(file, &(*statisticsIt).bingos))
+				{
+					levelsRead = false;
+					break;
+				}
+			}
+		}
+
+		if (!levelsRead)
+			break;
+
+		store(position, plies, simmedMove);
+	}
+
+	if (entriesRead < numberOfEntries)
+	{
+		cerr << filename << " is truncated; read " << entriesRead << " of " << numberOfEntries << " simulation cache entries" << endl;
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,116 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_SIMULATIONCACHE_H
+#define QUACKLE_SIMULATIONCACHE_H
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+
+#include "sim.h"
+
+using namespace std;
+
+namespace Quackle
+{
+
+// Keeps the statistics of simulated moves around after a simulator
+// has moved on to another position, so that simulating the position
+// again picks up where it left off. Statistics are keyed by a hash
+// of the position, the move, and the number of plies simulated.
+// Simulators on several threads may share a cache. The cache is
+// bounded; the positions stored or restored longest ago make way for
+// new ones.
+class SimulationCache
+{
+public:
+	typedef uint64_t PositionHash;
+
+	SimulationCache();
+
+	// Hash of everything that changes what a simulation of position
+	// converges to: the board, the rack on turn, the number of tiles
+	// in the bag, the spread, the lexicon, and the simulator options,
+	// among them how plies are played. Truncation of the rollouts
+	// goes into the plies of the key instead.
+	static PositionHash positionHash(const GamePosition &position, const Rack &partialOppoRack, bool ignoreOppos, const RolloutPolicy &rolloutPolicy);
+
+	// Replaces whatever was cached for this move, unless that has
+	// more iterations: a simulator that has fallen behind another
+	// one simulating the same position doesn't undo its work.
+	void store(PositionHash position, int plies, const SimmedMove &move);
+
+	// If statistics for move are cached, copies them into move and
+	// returns true. The move itself and its inclusion are untouched.
+	bool restore(PositionHash position, int plies, SimmedMove &move) const;
+
+	// drop statistics for position at any number of plies
+	void forget(PositionHash position);
+
+	void clear();
+
+	// number of moves cached, at any number of plies
+	int size() const;
+
+	// When more than this many moves are cached, the statistics of
+	// the positions least recently stored or restored are dropped,
+	// a position at a time. Default 50000; 0 means no limit.
+	void setMaximumSize(int maximumSize);
+	int maximumSize() const;
+
+	// Write the cache to a file, or merge the contents of a file
+	// written by save into the cache. Return false on failure.
+	bool save(const string &filename) const;
+	bool load(const string &filename);
+
+private:
+	struct Key
+	{
+		Key(PositionHash _position, int _plies, const Move &_move);
+
+		PositionHash position;
+		int plies;
+		Move move;
+
+		bool operator<(const Key &other) const;
+	};
+
+	typedef map<Key, SimmedMove> EntryMap;
+	EntryMap m_entries;
+
+	// positions cached, the most recently stored or restored first
+	typedef list<PositionHash> RecencyList;
+	mutable RecencyList m_recency;
+	mutable map<PositionHash, RecencyList::iterator> m_recencyOfPosition;
+
+	int m_maximumSize;
+
+	// these expect m_mutex to be held
+	void use(PositionHash position) const;
+	void erase(PositionHash position);
+	void evict();
+
+	mutable mutex m_mutex;
+};
+
+}
+
+#endif
@@ -0,0 +1,340 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+#include "datamanager.h"
+#include "move.h"
+#include "rack.h"
+#include "simulationlog.h"
+
+using namespace Quackle;
+
+static_assert((SimulationLog::capacity & (SimulationLog::capacity - 1)) == 0, "simulation log capacity must be a power of two");
+
+// chrono::milliseconds takes it by reference
+const int SimulationLog::maximumLatencyMilliseconds;
+
+SimulationLog::SimulationLog()
+	: m_isOpen(false), m_dataManager(0), m_head(0), m_tail(0), m_closing(false), m_depth(0)
+{
+}
+
+SimulationLog::~SimulationLog()
+{
+	close();
+}
+
+bool SimulationLog::open(const string &filename, bool append)
+{
+	close();
+
+	const ios::openmode flags = append? (ios::out | ios::app) : ios::out;
+	m_file.open(filename.c_str(), flags);
+
+	if (!m_file.is_open())
+	{
+		cerr << "Could not open " << filename << " to write simulation log" << endl;
+		return false;
+	}
+
+	m_isOpen = true;
+	m_dataManager = DataManager::self();
+	m_events.resize(capacity);
+	m_head.store(0);
+	m_tail.store(0);
+	m_closing.store(false);
+	m_depth = 0;
+	m_writer = thread(&SimulationLog::writerLoop, this);
+	return true;
+}
+
+void SimulationLog::close()
+{
+	if (!m_isOpen)
+		return;
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_closing.store(true);
+	}
+
+	m_eventsReady.notify_one();
+	m_writer.join();
+
+	m_file.close();
+	m_isOpen = false;
+}
+
+void SimulationLog::beginSimulation()
+{
+	push(SimulationStart);
+}
+
+void SimulationLog::endSimulation()
+{
+	push(SimulationEnd);
+}
+
+void SimulationLog::beginIteration(int index)
+{
+	push(IterationStart, index);
+}
+
+void SimulationLog::endIteration()
+{
+	push(IterationEnd);
+	flush();
+}
+
+void SimulationLog::beginPlayahead()
+{
+	push(PlayaheadStart);
+}
+
+void SimulationLog::endPlayahead()
+{
+	push(PlayaheadEnd);
+}
+
+void SimulationLog::beginPly(int index)
+{
+	push(PlyStart, index);
+}
+
+void SimulationLog::endPly()
+{
+	push(PlyEnd);
+}
+
+void SimulationLog::rack(const Rack &rack)
+{
+	Event event;
+	event.type = RackEvent;
+	event.length = min((int)rack.tiles().length(), LETTER_STRING_MAXIMUM_LENGTH);
+	memcpy(event.letters, rack.tiles().constData(), event.length);
+	push(event);
+}
+
+void SimulationLog::move(const Move &move)
+{
+	Event event;
+	event.type = MoveEvent;
+	event.number = move.score;
+	event.action = move.action;
+	event.horizontal = move.horizontal;
+	event.startrow = move.startrow;
+	event.startcol = move.startcol;
+	event.length = min((int)move.tiles().length(), LETTER_STRING_MAXIMUM_LENGTH);
+	memcpy(event.letters, move.tiles().constData(), event.length);
+	push(event);
+}
+
+void SimulationLog::playerConsideration(double value)
+{
+	push(PlayerConsideration, 0, value);
+}
+
+void SimulationLog::sharedConsideration(double value)
+{
+	push(SharedConsideration, 0, value);
+}
+
+void SimulationLog::gameOver(float win)
+{
+	push(GameOver, 0, win);
+}
+
+void SimulationLog::message(const UVString &message)
+{
+	Event event;
+	event.type = Message;
+	event.message = new UVString(message);
+	push(event);
+}
+
+void SimulationLog::flush()
+{
+	push(Flush);
+	wakeWriter();
+}
+
+void SimulationLog::push(EventType type, int32_t number, double value)
+{
+	Event event;
+	event.type = type;
+	event.number = number;
+	event.value = value;
+	push(event);
+}
+
+void SimulationLog::push(const Event &event)
+{
+	if (!m_isOpen)
+	{
+		if (event.type == Message)
+			delete event.message;
+		return;
+	}
+
+	const size_t head = m_head.load(memory_order_relaxed);
+
+	if (head - m_tail.load(memory_order_acquire) >= (size_t)capacity)
+	{
+		wakeWriter();
+		while (head - m_tail.load(memory_order_acquire) >= (size_t)capacity)
+			this_thread::yield();
+	}
+
+	// only the writing of the event is copied, not the unused letters
+	Event &slot = m_events[head & (capacity - 1)];
+	memcpy(&slot, &event, offsetof(Event, letters));
+	if (event.type == RackEvent || event.type == MoveEvent)
+		memcpy(slot.letters, event.letters, event.length);
+
+	m_head.store(head + 1, memory_order_release);
+}
+
+void SimulationLog::wakeWriter()
+{
+	// the writer checks for events while holding the mutex, so taking
+	// it here means the writer is either not yet waiting or will be woken
+	{
+		lock_guard<mutex> lock(m_mutex);
+	}
+
+	m_eventsReady.notify_one();
+}
+
+void SimulationLog::writerLoop()
+{
+	DataManagerScope scope(m_dataManager);
+
+	while (true)
+	{
+		size_t tail = m_tail.load(memory_order_relaxed);
+		const size_t head = m_head.load(memory_order_acquire);
+
+		if (tail == head)
+		{
+			unique_lock<mutex> lock(m_mutex);
+
+			if (m_closing.load() && m_head.load(memory_order_acquire) == tail)
+				break;
+
+			m_eventsReady.wait_for(lock, chrono::milliseconds(maximumLatencyMilliseconds), [this, tail]() { return m_head.load(memory_order_acquire) != tail || m_closing.load(); });
+			continue;
+		}
+
+		for (; tail != head; ++tail)
+		{
+			write(m_events[tail & (capacity - 1)]);
+
+			// hand each slot back as soon as it's written, so a
+			// logger waiting for room doesn't wait for the whole batch
+			m_tail.store(tail + 1, memory_order_release);
+		}
+	}
+
+	m_file.flush();
+}
+
+void SimulationLog::write(const Event &event)
+{
+	const UVString indent(max(m_depth, 0), MARK_UV('\t'));
+
+	switch (event.type)
+	{
+	case SimulationStart:
+		m_file << "<simulation>\n";
+		m_depth = 1;
+		break;
+
+	case SimulationEnd:
+		m_depth = 0;
+		m_file << "</simulation>\n";
+		break;
+
+	case IterationStart:
+		m_file << indent << "<iteration index=\"" << event.number << "\">\n";
+		++m_depth;
+		break;
+
+	case PlayaheadStart:
+		m_file << indent << "<playahead>\n";
+		++m_depth;
+		break;
+
+	case PlyStart:
+		m_file << indent << "<ply index=\"" << event.number << "\">\n";
+		++m_depth;
+		break;
+
+	case IterationEnd:
+	case PlayaheadEnd:
+	case PlyEnd:
+	{
+		--m_depth;
+		const char *tag = event.type == IterationEnd? "iteration" : event.type == PlayaheadEnd? "playahead" : "ply";
+		m_file << UVString(max(m_depth, 0), MARK_UV('\t')) << "</" << tag << ">\n";
+		break;
+	}
+
+	case RackEvent:
+		m_file << indent << Rack(LetterString((const char *)event.letters, event.length)).xml() << '\n';
+		break;
+
+	case MoveEvent:
+	{
+		Move move = Move::createNonmove();
+		move.action = (Move::Action)event.action;
+		move.horizontal = event.horizontal;
+		move.startrow = event.startrow;
+		move.startcol = event.startcol;
+		move.score = event.number;
+		move.setTiles(LetterString((const char *)event.letters, event.length));
+		m_file << indent << move.xml() << '\n';
+		break;
+	}
+
+	case PlayerConsideration:
+		m_file << indent << "<pc value=\"" << event.value << "\" />\n";
+		break;
+
+	case SharedConsideration:
+		m_file << indent << "<sc value=\"" << event.value << "\" />\n";
+		break;
+
+	case GameOver:
+		m_file << indent << "<gameover win=\"" << (float)event.value << "\" />\n";
+		break;
+
+	case Message:
+		m_file << *event.message << '\n';
+		delete event.message;
+		break;
+
+	case Flush:
+		m_file.flush();
+		break;
+	}
+}
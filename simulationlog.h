@@ -0,0 +1,177 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_SIMULATIONLOG_H
+#define QUACKLE_SIMULATIONLOG_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "alphabetparameters.h"
+
+using namespace std;
+
+namespace Quackle
+{
+
+class DataManager;
+class Move;
+class Rack;
+
+// The XML log of a simulation. Logging a step only copies a small
+// event into a ring buffer; a background thread turns events into XML
+// and writes them, so a simulation runs about as fast logged as not.
+// The buffer holds a fixed number of events, and logging waits for the
+// writer when it is full.
+//
+// Events must all be logged from one thread.
+class SimulationLog
+{
+public:
+	SimulationLog();
+	~SimulationLog();
+
+	// Opens filename for writing, closing the log open before.
+	// Returns false if the file can't be written.
+	bool open(const string &filename, bool append = true);
+
+	// writes all events logged so far and closes the file
+	void close();
+
+	bool isOpen() const;
+
+	void beginSimulation();
+	void endSimulation();
+
+	// ends by flushing the iteration to the file
+	void beginIteration(int index);
+	void endIteration();
+
+	void beginPlayahead();
+	void endPlayahead();
+
+	void beginPly(int index);
+	void endPly();
+
+	void rack(const Rack &rack);
+	void move(const Move &move);
+
+	void playerConsideration(double value);
+	void sharedConsideration(double value);
+	void gameOver(float win);
+
+	void message(const UVString &message);
+
+	// Has the writer write out everything logged so far and flush
+	// the file. Doesn't wait for it to do so.
+	void flush();
+
+	// events the ring buffer holds; a power of two
+	static const int capacity = 4096;
+
+	// longest the writer sleeps before looking for events that
+	// weren't flushed
+	static const int maximumLatencyMilliseconds = 100;
+
+private:
+	enum EventType
+	{
+		SimulationStart,
+		SimulationEnd,
+		IterationStart,
+		IterationEnd,
+		PlayaheadStart,
+		PlayaheadEnd,
+		PlyStart,
+		PlyEnd,
+		RackEvent,
+		MoveEvent,
+		PlayerConsideration,
+		SharedConsideration,
+		GameOver,
+		Message,
+		Flush
+	};
+
+	struct Event
+	{
+		union
+		{
+			double value;
+
+			// owned by the event until it's written
+			UVString *message;
+		};
+
+		// iteration or ply index, or score of a move
+		int32_t number;
+
+		uint8_t type;
+		uint8_t action;
+		uint8_t horizontal;
+		uint8_t startrow;
+		uint8_t startcol;
+		uint8_t length;
+
+		// of the rack or Move::tiles()
+		Letter letters[LETTER_STRING_MAXIMUM_LENGTH];
+	};
+
+	void push(const Event &event);
+	void push(EventType type, int32_t number = 0, double value = 0);
+
+	// wakes the writer and makes sure it doesn't miss the wake-up
+	void wakeWriter();
+
+	void writerLoop();
+	void write(const Event &event);
+
+	UVOFStream m_file;
+	bool m_isOpen;
+
+	// alphabet of the thread that opened the log, to format letters
+	DataManager *m_dataManager;
+
+	// Single producer, single consumer: only the logging thread
+	// advances m_head and only the writer advances m_tail.
+	vector<Event> m_events;
+	atomic<size_t> m_head;
+	atomic<size_t> m_tail;
+
+	mutex m_mutex;
+	condition_variable m_eventsReady;
+	atomic<bool> m_closing;
+	thread m_writer;
+
+	// xml nesting of the writer
+	int m_depth;
+};
+
+inline bool SimulationLog::isOpen() const
+{
+	return m_isOpen;
+}
+
+}
+
+#endif
@@ -245,3 +245,42 @@ bool StrategyParameters::loadSuperleaves(const string &filename)
 	file.close();
 	return true;	
 }
+
+void StrategyParameters::setSuperleaves(const SuperLeavesMap &superleaves)
+{
+	m_superleaves = superleaves;
+	m_hasSuperleaves = !m_superleaves.empty();
+}
+
+bool StrategyParameters::saveSuperleaves(const string &filename, const SuperLeavesMap &superleaves)
+{
+	ofstream file(filename.c_str(), ios::out | ios::binary | ios::trunc);
+
+	if (!file.is_open())
+	{
+		cerr << "Could not open " << filename << " to write superleaves" << endl;
+		return false;
+	}
+
+	for (SuperLeavesMap::const_iterator it = superleaves.begin(); it != superleaves.end(); ++it)
+	{
+		if (it->first.length() == 0 || it->first.length() > 16)
+			continue;
+
+		const double scaled = (it->second + 128.0) * 256.0;
+		const unsigned int intvalue = scaled < 0? 0 : scaled > 65535? 65535 : (unsigned int)(scaled + 0.5);
+
+		// low byte first, as loadSuperleaves reads it
+		const unsigned char leavesize = it->first.length();
+		const unsigned char intvaluefrac = intvalue % 256;
+		const unsigned char intvalueint = intvalue / 256;
+
+		file.write((const char *)&leavesize, 1);
+		file.write(it->first.constData(), leavesize);
+		file.write((const char *)&intvaluefrac, 1);
+		file.write((const char *)&intvalueint, 1);
+	}
+
+	file.close();
+	return !file.fail();
+}
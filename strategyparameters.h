@@ -20,7 +20,9 @@
 #define QUACKLE_STRATEGYPARAMETERS_H
 
 #include <map>
+#include <string>
 #include "alphabetparameters.h"
+#include "board.h"
 
 namespace Quackle
 {
@@ -43,6 +45,18 @@ public:
 	double vcPlace(int start, int length, int consbits);
 	double bogowin(int lead, int unseen, int blanks);
 	double superleave(LetterString leave);
+
+	typedef map<LetterString, double> SuperLeavesMap;
+
+	// Replaces the superleaves, eg. with newly trained values. Not to be
+	// called while other threads are evaluating moves.
+	void setSuperleaves(const SuperLeavesMap &superleaves);
+	const SuperLeavesMap &superleaves() const;
+
+	// Writes alphabetized leaves and their values in the format
+	// loadSuperleaves reads. Values are stored in 1/256ths of a point
+	// and clamped to [-128, 128).
+	static bool saveSuperleaves(const string &filename, const SuperLeavesMap &superleaves);
 	
 protected:
 	bool loadSyn2(const string &filename);
@@ -60,7 +74,6 @@ protected:
 	static const int m_bogowinArrayWidth = 601;
 	static const int m_bogowinArrayHeight = 94;
 	double m_bogowin[m_bogowinArrayWidth][m_bogowinArrayHeight];
-	typedef map<LetterString, double> SuperLeavesMap;
 	SuperLeavesMap m_superleaves;
 	bool m_hasSyn2;
 	bool m_hasWorths;
@@ -141,7 +154,16 @@ inline double StrategyParameters::superleave(LetterString leave)
 {
 	if (leave.length() == 0)
 		return 0.0;
-	return m_superleaves[leave];
+
+	// find rather than operator[], which would insert into a map
+	// that evaluating threads share
+	SuperLeavesMap::const_iterator it = m_superleaves.find(leave);
+	return it == m_superleaves.end()? 0.0 : it->second;
+}
+
+inline const StrategyParameters::SuperLeavesMap &StrategyParameters::superleaves() const
+{
+	return m_superleaves;
 }
 
 }
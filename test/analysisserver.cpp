@@ -0,0 +1,376 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2006 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301  USA
+ */
+
+#include <QtCore>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+#include <datamanager.h>
+#include <endgameplayer.h>
+#include <game.h>
+#include <lexiconparameters.h>
+#include <sim.h>
+
+#include <quackleio/gcgio.h>
+#include <quackleio/util.h>
+
+#include "analysisserver.h"
+
+using namespace Quackle;
+
+AnalysisServer::AnalysisServer()
+	: m_game(0), m_readingPosition(false), m_done(false)
+{
+}
+
+AnalysisServer::~AnalysisServer()
+{
+	clearCache();
+	delete m_game;
+}
+
+void AnalysisServer::serve(QTextStream &in, QTextStream &out)
+{
+	out << readyLine() << endl;
+
+	while (!m_done && !in.atEnd())
+	{
+		const QStringList response = handleLine(in.readLine());
+		for (QStringList::const_iterator it = response.begin(); it != response.end(); ++it)
+			out << *it << endl;
+	}
+}
+
+bool AnalysisServer::serveSocket(const QString &socketName)
+{
+	QLocalServer::removeServer(socketName);
+
+	QLocalServer server;
+	if (!server.listen(socketName))
+	{
+		UVcerr << "Could not listen on " << QuackleIO::Util::qstringToString(socketName) << ": " << QuackleIO::Util::qstringToString(server.errorString()) << endl;
+		return false;
+	}
+
+	while (!m_done)
+	{
+		if (!server.waitForNewConnection(-1))
+			break;
+
+		QLocalSocket *socket = server.nextPendingConnection();
+		socket->write((readyLine() + "\n").toUtf8());
+
+		while (!m_done && socket->state() == QLocalSocket::ConnectedState)
+		{
+			if (!socket->canReadLine())
+			{
+				socket->waitForReadyRead(-1);
+				continue;
+			}
+
+			const QString line = QString::fromUtf8(socket->readLine()).trimmed();
+			const QStringList response = handleLine(line);
+			for (QStringList::const_iterator it = response.begin(); it != response.end(); ++it)
+				socket->write((*it + "\n").toUtf8());
+			socket->waitForBytesWritten(-1);
+		}
+
+		socket->disconnectFromServer();
+		delete socket;
+	}
+
+	return true;
+}
+
+QStringList AnalysisServer::handleLine(const QString &line)
+{
+	if (m_readingPosition)
+	{
+		if (line.trimmed() != ".")
+		{
+			m_positionLines.push_back(line);
+			return QStringList();
+		}
+
+		m_readingPosition = false;
+
+		QString gcg = m_positionLines.join("\n");
+		m_positionLines.clear();
+		QTextStream stream(&gcg);
+
+		QuackleIO::GCGIO io;
+		QString error;
+		if (!setGame(io.read(stream, QuackleIO::Logania::MaintainBoardPreparation), &error))
+			return QStringList(errorLine(error));
+
+		return QStringList(QString("{\"ok\": \"position\", \"turn\": %1}").arg(m_game->currentPosition().turnNumber()));
+	}
+
+	QStringList words = line.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+	if (words.isEmpty())
+		return QStringList();
+
+	const QString request = words.takeFirst().toLower();
+
+	if (request == "quit")
+	{
+		m_done = true;
+		return QStringList("{\"ok\": \"quit\"}");
+	}
+
+	if (request == "help")
+	{
+		QStringList ret;
+		ret << "{\"help\": \"position, then GCG lines, then a line with just .\"}";
+		ret << "{\"help\": \"load FILE.gcg\"}";
+		ret << "{\"help\": \"rack LETTERS\"}";
+		ret << "{\"help\": \"kibitz [N]\"}";
+		ret << "{\"help\": \"simulate PLIES SECONDS [N]\"}";
+		ret << "{\"help\": \"endgame [N]\"}";
+		ret << "{\"help\": \"quit\"}";
+		ret << "{\"ok\": \"help\"}";
+		return ret;
+	}
+
+	if (request == "position")
+	{
+		m_readingPosition = true;
+		return QStringList();
+	}
+
+	if (request == "load")
+	{
+		if (words.isEmpty())
+			return QStringList(errorLine("load needs a filename"));
+
+		QuackleIO::GCGIO io;
+		QString error;
+		if (!setGame(io.read(words.join(" "), QuackleIO::Logania::MaintainBoardPreparation), &error))
+			return QStringList(errorLine(error));
+
+		return QStringList(QString("{\"ok\": \"load\", \"turn\": %1}").arg(m_game->currentPosition().turnNumber()));
+	}
+
+	if (!m_game)
+		return QStringList(errorLine("no position; send position or load first"));
+
+	if (request == "rack")
+	{
+		QString error;
+		if (words.isEmpty() || !setRack(words.front(), &error))
+			return QStringList(errorLine(words.isEmpty()? QString("rack needs letters") : error));
+
+		return QStringList("{\"ok\": \"rack\"}");
+	}
+
+	if (request == "kibitz")
+		return kibitz(words.isEmpty()? 10 : words.front().toInt());
+
+	if (request == "simulate")
+	{
+		if (words.size() < 2)
+			return QStringList(errorLine("simulate needs plies and seconds"));
+
+		return simulate(words[0].toInt(), words[1].toInt(), words.size() > 2? words[2].toInt() : 10);
+	}
+
+	if (request == "endgame")
+		return endgame(words.isEmpty()? 10 : words.front().toInt());
+
+	return QStringList(errorLine(QString("unknown request %1").arg(request)));
+}
+
+QStringList AnalysisServer::kibitz(int nmoves)
+{
+	QTime time;
+	time.start();
+
+	CacheEntry &entry = currentEntry();
+	if (entry.staticMovesLength < nmoves)
+	{
+		GamePosition &position = m_game->currentPosition();
+		position.kibitz(nmoves);
+		entry.staticMoves = position.moves();
+		entry.staticMovesLength = nmoves;
+	}
+
+	QStringList ret;
+	int count = 0;
+	for (MoveList::const_iterator it = entry.staticMoves.begin(); it != entry.staticMoves.end() && count < nmoves; ++it, ++count)
+		ret.push_back(moveLine(*it, false));
+
+	ret.push_back(QString("{\"ok\": \"kibitz\", \"moves\": %1, \"ms\": %2}").arg(count).arg(time.elapsed()));
+	return ret;
+}
+
+QStringList AnalysisServer::simulate(int plies, int seconds, int nmoves)
+{
+	QTime time;
+	time.start();
+
+	CacheEntry &entry = currentEntry();
+	if (!entry.simulator)
+	{
+		entry.simulator = new Simulator;
+		entry.simulator->setPosition(m_game->currentPosition());
+	}
+
+	Simulator &simulator = *entry.simulator;
+
+	// moves simmed before stay in the simulation and keep their numbers
+	simulator.currentPosition().kibitz(nmoves);
+	MoveList candidates = simulator.currentPosition().moves();
+	for (SimmedMoveList::const_iterator it = simulator.simmedMoves().begin(); it != simulator.simmedMoves().end(); ++it)
+		if ((*it).includeInSimulation() && !candidates.contains((*it).move))
+			candidates.push_back((*it).move);
+	simulator.setIncludedMoves(candidates);
+
+	if (entry.simulatedPlies != plies)
+	{
+		simulator.resetNumbers();
+		entry.simulatedPlies = plies;
+	}
+
+	const int startingIterations = simulator.iterations();
+	while (time.elapsed() < seconds * 1000)
+		simulator.simulate(plies);
+
+	QStringList ret;
+	const MoveList moves = simulator.moves(/* prune */ true, /* by win */ true);
+	int count = 0;
+	for (MoveList::const_iterator it = moves.begin(); it != moves.end() && count < nmoves; ++it, ++count)
+		ret.push_back(moveLine(*it, true));
+
+	ret.push_back(QString("{\"ok\": \"simulate\", \"moves\": %1, \"iterations\": %2, \"new_iterations\": %3, \"ms\": %4}").arg(count).arg(simulator.iterations()).arg(simulator.iterations() - startingIterations).arg(time.elapsed()));
+	return ret;
+}
+
+QStringList AnalysisServer::endgame(int nmoves)
+{
+	QTime time;
+	time.start();
+
+	if (!m_game->currentPosition().bag().empty())
+		return QStringList(errorLine("bag is not empty"));
+
+	CacheEntry &entry = currentEntry();
+	if (entry.endgameLength < nmoves)
+	{
+		EndgamePlayer player;
+		player.setPosition(m_game->currentPosition());
+		entry.endgameMoves = player.moves(nmoves);
+		entry.endgameLength = nmoves;
+	}
+
+	QStringList ret;
+	int count = 0;
+	for (MoveList::const_iterator it = entry.endgameMoves.begin(); it != entry.endgameMoves.end() && count < nmoves; ++it, ++count)
+		ret.push_back(moveLine(*it, true));
+
+	ret.push_back(QString("{\"ok\": \"endgame\", \"moves\": %1, \"ms\": %2}").arg(count).arg(time.elapsed()));
+	return ret;
+}
+
+bool AnalysisServer::setGame(Game *game, QString *error)
+{
+	if (!game || !game->hasPositions())
+	{
+		*error = "could not read position";
+		delete game;
+		return false;
+	}
+
+	delete m_game;
+	m_game = game;
+	return true;
+}
+
+bool AnalysisServer::setRack(const QString &letters, QString *error)
+{
+	const Rack rack(QuackleIO::Util::encode(letters));
+	GamePosition &position = m_game->currentPosition();
+
+	Bag available(position.unseenBag());
+	available.toss(position.currentPlayer().rack());
+	if (!available.removeLetters(rack.tiles()))
+	{
+		*error = QString("%1 is not among the unseen tiles").arg(letters);
+		return false;
+	}
+
+	position.setCurrentPlayerRack(rack);
+	return true;
+}
+
+AnalysisServer::CacheEntry &AnalysisServer::currentEntry()
+{
+	const QString key = positionKey(m_game->currentPosition());
+
+	QHash<QString, CacheEntry>::iterator it = m_cache.find(key);
+	if (it != m_cache.end())
+		return it.value();
+
+	while (m_cacheOrder.size() >= m_maximumCachedPositions)
+	{
+		const QString oldest = m_cacheOrder.takeFirst();
+		delete m_cache[oldest].simulator;
+		m_cache.remove(oldest);
+	}
+
+	m_cacheOrder.push_back(key);
+	return m_cache[key];
+}
+
+QString AnalysisServer::positionKey(const GamePosition &position) const
+{
+	QString ret = QuackleIO::Util::uvStringToQString(position.board().toString());
+	ret += QuackleIO::Util::uvStringToQString(position.currentPlayer().rack().toString());
+	ret += QString(" %1 %2").arg(position.bag().size()).arg(position.spread());
+	return ret;
+}
+
+void AnalysisServer::clearCache()
+{
+	for (QHash<QString, CacheEntry>::iterator it = m_cache.begin(); it != m_cache.end(); ++it)
+		delete it.value().simulator;
+
+	m_cache.clear();
+	m_cacheOrder.clear();
+}
+
+QString AnalysisServer::moveLine(const Move &move, bool includeWin) const
+{
+	QString ret = QString("{\"move\": \"%1\", \"score\": %2, \"equity\": %3").arg(QuackleIO::Util::uvStringToQString(move.toString())).arg(move.effectiveScore()).arg(move.equity);
+	if (includeWin)
+		ret += QString(", \"win\": %1").arg(move.win * 100);
+	return ret + "}";
+}
+
+QString AnalysisServer::readyLine() const
+{
+	return QString("{\"ok\": \"ready\", \"lexicon\": \"%1\"}").arg(QString::fromStdString(QUACKLE_LEXICON_PARAMETERS->lexiconName()));
+}
+
+QString AnalysisServer::errorLine(const QString &message) const
+{
+	QString escaped(message);
+	escaped.replace("\\", "\\\\").replace("\"", "\\\"");
+	return QString("{\"error\": \"%1\"}").arg(escaped);
+}
@@ -0,0 +1,113 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2006 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301  USA
+ */
+
+#ifndef QUACKLE_ANALYSISSERVER_H
+#define QUACKLE_ANALYSISSERVER_H
+
+#include <QHash>
+#include <QStringList>
+
+#include <game.h>
+#include <sim.h>
+
+class QTextStream;
+
+// Answers analysis requests, one per line, against lexicon and strategy
+// already loaded into the data manager. Requests:
+//
+//   position              GCG lines follow, ended by a line with just "."
+//   load FILE.gcg         analyze the last position of a GCG file
+//   rack LETTERS          set the rack of the player on turn
+//   kibitz [N]            N best moves by static evaluation
+//   simulate PLIES SECONDS [N]
+//                         simulate the N best static moves; repeating the
+//                         request keeps adding iterations to the same sim
+//   endgame [N]           N best moves by endgame search
+//   help
+//   quit
+//
+// A {"ok": "ready"} line is sent before the first request is read.
+// Each move is answered with a line like
+//   {"move": "8D QUACKLE", "score": 80, "equity": 82.5, "win": 51.2}
+// and each request ends with {"ok": "REQUEST", ...} or {"error": "..."}.
+class AnalysisServer
+{
+public:
+	AnalysisServer();
+	~AnalysisServer();
+
+	// serve requests from in, answering on out, until quit or end of input
+	void serve(QTextStream &in, QTextStream &out);
+
+	// Listen on a local (Unix domain) socket and serve clients one after
+	// another until one of them says quit. Returns false if the socket
+	// could not be opened.
+	bool serveSocket(const QString &socketName);
+
+	// Handle one line of input. Returns the response lines, which are
+	// empty while a position is being read in.
+	QStringList handleLine(const QString &line);
+
+	bool isDone() const { return m_done; }
+
+private:
+	struct CacheEntry
+	{
+		CacheEntry() : staticMovesLength(0), simulator(0), simulatedPlies(0), endgameLength(0) {}
+
+		Quackle::MoveList staticMoves;
+		int staticMovesLength;
+
+		Quackle::Simulator *simulator;
+		int simulatedPlies;
+
+		Quackle::MoveList endgameMoves;
+		int endgameLength;
+	};
+
+	QStringList kibitz(int nmoves);
+	QStringList simulate(int plies, int seconds, int nmoves);
+	QStringList endgame(int nmoves);
+
+	bool setGame(Quackle::Game *game, QString *error);
+	bool setRack(const QString &letters, QString *error);
+
+	// cache entry for the current position, created if needed
+	CacheEntry &currentEntry();
+	QString positionKey(const Quackle::GamePosition &position) const;
+	void clearCache();
+
+	QString moveLine(const Quackle::Move &move, bool includeWin) const;
+	QString readyLine() const;
+	QString errorLine(const QString &message) const;
+
+	Quackle::Game *m_game;
+
+	// position caches are kept for this many positions
+	static const int m_maximumCachedPositions = 64;
+	QHash<QString, CacheEntry> m_cache;
+	QStringList m_cacheOrder;
+
+	bool m_readingPosition;
+	QStringList m_positionLines;
+	bool m_done;
+};
+
+#endif
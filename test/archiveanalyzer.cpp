@@ -0,0 +1,306 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2006 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301  USA
+ */
+
+#include <QtCore>
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+#include <computerplayer.h>
+#include <datamanager.h>
+#include <game.h>
+#include <reporter.h>
+
+#include <quackleio/gcgio.h>
+#include <quackleio/util.h>
+
+#include "archiveanalyzer.h"
+
+using namespace std;
+
+ArchiveAnalyzer::ArchiveAnalyzer(Quackle::ComputerPlayer *computerPlayer, int numberOfThreads)
+	: m_computerPlayer(computerPlayer), m_dataManager(0), m_numberOfThreads(numberOfThreads), m_progressInterval(0), m_readingDone(false)
+{
+	if (m_numberOfThreads <= 0)
+		m_numberOfThreads = max(1, (int)thread::hardware_concurrency());
+
+	// enough that workers finishing one game always have the next
+	m_maximumPendingGames = 2 * m_numberOfThreads + 2;
+}
+
+void ArchiveAnalyzer::analyze(const QStringList &paths, UVOStream &out)
+{
+	m_statistics = Statistics();
+	m_readingDone = false;
+	m_dataManager = Quackle::DataManager::self();
+	m_stopwatch.start();
+
+	thread reader(&ArchiveAnalyzer::readerLoop, this, cref(paths));
+
+	vector<thread> workers;
+	for (int i = 0; i < m_numberOfThreads; ++i)
+		workers.push_back(thread(&ArchiveAnalyzer::workerLoop, this));
+
+	while (true)
+	{
+		GameJob *job;
+
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_gameDone.wait(lock, [this]() { return (!m_games.empty() && m_games.front()->remaining == 0) || (m_readingDone && m_games.empty()); });
+
+			if (m_games.empty())
+				break;
+
+			job = m_games.front();
+			m_games.pop_front();
+		}
+
+		m_roomForGame.notify_one();
+
+		writeGame(*job, out);
+
+		bool progress;
+
+		{
+			lock_guard<mutex> lock(m_mutex);
+			++m_statistics.games;
+			m_statistics.positions += job->reports.size();
+			progress = m_progressInterval > 0 && m_statistics.games % m_progressInterval == 0;
+		}
+
+		delete job->game;
+		delete job;
+
+		if (progress)
+			printStatistics("Progress");
+	}
+
+	reader.join();
+	for (auto &it : workers)
+		it.join();
+
+	m_statistics.seconds = m_stopwatch.elapsedSeconds();
+}
+
+void ArchiveAnalyzer::readerLoop(const QStringList &paths)
+{
+	Quackle::DataManagerScope scope(m_dataManager);
+
+	const int files = readGames(paths, [this](const QByteArray &text, const QString &source) { queueGame(text, source); });
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_statistics.files = files;
+		m_readingDone = true;
+	}
+
+	m_taskReady.notify_all();
+	m_gameDone.notify_all();
+}
+
+int ArchiveAnalyzer::readGames(const QStringList &paths, const function<void (const QByteArray &text, const QString &source)> &handleGame)
+{
+	int ret = 0;
+
+	for (QStringList::const_iterator it = paths.begin(); it != paths.end(); ++it)
+	{
+		QFileInfo info(*it);
+
+		if (info.isDir())
+		{
+			QDirIterator files(*it, QStringList("*.gcg"), QDir::Files, QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+			while (files.hasNext())
+				ret += readFile(files.next(), handleGame);
+		}
+		else
+			ret += readFile(*it, handleGame);
+	}
+
+	return ret;
+}
+
+bool ArchiveAnalyzer::readFile(const QString &filename, const function<void (const QByteArray &text, const QString &source)> &handleGame)
+{
+	QFile file(filename);
+
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		UVcerr << "Could not open gcg " << QuackleIO::Util::qstringToString(filename) << endl;
+		return false;
+	}
+
+	// Read line by line rather than all at once; an archive
+	// of concatenated games can be any size.
+	QByteArray text;
+	bool sawMoves = false;
+	int gameNumber = 1;
+
+	while (!file.atEnd())
+	{
+		const QByteArray line = file.readLine();
+
+		if (sawMoves && startsNewGame(line))
+		{
+			handleGame(text, QString("%1 game %2").arg(filename).arg(gameNumber++));
+			text.clear();
+			sawMoves = false;
+		}
+
+		if (line.startsWith('>'))
+			sawMoves = true;
+
+		text += line;
+	}
+
+	if (!text.trimmed().isEmpty())
+		handleGame(text, gameNumber == 1? filename : QString("%1 game %2").arg(filename).arg(gameNumber));
+
+	return true;
+}
+
+bool ArchiveAnalyzer::startsNewGame(const QByteArray &line)
+{
+	// pragmas only seen in the header of a game
+	return line.startsWith("#character-encoding") || line.startsWith("#player") || line.startsWith("#title") || line.startsWith("#description") || line.startsWith("#id") || line.startsWith("#lexicon");
+}
+
+void ArchiveAnalyzer::queueGame(const QByteArray &text, const QString &source)
+{
+	QTextStream stream(text);
+	QuackleIO::GCGIO io;
+	Quackle::Game *game = io.read(stream, QuackleIO::Logania::MaintainBoardPreparation);
+
+	if (!game || game->history().empty())
+	{
+		UVcerr << "Could not read a game from " << QuackleIO::Util::qstringToString(source) << endl;
+		delete game;
+
+		lock_guard<mutex> lock(m_mutex);
+		++m_statistics.unreadableGames;
+		return;
+	}
+
+	GameJob *job = new GameJob;
+	job->game = game;
+	job->source = source;
+	job->reports.resize(game->history().size());
+	job->remaining = game->history().size();
+
+	{
+		unique_lock<mutex> lock(m_mutex);
+		m_roomForGame.wait(lock, [this]() { return (int)m_games.size() < m_maximumPendingGames; });
+
+		m_games.push_back(job);
+		for (int i = 0; i < job->remaining; ++i)
+		{
+			PositionTask task;
+			task.job = job;
+			task.index = i;
+			m_tasks.push_back(task);
+		}
+	}
+
+	m_taskReady.notify_all();
+}
+
+void ArchiveAnalyzer::workerLoop()
+{
+	Quackle::DataManagerScope scope(m_dataManager);
+
+	// computer players keep state between positions, so each
+	// worker needs its own
+	Quackle::ComputerPlayer *player;
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+		player = m_computerPlayer->clone();
+	}
+
+	while (true)
+	{
+		PositionTask task;
+
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_taskReady.wait(lock, [this]() { return !m_tasks.empty() || m_readingDone; });
+
+			if (m_tasks.empty())
+				break;
+
+			task = m_tasks.front();
+			m_tasks.pop_front();
+		}
+
+		UVString report;
+		Quackle::Reporter::reportPosition(task.job->game->history()[task.index], player, &report);
+
+		bool gameDone;
+
+		{
+			lock_guard<mutex> lock(m_mutex);
+			task.job->reports[task.index].swap(report);
+			gameDone = --task.job->remaining == 0;
+		}
+
+		if (gameDone)
+			m_gameDone.notify_one();
+	}
+
+	delete player;
+}
+
+void ArchiveAnalyzer::writeGame(const GameJob &job, UVOStream &out)
+{
+	UVString header;
+	Quackle::Reporter::reportHeader(*job.game, &header);
+	out << MARK_UV("Source: ") << QuackleIO::Util::qstringToString(job.source) << MARK_UV('\n');
+	out << header;
+
+	for (vector<UVString>::const_iterator it = job.reports.begin(); it != job.reports.end(); ++it)
+		out << *it << MARK_UV('\n');
+
+	UVString stats;
+	Quackle::Reporter::reportGameStatistics(*job.game, &stats);
+	out << stats << endl;
+}
+
+void ArchiveAnalyzer::printStatistics(const char *label)
+{
+	Statistics statistics;
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+		statistics = m_statistics;
+	}
+
+	// still running unless analyze() has set the total time
+	if (statistics.seconds == 0)
+		statistics.seconds = m_stopwatch.elapsedSeconds();
+
+	UVcerr << label << ": " << statistics.games << " games (" << statistics.unreadableGames << " unreadable)";
+
+	// files are counted once they have all been read
+	if (statistics.files > 0)
+		UVcerr << " from " << statistics.files << " files";
+
+	UVcerr << ", " << statistics.positions << " positions in " << statistics.seconds << " s; " << statistics.positionsPerSecond() << " positions/s" << endl;
+}
@@ -0,0 +1,149 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2006 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301  USA
+ */
+
+#ifndef QUACKLE_ARCHIVEANALYZER_H
+#define QUACKLE_ARCHIVEANALYZER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <QByteArray>
+#include <QStringList>
+
+#include <clock.h>
+#include <uv.h>
+
+namespace Quackle
+{
+	class ComputerPlayer;
+	class DataManager;
+	class Game;
+}
+
+// Reports on every game in a pile of GCG files, as the report mode of
+// the test harness does for a few. Three stages run at once:
+//
+//   a reader thread walks the files and parses their games,
+//   worker threads each run their own copy of the computer player on
+//       single positions, so one long game is spread over all workers,
+//   the calling thread writes each game's report as soon as it and
+//       every game before it are done, so output is in reading order.
+//
+// The reader stays a bounded number of games ahead of the writer, so
+// memory use doesn't grow with the size of the archive.
+class ArchiveAnalyzer
+{
+public:
+	struct Statistics
+	{
+		Statistics() : files(0), games(0), unreadableGames(0), positions(0), seconds(0) {}
+
+		int files;
+		int games;
+		int unreadableGames;
+		int positions;
+		double seconds;
+
+		double positionsPerSecond() const { return seconds > 0? positions / seconds : 0; }
+	};
+
+	// Workers clone computerPlayer, which is not owned.
+	// numberOfThreads <= 0 means one worker per hardware thread.
+	ArchiveAnalyzer(Quackle::ComputerPlayer *computerPlayer, int numberOfThreads = 0);
+
+	// Each path is a directory, searched recursively for .gcg files, or
+	// a file holding one or more GCG games back to back. Games are
+	// analyzed with the data manager of the calling thread and their
+	// reports are written to out.
+	void analyze(const QStringList &paths, UVOStream &out);
+
+	// of the last analyze()
+	const Statistics &statistics() const { return m_statistics; }
+
+	// Print throughput to stderr every this many games; 0 for never.
+	void setProgressInterval(int games) { m_progressInterval = games; }
+
+	// prints statistics so far and the throughput to stderr
+	void printStatistics(const char *label);
+
+	int numberOfThreads() const { return m_numberOfThreads; }
+
+	// Calls handleGame with the text of each game in paths, as
+	// analyze() reads them, and the file it came from. Returns the
+	// number of files read.
+	static int readGames(const QStringList &paths, const std::function<void (const QByteArray &text, const QString &source)> &handleGame);
+
+private:
+	struct GameJob
+	{
+		GameJob() : game(0), remaining(0) {}
+
+		Quackle::Game *game;
+		QString source;
+		std::vector<UVString> reports;
+
+		// positions not yet reported on
+		int remaining;
+	};
+
+	struct PositionTask
+	{
+		GameJob *job;
+		int index;
+	};
+
+	void readerLoop(const QStringList &paths);
+	static bool readFile(const QString &filename, const std::function<void (const QByteArray &text, const QString &source)> &handleGame);
+
+	// parses one game's lines and queues its positions
+	void queueGame(const QByteArray &text, const QString &source);
+
+	void workerLoop();
+	void writeGame(const GameJob &job, UVOStream &out);
+
+	// whether a line read after moves starts the next game of an archive
+	static bool startsNewGame(const QByteArray &line);
+
+	Quackle::ComputerPlayer *m_computerPlayer;
+	Quackle::DataManager *m_dataManager;
+	int m_numberOfThreads;
+	int m_progressInterval;
+
+	std::mutex m_mutex;
+	std::condition_variable m_taskReady;
+	std::condition_variable m_gameDone;
+	std::condition_variable m_roomForGame;
+
+	// games read but not yet written, in reading order
+	std::deque<GameJob *> m_games;
+	std::deque<PositionTask> m_tasks;
+	bool m_readingDone;
+
+	// the reader waits while this many games are pending
+	int m_maximumPendingGames;
+
+	Statistics m_statistics;
+	Quackle::Stopwatch m_stopwatch;
+};
+
+#endif
@@ -5,6 +5,8 @@ INCLUDEPATH += . ..
 # enable/disable debug symbols
 # CONFIG += debug
 
+QT += network
+
 CONFIG += console c++14
 CONFIG -= x11
 CONFIG -= app_bundle
@@ -32,8 +34,8 @@ win32:!win32-g++ {
 }
 
 # Input
-HEADERS += testharness.h trademarkedboards.h
-SOURCES += testharness.cpp testmain.cpp trademarkedboards.cpp
+HEADERS += analysisserver.h archiveanalyzer.h testharness.h trademarkedboards.h
+SOURCES += analysisserver.cpp archiveanalyzer.cpp testharness.cpp testmain.cpp trademarkedboards.cpp
 
 
 macx-g++ {
@@ -31,17 +31,24 @@
 #include <endgameplayer.h>
 #include <game.h>
 #include <gameparameters.h>
+#include <leavetrainer.h>
 #include <lexiconparameters.h>
 #include <strategyparameters.h>
 #include <enumerator.h>
 #include <reporter.h>
+#include <sim.h>
+#include <trainingexporter.h>
 
 #include <quackleio/dictimplementation.h>
 #include <quackleio/flexiblealphabet.h>
 #include <quackleio/froggetopt.h>
+#include <quackleio/gamearchive.h>
 #include <quackleio/gcgio.h>
+#include <quackleio/simulationcoordinator.h>
 #include <quackleio/util.h>
 
+#include "analysisserver.h"
+#include "archiveanalyzer.h"
 #include "trademarkedboards.h"
 #include "testharness.h"
 
@@ -88,6 +95,24 @@ const char *usage =
 "       'randomracks' spit out random racks (forever?).\n"
 "       'leavecalc' spit out roughish values of leaves in 'leaves' file.\n"
 "       'anagram' anagrams letters supplied in --letters.\n"
+"       'server' loads once, then answers analysis requests on stdin\n"
+"                (or --socket); send 'help' for the request format.\n"
+"       'archive' reports on every game in the --archive files and\n"
+"                 directories, analyzing positions on --threads workers.\n"
+"       'pack' converts the games in the --archive files and directories\n"
+"              to a binary game archive named by --output.\n"
+"       'unpack' converts the --archive binary game archives back to\n"
+"                GCG, all concatenated in the file named by --output.\n"
+"       'export' writes training records for the candidate moves of\n"
+"                every position in the --archive games to --output;\n"
+"                candidates are simmed if --iterations is given.\n"
+"       'trainleaves' computes superleaves by rounds of --repetitions\n"
+"                     self-play games on --threads workers, and writes\n"
+"                     them to --output (default 'superleaves').\n"
+"       'distsim' simulates each --position for --iterations (default\n"
+"                 1000) of --plies on --workers worker processes.\n"
+"       'simworker' runs simulation jobs for a distsim coordinator on\n"
+"                   stdin and stdout.\n"
 "--position=game.gcg; this option can be repeated to specify positions\n"
 "                     to test.\n"
 "--lexicon=; sets the lexicon (default 'twl06').\n"
@@ -97,7 +122,26 @@ const char *usage =
 "--letters; letters to anagram.\n"
 "--build; when mode is anagram, do not require that all letters be used.\n"
 "--quiet; print nothing during selfplay games (default false).\n"
-"--repetitions=integer; the number of games for selfplay (default 1000).\n";
+"--repetitions=integer; the number of games for selfplay (default 1000),\n"
+"                       or per round of trainleaves (default 10000).\n"
+"--socket=name; when mode is server, listen on this local socket\n"
+"               instead of stdin.\n"
+"--archive=path; a .gcg file of one or more games, or a directory of\n"
+"                them; can be repeated.\n"
+"--threads=integer; workers for archive and trainleaves modes\n"
+"                   (default one per core).\n"
+"--output=file; where pack, unpack, export and trainleaves write.\n"
+"--plies=integer; plies to sim in export mode (default 2).\n"
+"--iterations=integer; sim iterations per position in export mode\n"
+"                      (default 0, for static evaluation only).\n"
+"--rounds=integer; most rounds of trainleaves mode (default 20).\n"
+"--workers=integer; worker processes in distsim mode (default one per\n"
+"                   core).\n"
+"--workercommand=command; starts a distsim worker instead of this\n"
+"                          program, e.g. 'ssh host test --mode=simworker'.\n"
+"--workertimeout=integer; seconds a distsim worker may go silent before\n"
+"                          its job is handed out again (default 300;\n"
+"                          0 waits as long as it takes).\n";
 
 void TestHarness::executeFromArguments()
 {
@@ -110,6 +154,16 @@ void TestHarness::executeFromArguments()
 	QString repString;
 	bool build;
 	QString letters;
+	QString socket;
+	QStringList archives;
+	QString threadsString;
+	QString output;
+	QString pliesString;
+	QString iterationsString;
+	QString roundsString;
+	QString workersString;
+	QString workerCommand;
+	QString workerTimeoutString;
 	bool help;
 	bool report;
 	unsigned int seed = numeric_limits<unsigned int>::max();
@@ -123,7 +177,17 @@ void TestHarness::executeFromArguments()
 	opts.addOption('s', "seed", &seedString);
 	opts.addOption('r', "repetitions", &repString);
 	opts.addOption('t', "letters", &letters);
+	opts.addOption('k', "socket", &socket);
+	opts.addOption('j', "threads", &threadsString);
+	opts.addOption('o', "output", &output);
+	opts.addOption('p', "plies", &pliesString);
+	opts.addOption('i', "iterations", &iterationsString);
+	opts.addOption('n', "rounds", &roundsString);
+	opts.addOption('w', "workers", &workersString);
+	opts.addOption('e', "workercommand", &workerCommand);
+	opts.addOption('u', "workertimeout", &workerTimeoutString);
 	opts.addRepeatableOption("position", &m_positions);
+	opts.addRepeatableOption("archive", &archives);
 
 	opts.addSwitch("report", &report);
 	opts.addSwitch("build", &build);
@@ -184,6 +248,22 @@ void TestHarness::executeFromArguments()
 		wordDump();
 	else if (mode == "bingos")
 		bingos();
+	else if (mode == "server")
+		serve(socket);
+	else if (mode == "archive")
+		analyzeArchives(archives, threadsString.isNull()? 0 : threadsString.toInt());
+	else if (mode == "pack")
+		packGames(archives, output);
+	else if (mode == "unpack")
+		unpackGames(archives, output);
+	else if (mode == "export")
+		exportTrainingData(archives, output, pliesString.isNull()? 2 : pliesString.toInt(), iterationsString.toInt());
+	else if (mode == "trainleaves")
+		trainLeaves(seed, repString.isNull()? 10000 : reps, roundsString.isNull()? 20 : roundsString.toInt(), threadsString.isNull()? 0 : threadsString.toInt(), output.isNull()? QString("superleaves") : output);
+	else if (mode == "distsim")
+		distributedSimulate(workersString.isNull()? 0 : workersString.toInt(), workerCommand, workerTimeoutString.isNull()? 300 : workerTimeoutString.toInt(), seed, pliesString.isNull()? 2 : pliesString.toInt(), iterationsString.isNull()? 1000 : iterationsString.toInt());
+	else if (mode == "simworker")
+		serveSimulations();
 }
 
 void TestHarness::startUp()
@@ -213,6 +293,7 @@ void TestHarness::startUp()
    	m_dataManager.lexiconParameters()->loadGaddag(Quackle::LexiconParameters::findDictionaryFile(QuackleIO::Util::qstringToStdString(m_lexicon + ".gaddag")));
 	UVcout << ".";
 
+	m_dataManager.lexiconParameters()->setLexiconName(QuackleIO::Util::qstringToStdString(m_lexicon));
 	m_dataManager.strategyParameters()->initialize(QuackleIO::Util::qstringToStdString(m_lexicon));
 
 	UVcout << endl;
@@ -220,6 +301,100 @@ void TestHarness::startUp()
 	m_gamesDir = QString("games_PLAYERNAME_%1").arg(QDateTime::currentDateTime().toString("dd.MM_hh.mm.ss"));
 }
 
+void TestHarness::serve(const QString &socket)
+{
+	AnalysisServer server;
+
+	if (!socket.isNull())
+	{
+		UVcout << "Listening on " << QuackleIO::Util::qstringToString(socket) << "." << endl;
+		server.serveSocket(socket);
+		return;
+	}
+
+	QTextStream in(stdin);
+	QTextStream out(stdout);
+	server.serve(in, out);
+}
+
+void TestHarness::serveSimulations()
+{
+	QuackleIO::SimulationWorker worker;
+
+	QTextStream in(stdin);
+	QTextStream out(stdout);
+	worker.serve(in, out);
+}
+
+void TestHarness::distributedSimulate(int workers, const QString &workerCommand, int workerTimeout, unsigned int seed, int plies, int iterations)
+{
+	QuackleIO::SimulationCoordinator coordinator;
+	coordinator.setWorkerTimeout(workerTimeout);
+	if (seed != numeric_limits<unsigned int>::max())
+		coordinator.setFirstSeed(seed);
+
+	// local workers are this program, loading what we did
+	QString program = QCoreApplication::applicationFilePath();
+	QStringList arguments;
+	arguments << "--mode=simworker" << QString("--lexicon=%1").arg(m_lexicon) << QString("--alphabet=%1").arg(m_alphabet);
+
+	if (!workerCommand.isNull())
+	{
+		arguments = workerCommand.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+		if (arguments.isEmpty())
+		{
+			UVcerr << "Empty worker command." << endl;
+			return;
+		}
+
+		program = arguments.takeFirst();
+	}
+
+	if (workers <= 0)
+		workers = QThread::idealThreadCount();
+
+	for (int i = 0; i < workers; ++i)
+		coordinator.addWorker(program, arguments);
+
+	UVcout << "Simulating " << m_positions.size() << " positions on " << coordinator.workerCount() << " workers." << endl;
+
+	const int candidates = 10;
+
+	for (QStringList::iterator it = m_positions.begin(); it != m_positions.end(); ++it)
+	{
+		Quackle::Game *game = createNewGame(*it);
+		if (!game)
+			continue;
+
+		if (!game->hasPositions() || game->currentPosition().gameOver())
+		{
+			UVcout << QuackleIO::Util::qstringToString(*it) << ": game is over." << endl;
+			delete game;
+			continue;
+		}
+
+		QTime time;
+		time.start();
+
+		Quackle::GamePosition position(game->currentPosition());
+		position.kibitz(candidates);
+
+		Quackle::Simulator simulator;
+		simulator.setPosition(position);
+
+		const int simulated = coordinator.simulate(*game, &simulator, plies, iterations);
+
+		UVcout << QuackleIO::Util::qstringToString(*it) << ": " << simulated << " iterations in " << time.elapsed() / 1000.0 << " seconds";
+		UVcout << " (" << coordinator.duplicatedChunks() << " chunks run twice, " << coordinator.lostWorkers() << " workers lost, " << coordinator.localChunks() << " chunks run here)" << endl;
+
+		const Quackle::MoveList moves = simulator.moves(/* prune */ true, /* by win */ true);
+		for (Quackle::MoveList::const_iterator moveIt = moves.begin(); moveIt != moves.end(); ++moveIt)
+			UVcout << (*moveIt).toString() << " score " << (*moveIt).effectiveScore() << " equity " << (*moveIt).equity << " win " << (*moveIt).win * 100 << endl;
+
+		delete game;
+	}
+}
+
 void TestHarness::testFromFile(const QString &file)
 {
 	UVcout << "Testing game from " << QuackleIO::Util::qstringToString(file) << endl;
@@ -240,7 +415,7 @@ double TestHarness::leaveSim(const Rack &R, int iterations)
 	Bag B;
 	B.removeLetters(R.tiles());
 
-	int tilesToLeave = 14 + rand() % (93 - 14);
+	int tilesToLeave = 14 + m_dataManager.randomNumber() % (93 - 14);
 
 	for (int i = 0; i < iterations; i++)
 	{
@@ -652,6 +827,170 @@ void TestHarness::testReport(bool html)
 	}
 }
 
+void TestHarness::analyzeArchives(const QStringList &paths, int threads)
+{
+	ArchiveAnalyzer analyzer(m_computerPlayerToTest, threads);
+	analyzer.setProgressInterval(100);
+
+	UVcerr << "Reporting on archives with " << m_computerPlayerToTest->name() << " on " << analyzer.numberOfThreads() << " threads." << endl;
+	analyzer.analyze(paths, UVcout);
+	analyzer.printStatistics("Done");
+}
+
+void TestHarness::packGames(const QStringList &paths, const QString &output)
+{
+	QuackleIO::GameArchiveWriter writer;
+	if (!writer.open(output))
+	{
+		UVcerr << "Could not open " << QuackleIO::Util::qstringToString(output) << " for writing" << endl;
+		return;
+	}
+
+	QTime time;
+	time.start();
+
+	QuackleIO::GCGIO io;
+	bool ok = true;
+	ArchiveAnalyzer::readGames(paths, [&](const QByteArray &text, const QString &source)
+	{
+		QTextStream stream(text);
+		Quackle::Game *game = io.read(stream, QuackleIO::Logania::BasicLoad);
+
+		if (game && game->hasPositions())
+			ok = writer.addGame(*game) && ok;
+		else
+			UVcerr << "Could not read a game from " << QuackleIO::Util::qstringToString(source) << endl;
+
+		delete game;
+	});
+
+	const int games = writer.gameCount();
+	if (!writer.close() || !ok)
+	{
+		UVcerr << "Could not write " << QuackleIO::Util::qstringToString(output) << endl;
+		return;
+	}
+
+	UVcout << "Packed " << games << " games in " << time.elapsed() / 1000.0 << " seconds." << endl;
+}
+
+void TestHarness::unpackGames(const QStringList &paths, const QString &output)
+{
+	QFile file(output);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		UVcerr << "Could not open " << QuackleIO::Util::qstringToString(output) << " for writing" << endl;
+		return;
+	}
+
+	QTime time;
+	time.start();
+
+	QTextStream out(&file);
+	QuackleIO::GCGIO io;
+	int games = 0;
+
+	for (QStringList::const_iterator it = paths.begin(); it != paths.end(); ++it)
+	{
+		QuackleIO::GameArchive archive;
+		if (!archive.load(*it))
+		{
+			UVcerr << "Could not load game archive " << QuackleIO::Util::qstringToString(*it) << endl;
+			continue;
+		}
+
+		for (int i = 0; i < archive.gameCount(); ++i, ++games)
+		{
+			Quackle::Game *game = archive.game(i).createGame(QuackleIO::Logania::BasicLoad);
+			io.write(*game, out);
+			delete game;
+		}
+	}
+
+	UVcout << "Unpacked " << games << " games in " << time.elapsed() / 1000.0 << " seconds." << endl;
+}
+
+void TestHarness::exportTrainingData(const QStringList &paths, const QString &output, int plies, int iterations)
+{
+	Quackle::TrainingExporter exporter;
+	if (!exporter.open(QuackleIO::Util::qstringToStdString(output)))
+		return;
+
+	QTime time;
+	time.start();
+
+	// the simulator exports each position as it moves on to the next
+	Quackle::Simulator simulator;
+	simulator.setTrainingExporter(&exporter);
+
+	const int candidates = 10;
+	int positions = 0;
+	QuackleIO::GCGIO io;
+
+	ArchiveAnalyzer::readGames(paths, [&](const QByteArray &text, const QString &source)
+	{
+		QTextStream stream(text);
+		Quackle::Game *game = io.read(stream, QuackleIO::Logania::MaintainBoardPreparation);
+
+		if (game && game->hasPositions())
+		{
+			for (Quackle::PositionList::const_iterator it = game->history().begin(); it != game->history().end(); ++it)
+			{
+				if ((*it).gameOver())
+					continue;
+
+				Quackle::GamePosition position(*it);
+				position.kibitz(candidates);
+
+				if (iterations > 0)
+				{
+					simulator.setPosition(position);
+					simulator.simulate(plies, iterations);
+				}
+				else
+					exporter.exportMoves(position, position.moves());
+
+				++positions;
+			}
+		}
+		else
+			UVcerr << "Could not read a game from " << QuackleIO::Util::qstringToString(source) << endl;
+
+		delete game;
+	});
+
+	simulator.setTrainingExporter(0);
+	exporter.close();
+
+	UVcout << "Exported " << exporter.recordCount() << " candidates of " << positions << " positions in " << time.elapsed() / 1000.0 << " seconds." << endl;
+}
+
+void TestHarness::trainLeaves(unsigned int seed, int games, int rounds, int threads, const QString &output)
+{
+	if (seed != numeric_limits<unsigned int>::max())
+		m_dataManager.seedRandomNumbers(seed);
+
+	Quackle::LeaveTrainer trainer(threads);
+	trainer.setGamesPerRound(games);
+
+	UVcout << "Training leaves with " << games << " games a round on " << trainer.numberOfThreads() << " threads, starting from " << m_dataManager.strategyParameters()->superleaves().size() << " superleaves." << endl;
+
+	trainer.setProgressCallback([this, &trainer, &output](const Quackle::LeaveTrainingRound &round)
+	{
+		UVcout << "Round " << round.round << ": " << round.observations << " leaves counted, " << round.leaves << " leaves valued";
+		if (round.change >= 0)
+			UVcout << ", values changed by " << round.change;
+		UVcout << " (" << round.seconds << " s)" << endl;
+
+		// keep what's trained so far, in case training is cut short
+		trainer.save(QuackleIO::Util::qstringToStdString(output));
+	});
+
+	const bool converged = trainer.train(rounds);
+
+	UVcout << (converged? "Converged" : "Stopped") << " after " << trainer.rounds().size() << " rounds; wrote " << trainer.leaves().size() << " superleaves to " << QuackleIO::Util::qstringToString(output) << "." << endl;
+}
+
 void TestHarness::selfPlayGames(unsigned int seed, unsigned int reps, bool reports, bool playability)
 {
 	if (seed != numeric_limits<unsigned int>::max()) {
@@ -729,7 +1068,7 @@ void TestHarness::selfPlayGame(unsigned int gameNumber, bool reports, bool playa
                         UVcout << word << " " << numTops << endl;
                     }
                 }
-                int toPlay = rand() % numTops;
+                int toPlay = m_dataManager.randomNumber() % numTops;
                 //UVcout << "playing move #" << toPlay << endl;
                 game.commitMove(tops[toPlay]);
             } else {
@@ -81,6 +81,37 @@ public:
 
 	void wordDump();
 
+	// Answers analysis requests on stdin, or on the local socket
+	// if one is given, until told to quit.
+	void serve(const QString &socket);
+
+	// Runs simulation jobs sent on stdin by a coordinator, answering
+	// on stdout, until told to quit.
+	void serveSimulations();
+
+	// Simulates the final position of each position file for
+	// iterations on workers worker processes, started by workerCommand
+	// or, if that is null, by running this program in simworker mode.
+	// Workers silent for workerTimeout seconds are given up on.
+	void distributedSimulate(int workers, const QString &workerCommand, int workerTimeout, unsigned int seed, int plies, int iterations);
+
+	// Reports on every game in the GCG files and directories,
+	// spreading positions over threads workers.
+	void analyzeArchives(const QStringList &paths, int threads);
+
+	// Converts the games in GCG files and directories to a binary
+	// game archive, and binary game archives to concatenated GCG.
+	void packGames(const QStringList &paths, const QString &output);
+	void unpackGames(const QStringList &paths, const QString &output);
+
+	// Writes training records for the candidates of every position of
+	// the games, simmed for iterations if that is positive.
+	void exportTrainingData(const QStringList &paths, const QString &output, int plies, int iterations);
+
+	// Computes superleaves by rounds of self-play games, writing them
+	// to output after every round.
+	void trainLeaves(unsigned int seed, int games, int rounds, int threads, const QString &output);
+
 	// Allocates and loads a game from the file.
 	Quackle::Game *createNewGame(const QString &filename);
 
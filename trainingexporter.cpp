@@ -0,0 +1,273 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "datamanager.h"
+#include "game.h"
+#include "gameparameters.h"
+#include "sim.h"
+#include "simulationcache.h"
+#include "strategyparameters.h"
+#include "trainingexporter.h"
+
+using namespace std;
+using namespace Quackle;
+
+static_assert(sizeof(TrainingRecord) == 80, "training records must stay fixed width");
+
+const char TrainingExporter::magicBytes[8] = { 'Q', 'T', 'R', 'A', 'I', 'N', 'D', 'T' };
+
+namespace
+{
+
+struct FileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t recordSize;
+};
+
+}
+
+TrainingExporter::TrainingExporter()
+	: m_isOpen(false), m_positionNumber(0), m_recordCount(0), m_closing(false)
+{
+}
+
+TrainingExporter::~TrainingExporter()
+{
+	close();
+}
+
+bool TrainingExporter::open(const string &filename, bool append)
+{
+	close();
+
+	FileHeader header;
+	memcpy(header.magic, magicBytes, sizeof(header.magic));
+	header.version = currentVersion;
+	header.recordSize = sizeof(TrainingRecord);
+
+	bool hasHeader = false;
+	uint32_t positionNumber = 0;
+	if (append)
+	{
+		ifstream existing(filename.c_str(), ios::in | ios::binary);
+		FileHeader existingHeader;
+		if (existing.read((char *)&existingHeader, sizeof(existingHeader)))
+		{
+			if (memcmp(&existingHeader, &header, sizeof(header)) != 0)
+			{
+				cerr << filename << " is not a training file of this version; not appending to it" << endl;
+				return false;
+			}
+
+			hasHeader = true;
+
+			// number positions on from the last one in the file
+			TrainingRecord last;
+			existing.seekg(0, ios::end);
+			if (existing.tellg() >= (streamoff)(sizeof(header) + sizeof(last)))
+			{
+				existing.seekg(-(streamoff)sizeof(last), ios::end);
+				if (existing.read((char *)&last, sizeof(last)))
+					positionNumber = last.positionNumber + 1;
+			}
+		}
+	}
+
+	m_file.open(filename.c_str(), ios::out | ios::binary | (hasHeader? ios::app : ios::trunc));
+	if (!m_file.is_open())
+	{
+		cerr << "Could not open " << filename << " to write training data" << endl;
+		return false;
+	}
+
+	if (!hasHeader)
+		m_file.write((const char *)&header, sizeof(header));
+
+	m_isOpen = true;
+	m_positionNumber = positionNumber;
+	m_recordCount = 0;
+	m_closing = false;
+	m_buffer.reserve(bufferSize);
+	m_writer = thread(&TrainingExporter::writerLoop, this);
+	return true;
+}
+
+void TrainingExporter::close()
+{
+	if (!m_isOpen)
+		return;
+
+	{
+		unique_lock<mutex> lock(m_mutex);
+		flushBuffer(lock);
+		m_closing = true;
+	}
+
+	m_bufferReady.notify_one();
+	m_writer.join();
+
+	m_file.close();
+	m_isOpen = false;
+}
+
+void TrainingExporter::exportMoves(const GamePosition &position, const MoveList &moves)
+{
+	if (!m_isOpen)
+		return;
+
+	const uint64_t hash = SimulationCache::positionHash(position, Rack(), false, RolloutPolicy());
+
+	vector<TrainingRecord> records;
+	records.reserve(moves.size());
+	for (MoveList::const_iterator it = moves.begin(); it != moves.end(); ++it)
+		records.push_back(record(position, hash, *it));
+
+	add(records);
+}
+
+void TrainingExporter::exportSimulation(const Simulator &simulator)
+{
+	if (!m_isOpen)
+		return;
+
+	const GamePosition &position = simulator.currentPosition();
+	const uint64_t hash = SimulationCache::positionHash(position, simulator.partialOppoRack(), simulator.ignoreOppos(), simulator.rolloutPolicy());
+
+	vector<TrainingRecord> records;
+	records.reserve(simulator.simmedMoves().size());
+	for (SimmedMoveList::const_iterator it = simulator.simmedMoves().begin(); it != simulator.simmedMoves().end(); ++it)
+	{
+		if (!(*it).includeInSimulation())
+			continue;
+
+		TrainingRecord ret = record(position, hash, (*it).move);
+		ret.iterations = (*it).residual.incorporatedValues();
+		ret.simulatedEquity = (*it).calculateEquity();
+		ret.residual = (*it).residual.averagedValue();
+
+		// a move not simulated yet keeps the static estimate
+		if ((*it).wins.hasValues())
+			ret.winPercentage = (*it).calculateWinPercentage();
+
+		records.push_back(ret);
+	}
+
+	add(records);
+}
+
+TrainingRecord TrainingExporter::record(const GamePosition &position, uint64_t positionHash, const Move &move)
+{
+	TrainingRecord ret;
+	memset(&ret, 0, sizeof(ret));
+
+	ret.positionHash = positionHash;
+	ret.staticEquity = move.equity;
+	ret.simulatedEquity = move.equity;
+
+	// Move::win isn't on one scale across players, so this is the
+	// chance of winning static equity gives, in percent like
+	// simulation results
+	ret.winPercentage = 100 * QUACKLE_STRATEGY_PARAMETERS->bogowin((int)(position.spread() + move.equity), position.bag().size() + QUACKLE_PARAMETERS->rackSize(), 0);
+
+	ret.spread = position.spread();
+	ret.score = move.score;
+	ret.bagSize = min(position.bag().size(), 255);
+	ret.action = move.action;
+	ret.horizontal = move.horizontal;
+	ret.startrow = move.startrow;
+	ret.startcol = move.startcol;
+
+	const LetterString &rack = position.currentPlayer().rack().tiles();
+	memcpy(ret.rack, rack.constData(), min((size_t)rack.length(), sizeof(ret.rack)));
+
+	const LetterString &tiles = move.tiles();
+	memcpy(ret.tiles, tiles.constData(), min((size_t)tiles.length(), sizeof(ret.tiles)));
+
+	return ret;
+}
+
+void TrainingExporter::add(const vector<TrainingRecord> &records)
+{
+	unique_lock<mutex> lock(m_mutex);
+
+	for (vector<TrainingRecord>::const_iterator it = records.begin(); it != records.end(); ++it)
+	{
+		m_buffer.push_back(*it);
+		m_buffer.back().positionNumber = m_positionNumber;
+
+		if (m_buffer.size() >= (size_t)bufferSize)
+			flushBuffer(lock);
+	}
+
+	++m_positionNumber;
+	m_recordCount += records.size();
+}
+
+void TrainingExporter::flushBuffer(unique_lock<mutex> &lock)
+{
+	if (m_buffer.empty())
+		return;
+
+	// don't let the exporting thread run arbitrarily far ahead of a slow disk
+	m_bufferWritten.wait(lock, [this]() { return m_pendingBuffers.size() < (size_t)maximumPendingBuffers; });
+
+	m_pendingBuffers.push_back(vector<TrainingRecord>());
+	m_pendingBuffers.back().swap(m_buffer);
+
+	if (!m_spareBuffers.empty())
+	{
+		m_buffer.swap(m_spareBuffers.back());
+		m_spareBuffers.pop_back();
+	}
+	else
+		m_buffer.reserve(bufferSize);
+
+	m_bufferReady.notify_one();
+}
+
+void TrainingExporter::writerLoop()
+{
+	unique_lock<mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_bufferReady.wait(lock, [this]() { return !m_pendingBuffers.empty() || m_closing; });
+
+		if (m_pendingBuffers.empty())
+			break;
+
+		vector<TrainingRecord> buffer;
+		buffer.swap(m_pendingBuffers.front());
+		m_pendingBuffers.pop_front();
+
+		lock.unlock();
+		m_file.write((const char *)&buffer[0], buffer.size() * sizeof(TrainingRecord));
+		buffer.clear();
+		lock.lock();
+
+		m_spareBuffers.push_back(vector<TrainingRecord>());
+		m_spareBuffers.back().swap(buffer);
+		m_bufferWritten.notify_all();
+	}
+}
@@ -0,0 +1,168 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_TRAININGEXPORTER_H
+#define QUACKLE_TRAININGEXPORTER_H
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "alphabetparameters.h"
+#include "move.h"
+
+using namespace std;
+
+namespace Quackle
+{
+
+class GamePosition;
+class Simulator;
+
+// One candidate move of one position. Records are fixed width and
+// stored in native byte order, so a training file can be read as an
+// array, eg. with numpy.fromfile(file, dtype, offset=16).
+struct TrainingRecord
+{
+	// SimulationCache::positionHash of the position, so candidates of a
+	// position can be grouped; positionNumber counts positions exported
+	// to the file, counting on from the last record when appending,
+	// and tells apart positions that hash alike
+	uint64_t positionHash;
+	uint32_t positionNumber;
+
+	// simulation iterations; zero for a static evaluation only
+	uint32_t iterations;
+
+	float staticEquity;
+
+	// equity and win percentage (0 to 100) by simulation, or static
+	// values if there were no iterations; the static win percentage
+	// is the evaluator's estimate for the static equity
+	float simulatedEquity;
+	float winPercentage;
+
+	// average value of the leave at the end of the simulated plies
+	float residual;
+
+	// of the player on turn over the best opponent
+	int16_t spread;
+	int16_t score;
+
+	uint8_t bagSize;
+	uint8_t action;
+	uint8_t horizontal;
+	uint8_t startrow;
+	uint8_t startcol;
+	uint8_t reserved[7];
+
+	// letters of the rack and of Move::tiles(), padded with
+	// QUACKLE_NULL_MARK
+	Letter rack[8];
+	Letter tiles[24];
+};
+
+// Writes training records to a file. Records are collected in memory and
+// written by a background thread, so exporting costs the caller about as
+// much as copying the records.
+//
+// The file starts with a 16 byte header: 8 magic bytes, then the format
+// version and the record size as native 32 bit integers.
+class TrainingExporter
+{
+public:
+	TrainingExporter();
+	~TrainingExporter();
+
+	// Opens filename for writing, closing the file open before. If
+	// append is true and the file already holds records, more are added.
+	// Returns false if the file can't be written.
+	bool open(const string &filename, bool append = false);
+
+	// writes all records exported so far and closes the file
+	void close();
+
+	bool isOpen() const;
+
+	// one record for each of moves, by static evaluation
+	void exportMoves(const GamePosition &position, const MoveList &moves);
+
+	// one record for each move included in the simulation
+	void exportSimulation(const Simulator &simulator);
+
+	// number of records exported since the file was opened
+	long recordCount() const;
+
+	// record of move in position, with static values in place of
+	// simulation results
+	static TrainingRecord record(const GamePosition &position, uint64_t positionHash, const Move &move);
+
+	static const char magicBytes[8];
+	static const uint32_t currentVersion = 1;
+
+	// records in a buffer handed to the writing thread
+	static const int bufferSize = 4096;
+
+	// buffers that may wait to be written before exporting blocks
+	static const int maximumPendingBuffers = 8;
+
+private:
+	void add(const vector<TrainingRecord> &records);
+
+	// hand the current buffer to the writing thread
+	void flushBuffer(unique_lock<mutex> &lock);
+
+	void writerLoop();
+
+	ofstream m_file;
+	bool m_isOpen;
+	uint32_t m_positionNumber;
+	long m_recordCount;
+
+	mutex m_mutex;
+	condition_variable m_bufferReady;
+	condition_variable m_bufferWritten;
+
+	vector<TrainingRecord> m_buffer;
+	deque< vector<TrainingRecord> > m_pendingBuffers;
+
+	// emptied buffers, kept to be filled again
+	vector< vector<TrainingRecord> > m_spareBuffers;
+
+	bool m_closing;
+	thread m_writer;
+};
+
+inline bool TrainingExporter::isOpen() const
+{
+	return m_isOpen;
+}
+
+inline long TrainingExporter::recordCount() const
+{
+	return m_recordCount;
+}
+
+}
+
+#endif
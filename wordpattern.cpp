@@ -0,0 +1,538 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <climits>
+
+#include "datamanager.h"
+#include "wordpattern.h"
+
+using namespace Quackle;
+
+namespace
+{
+
+// number of repetitions meaning "any number"
+const int unbounded = -1;
+
+bool isSpecial(UVChar c, WordPattern::Syntax syntax)
+{
+	switch (c)
+	{
+	case '[':
+	case ']':
+	case '*':
+	case '?':
+	case '(':
+	case ')':
+	case '|':
+	case '\\':
+	case '{':
+	case '}':
+		return true;
+
+	case '.':
+	case '+':
+	case '^':
+	case '$':
+		return syntax == WordPattern::Regex;
+	}
+
+	return false;
+}
+
+LetterBitset allLetters()
+{
+	LetterBitset ret;
+	for (Letter letter = QUACKLE_FIRST_LETTER; letter <= QUACKLE_ALPHABET_PARAMETERS->lastLetter(); ++letter)
+		ret.set(letter - QUACKLE_FIRST_LETTER);
+	return ret;
+}
+
+}
+
+WordPattern::Element::Element()
+	: optional(false), repeats(false)
+{
+}
+
+WordPattern::WordPattern()
+	: m_valid(false), m_skippableStates(0), m_repeatingStates(0), m_acceptingState(0), m_isBounded(true), m_minimumLength(0), m_maximumLength(0)
+{
+	build();
+}
+
+bool WordPattern::compile(const UVString &pattern, Syntax syntax, UVString *error)
+{
+	m_elements.clear();
+	m_valid = false;
+	build();
+
+	bool anchoredStart = syntax == Glob;
+	bool anchoredEnd = syntax == Glob;
+
+	size_t position = 0;
+	if (syntax == Regex && position < pattern.length() && pattern[position] == '^')
+	{
+		anchoredStart = true;
+		++position;
+	}
+
+	UVString problem;
+
+	while (problem.empty() && position < pattern.length())
+	{
+		const UVChar c = pattern[position];
+		LetterBitset letters;
+
+		if (syntax == Regex && c == '$' && position + 1 == pattern.length())
+		{
+			anchoredEnd = true;
+			++position;
+			break;
+		}
+		else if (syntax == Glob && c == '*')
+		{
+			addElement(allLetters(), 0, unbounded);
+			++position;
+			continue;
+		}
+		else if ((syntax == Regex && c == '.') || (syntax == Glob && c == '?'))
+		{
+			letters = allLetters();
+			++position;
+		}
+		else if (c == '[')
+		{
+			if (!parseClass(pattern, &position, &letters, &problem))
+				break;
+		}
+		else if (c == '*' || c == '+' || c == '?' || c == '{')
+		{
+			problem = MARK_UV("nothing to repeat");
+			break;
+		}
+		else if (isSpecial(c, syntax))
+		{
+			problem = MARK_UV("unsupported character ");
+			problem += c;
+			break;
+		}
+		else
+		{
+			size_t end = position;
+			while (end < pattern.length() && !isSpecial(pattern[end], syntax))
+				++end;
+
+			LetterString run;
+			if (!encodeRun(pattern.substr(position, end - position), &run, &problem))
+				break;
+
+			position = end;
+
+			// a quantifier applies to the last letter of the run only
+			for (size_t i = 0; i + 1 < run.length(); ++i)
+			{
+				LetterBitset letter;
+				letter.set(run[i] - QUACKLE_FIRST_LETTER);
+				addElement(letter, 1, 1);
+			}
+
+			letters.set(run[run.length() - 1] - QUACKLE_FIRST_LETTER);
+		}
+
+		int minimum = 1;
+		int maximum = 1;
+		if (syntax == Regex && !parseQuantifier(pattern, &position, &minimum, &maximum, &problem))
+			break;
+
+		addElement(letters, minimum, maximum);
+
+		if ((int)m_elements.size() > maximumElements)
+			problem = MARK_UV("pattern is too long");
+	}
+
+	if (problem.empty())
+	{
+		// unanchored ends may have any letters beyond them
+		Element anyLetters;
+		anyLetters.letters = allLetters();
+		anyLetters.optional = true;
+		anyLetters.repeats = true;
+
+		if (!anchoredStart)
+			m_elements.insert(m_elements.begin(), anyLetters);
+		if (!anchoredEnd)
+			m_elements.push_back(anyLetters);
+
+		if ((int)m_elements.size() > maximumElements)
+			problem = MARK_UV("pattern is too long");
+	}
+
+	if (!problem.empty())
+	{
+		m_elements.clear();
+		build();
+
+		if (error)
+			*error = problem;
+		return false;
+	}
+
+	m_valid = true;
+	build();
+	return true;
+}
+
+bool WordPattern::encodeRun(const UVString &run, LetterString *letters, UVString *error) const
+{
+	UVString leftover;
+	*letters = String::clearBlankness(QUACKLE_ALPHABET_PARAMETERS->encode(run, &leftover));
+
+	if (!leftover.empty() || letters->empty())
+	{
+		*error = MARK_UV("unknown letter ");
+		*error += leftover.empty()? run : leftover;
+		return false;
+	}
+
+	for (size_t i = 0; i < letters->length(); ++i)
+	{
+		if (!QUACKLE_ALPHABET_PARAMETERS->isPlainLetter((*letters)[i]))
+		{
+			*error = MARK_UV("unknown letter in ");
+			*error += run;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool WordPattern::parseClass(const UVString &pattern, size_t *position, LetterBitset *letters, UVString *error) const
+{
+	// skip the [
+	size_t end = *position + 1;
+
+	bool negated = false;
+	if (end < pattern.length() && pattern[end] == '^')
+	{
+		negated = true;
+		++end;
+	}
+
+	const size_t start = end;
+	while (end < pattern.length() && pattern[end] != ']')
+		++end;
+
+	if (end == pattern.length())
+	{
+		*error = MARK_UV("missing ]");
+		return false;
+	}
+
+	const UVString contents = pattern.substr(start, end - start);
+	*position = end + 1;
+
+	if (contents.empty())
+	{
+		*error = MARK_UV("empty letter class");
+		return false;
+	}
+
+	// contents is runs of letters separated by -, which stands
+	// for the letters between the letters on either side
+	LetterBitset ret;
+	Letter rangeStart = QUACKLE_NULL_MARK;
+	size_t runStart = 0;
+	while (runStart <= contents.length())
+	{
+		size_t runEnd = contents.find('-', runStart);
+		if (runEnd == UVString::npos)
+			runEnd = contents.length();
+
+		LetterString run;
+		if (!encodeRun(contents.substr(runStart, runEnd - runStart), &run, error))
+		{
+			if (runEnd > runStart)
+				return false;
+
+			*error = MARK_UV("bad letter range in [") + contents + MARK_UV("]");
+			return false;
+		}
+
+		if (rangeStart != QUACKLE_NULL_MARK)
+		{
+			if (run[0] < rangeStart)
+			{
+				*error = MARK_UV("bad letter range in [") + contents + MARK_UV("]");
+				return false;
+			}
+
+			for (Letter letter = rangeStart; letter < run[0]; ++letter)
+				ret.set(letter - QUACKLE_FIRST_LETTER);
+		}
+
+		for (size_t i = 0; i < run.length(); ++i)
+			ret.set(run[i] - QUACKLE_FIRST_LETTER);
+
+		rangeStart = run[run.length() - 1];
+		runStart = runEnd + 1;
+	}
+
+	*letters = negated? allLetters() & ~ret : ret;
+	return true;
+}
+
+bool WordPattern::parseQuantifier(const UVString &pattern, size_t *position, int *minimum, int *maximum, UVString *error) const
+{
+	*minimum = 1;
+	*maximum = 1;
+
+	if (*position >= pattern.length())
+		return true;
+
+	switch (pattern[*position])
+	{
+	case '*':
+		*minimum = 0;
+		*maximum = unbounded;
+		++*position;
+		return true;
+
+	case '+':
+		*maximum = unbounded;
+		++*position;
+		return true;
+
+	case '?':
+		*minimum = 0;
+		++*position;
+		return true;
+
+	case '{':
+		break;
+
+	default:
+		return true;
+	}
+
+	size_t end = *position + 1;
+	int numbers[2] = { 0, 0 };
+	bool hasNumber[2] = { false, false };
+	bool hasComma = false;
+
+	for (; end < pattern.length() && pattern[end] != '}'; ++end)
+	{
+		const UVChar c = pattern[end];
+		const int which = hasComma? 1 : 0;
+
+		if (c >= '0' && c <= '9')
+		{
+			numbers[which] = min(numbers[which] * 10 + (c - '0'), maximumElements + 1);
+			hasNumber[which] = true;
+		}
+		else if (c == ',' && !hasComma)
+			hasComma = true;
+		else
+			break;
+	}
+
+	if (end == pattern.length() || pattern[end] != '}' || !hasNumber[0])
+	{
+		*error = MARK_UV("bad repetition count");
+		return false;
+	}
+
+	*position = end + 1;
+	*minimum = numbers[0];
+
+	if (!hasComma)
+		*maximum = numbers[0];
+	else if (!hasNumber[1])
+		*maximum = unbounded;
+	else
+		*maximum = numbers[1];
+
+	if (*maximum != unbounded && *maximum < *minimum)
+	{
+		*error = MARK_UV("bad repetition count");
+		return false;
+	}
+
+	if (*minimum > maximumElements || *maximum > maximumElements)
+	{
+		*error = MARK_UV("pattern is too long");
+		return false;
+	}
+
+	return true;
+}
+
+void WordPattern::addElement(const LetterBitset &letters, int minimum, int maximum)
+{
+	Element element;
+	element.letters = letters;
+
+	for (int i = 0; i < minimum; ++i)
+		m_elements.push_back(element);
+
+	if (maximum == unbounded)
+	{
+		element.optional = true;
+		element.repeats = true;
+		m_elements.push_back(element);
+		return;
+	}
+
+	element.optional = true;
+	for (int i = minimum; i < maximum; ++i)
+		m_elements.push_back(element);
+}
+
+void WordPattern::build()
+{
+	// state i is "about to match element i"; the state past the
+	// last element accepts
+	const int numberOfElements = m_elements.size();
+
+	for (int letter = 0; letter < QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE; ++letter)
+		m_letterStates[letter] = 0;
+
+	m_skippableStates = 0;
+	m_repeatingStates = 0;
+	m_isBounded = true;
+	m_lettersToAccept.assign(numberOfElements + 1, 0);
+
+	for (int i = numberOfElements - 1; i >= 0; --i)
+	{
+		const Element &element = m_elements[i];
+		const StateSet state = (StateSet)1 << i;
+
+		for (int letter = QUACKLE_FIRST_LETTER; letter < QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE; ++letter)
+			if (element.letters.test(letter - QUACKLE_FIRST_LETTER))
+				m_letterStates[letter] |= state;
+
+		if (element.optional)
+			m_skippableStates |= state;
+		if (element.repeats)
+		{
+			m_repeatingStates |= state;
+			m_isBounded = false;
+		}
+
+		m_lettersToAccept[i] = m_lettersToAccept[i + 1] + (element.optional? 0 : 1);
+	}
+
+	m_acceptingState = m_valid? (StateSet)1 << numberOfElements : 0;
+}
+
+WordPattern::StateSet WordPattern::closure(StateSet states) const
+{
+	while (true)
+	{
+		const StateSet next = states | ((states & m_skippableStates) << 1);
+		if (next == states)
+			return states;
+		states = next;
+	}
+}
+
+WordPattern::StateSet WordPattern::initialStates() const
+{
+	return m_valid? closure(1) : 0;
+}
+
+WordPattern::StateSet WordPattern::step(StateSet states, Letter letter) const
+{
+	if (letter < QUACKLE_FIRST_LETTER || letter >= QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE)
+		return 0;
+
+	const StateSet matched = states & m_letterStates[(int)letter];
+	return closure(((matched & ~m_repeatingStates) << 1) | (matched & m_repeatingStates));
+}
+
+int WordPattern::lettersToAccept(StateSet states) const
+{
+	int ret = INT_MAX;
+	for (size_t i = 0; i < m_lettersToAccept.size(); ++i)
+		if (states & ((StateSet)1 << i))
+			ret = min(ret, m_lettersToAccept[i]);
+
+	return ret;
+}
+
+void WordPattern::setLengthRange(int minimumLength, int maximumLength)
+{
+	m_minimumLength = max(0, minimumLength);
+	m_maximumLength = max(0, maximumLength);
+}
+
+int WordPattern::maximumLength() const
+{
+	int ret = m_maximumLength;
+
+	if (m_isBounded)
+	{
+		// each element matches at most one letter
+		const int patternLength = m_elements.size();
+		ret = ret == 0? patternLength : min(ret, patternLength);
+	}
+
+	if (hasRack())
+		ret = ret == 0? (int)m_rack.length() : min(ret, (int)m_rack.length());
+
+	return ret;
+}
+
+void WordPattern::setRack(const LetterString &rack)
+{
+	m_rack = String::clearBlankness(rack);
+}
+
+bool WordPattern::matches(const LetterString &word) const
+{
+	const LetterString plainWord = String::clearBlankness(word);
+	const int length = plainWord.length();
+	const int longest = maximumLength();
+
+	if (length < m_minimumLength || (longest != 0 && length > longest))
+		return false;
+
+	if (hasRack())
+	{
+		char counts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
+		String::counts(m_rack, counts);
+
+		for (int i = 0; i < length; ++i)
+		{
+			if (counts[(int)plainWord[i]] > 0)
+				counts[(int)plainWord[i]]--;
+			else if (counts[QUACKLE_BLANK_MARK] > 0)
+				counts[QUACKLE_BLANK_MARK]--;
+			else
+				return false;
+		}
+	}
+
+	StateSet states = initialStates();
+	for (int i = 0; i < length && states != 0; ++i)
+		states = step(states, plainWord[i]);
+
+	return accepts(states);
+}
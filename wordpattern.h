@@ -0,0 +1,164 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2014 Jason Katz-Brown and John O'Laughlin.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_WORDPATTERN_H
+#define QUACKLE_WORDPATTERN_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "alphabetparameters.h"
+#include "board.h"
+
+using namespace std;
+
+namespace Quackle
+{
+
+// A word pattern compiled to a small automaton that can be stepped one
+// letter at a time, so a lexicon walk can give up on a prefix as soon
+// as no word starting with it can match. See Generator::matchingWords.
+//
+// Two syntaxes are understood, both in user-visible letters and
+// case-insensitive:
+//
+//   Regex   a restricted regular expression that matches anywhere in
+//           the word unless anchored with ^ and $. Letters, . for any
+//           letter, classes like [AEIOU], [^AEIOU] and [A-E], each
+//           optionally followed by *, +, ?, {m}, {m,} or {m,n}.
+//           Groups, alternation and escapes are not supported.
+//   Glob    always matches the whole word. ? is any letter, * is any
+//           run of letters, and classes are as in Regex.
+//
+// Words can also be limited to a range of lengths and to the letters
+// of a rack, in which blanks stand for any letter.
+class WordPattern
+{
+public:
+	enum Syntax { Regex, Glob };
+
+	// one bit per automaton state
+	typedef uint64_t StateSet;
+
+	WordPattern();
+
+	// Compiles pattern, replacing any earlier pattern. Returns false and
+	// sets error, if given, if the pattern can't be compiled, in which
+	// case the pattern matches nothing.
+	bool compile(const UVString &pattern, Syntax syntax = Regex, UVString *error = 0);
+	bool isValid() const;
+
+	// length bounds; zero means no bound
+	void setLengthRange(int minimumLength, int maximumLength);
+	int minimumLength() const;
+
+	// longest word the pattern and length bounds allow,
+	// or zero if there is no limit
+	int maximumLength() const;
+
+	// Words must be made up of letters of rack, blanks standing for any
+	// letter. An empty rack, the default, allows any letters.
+	void setRack(const LetterString &rack);
+	const LetterString &rack() const;
+	bool hasRack() const;
+
+	// states before any letters are read
+	StateSet initialStates() const;
+
+	// states after reading letter from states; an empty set means
+	// no word continuing this way can match
+	StateSet step(StateSet states, Letter letter) const;
+
+	// whether a word read to states matches, length bounds aside
+	bool accepts(StateSet states) const;
+
+	// fewest more letters that could take states to a match
+	int lettersToAccept(StateSet states) const;
+
+	// whether word matches, rack and length bounds included
+	bool matches(const LetterString &word) const;
+
+	// the largest number of pattern elements compile accepts
+	static const int maximumElements = 62;
+
+private:
+	struct Element
+	{
+		Element();
+
+		// indexed by letter - QUACKLE_FIRST_LETTER
+		LetterBitset letters;
+
+		// may be skipped
+		bool optional;
+
+		// may match any number of times
+		bool repeats;
+	};
+
+	bool parseClass(const UVString &pattern, size_t *position, LetterBitset *letters, UVString *error) const;
+	bool encodeRun(const UVString &run, LetterString *letters, UVString *error) const;
+	bool parseQuantifier(const UVString &pattern, size_t *position, int *minimum, int *maximum, UVString *error) const;
+	void addElement(const LetterBitset &letters, int minimum, int maximum);
+	void build();
+	StateSet closure(StateSet states) const;
+
+	vector<Element> m_elements;
+	bool m_valid;
+
+	// built from m_elements
+	StateSet m_letterStates[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
+	StateSet m_skippableStates;
+	StateSet m_repeatingStates;
+	StateSet m_acceptingState;
+	vector<int> m_lettersToAccept;
+	bool m_isBounded;
+
+	int m_minimumLength;
+	int m_maximumLength;
+	LetterString m_rack;
+};
+
+inline bool WordPattern::isValid() const
+{
+	return m_valid;
+}
+
+inline int WordPattern::minimumLength() const
+{
+	return m_minimumLength;
+}
+
+inline const LetterString &WordPattern::rack() const
+{
+	return m_rack;
+}
+
+inline bool WordPattern::hasRack() const
+{
+	return !m_rack.empty();
+}
+
+inline bool WordPattern::accepts(StateSet states) const
+{
+	return (states & m_acceptingState) != 0;
+}
+
+}
+
+#endif